@@ -93,7 +93,7 @@ void* _darray_insert_at(void* array, u64 index, const void* value_ptr)
     }
     u64 addr = (u64)array;
     addr += index * stride;
-    dcopy_memory((void*)(addr + stride), (void*)addr, (length - index) * stride);
+    dmove_memory((void*)(addr + stride), (void*)addr, (length - index) * stride);
     dcopy_memory((void*)addr, value_ptr, stride);
     darray_length_set(array, length + 1);
     return array;
@@ -107,7 +107,7 @@ void* _darray_pop_at(void* array, u64 index, void* dest)
     u64 addr = (u64)array;
     addr += index * stride;
     dcopy_memory(dest, (void*)addr, stride);
-    dcopy_memory((void*)addr, (void*)(addr + stride), (length - index - 1) * stride);
+    dmove_memory((void*)addr, (void*)(addr + stride), (length - index - 1) * stride);
     darray_length_set(array, length - 1);
     return array;
 }
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include "mpsc_queue.h"
+
+#include "core/dmemory.h"
+#include "core/logger.h"
+#include "platform/atomic.h"
+
+static u64* cell_sequence(mpsc_queue* queue, u64 position)
+{
+    return (u64*)(queue->cells + (position & queue->mask) * queue->cell_size);
+}
+
+b8 mpsc_queue_create(u64 capacity, u64 stride, mpsc_queue* out_queue)
+{
+    if(!out_queue || capacity == 0 || stride == 0)
+    {
+        DERROR("mpsc_queue_create requires a non-zero capacity and stride.");
+        return false;
+    }
+
+    u64 rounded = 1;
+    while(rounded < capacity)
+    {
+        rounded <<= 1;
+    }
+
+    dzero_memory(out_queue, sizeof(mpsc_queue));
+    out_queue->capacity = rounded;
+    out_queue->mask = rounded - 1;
+    out_queue->stride = stride;
+    out_queue->cell_size = sizeof(u64) + ((stride + 7) & ~(u64)7);
+    out_queue->cells = dallocate(out_queue->cell_size * rounded, MEMORY_TAG_RING_QUEUE);
+
+    for(u64 i = 0; i < rounded; i++)
+    {
+        *cell_sequence(out_queue, i) = i;
+    }
+    out_queue->tail = 0;
+    out_queue->head = 0;
+    return true;
+}
+
+void mpsc_queue_destroy(mpsc_queue* queue)
+{
+    if(queue && queue->cells)
+    {
+        dfree(queue->cells, queue->cell_size * queue->capacity, MEMORY_TAG_RING_QUEUE);
+        dzero_memory(queue, sizeof(mpsc_queue));
+    }
+}
+
+b8 mpsc_queue_push(mpsc_queue* queue, const void* value)
+{
+    u64 position = datomic_load_u64(&queue->tail, DATOMIC_RELAXED);
+    u64* sequence;
+    for(;;)
+    {
+        sequence = cell_sequence(queue, position);
+        u64 seq = datomic_load_u64(sequence, DATOMIC_ACQUIRE);
+        i64 diff = (i64)seq - (i64)position;
+        if(diff == 0)
+        {
+            // The cell is free; try to claim it. On failure position is reloaded.
+            if(datomic_compare_exchange_weak_u64(&queue->tail, &position, position + 1, DATOMIC_RELAXED))
+            {
+                break;
+            }
+        }
+        else if(diff < 0)
+        {
+            // The consumer has not freed this cell yet: full.
+            return false;
+        }
+        else
+        {
+            // Another producer claimed it first.
+            position = datomic_load_u64(&queue->tail, DATOMIC_RELAXED);
+        }
+    }
+
+    dcopy_memory(sequence + 1, value, queue->stride);
+    // Publish to the consumer.
+    datomic_store_u64(sequence, position + 1, DATOMIC_RELEASE);
+    return true;
+}
+
+b8 mpsc_queue_pop(mpsc_queue* queue, void* out_value)
+{
+    u64 position = queue->head;
+    u64* sequence = cell_sequence(queue, position);
+    u64 seq = datomic_load_u64(sequence, DATOMIC_ACQUIRE);
+    if(seq != position + 1)
+    {
+        // Empty, or the producer of this cell has not finished writing.
+        return false;
+    }
+
+    dcopy_memory(out_value, sequence + 1, queue->stride);
+    // Hand the cell back to producers for the next lap.
+    datomic_store_u64(sequence, position + queue->capacity, DATOMIC_RELEASE);
+    queue->head = position + 1;
+    return true;
+}
+
+u64 mpsc_queue_claimed(mpsc_queue* queue)
+{
+    return datomic_load_u64(&queue->tail, DATOMIC_ACQUIRE);
+}
+
+u64 mpsc_queue_consumed(mpsc_queue* queue)
+{
+    return queue->head;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+Bounded, lock-free multi-producer single-consumer queue of fixed-size elements.
+Any thread may push; only one thread (the owner) may pop.
+
+Memory layout
+Each cell holds a u64 sequence number followed by the element, padded to 8 bytes.
+A cell is free for the producer claiming position pos when sequence == pos, and
+holds a published element for the consumer when sequence == pos + 1.
+*/
+typedef struct mpsc_queue
+{
+    u64 capacity;
+    u64 mask;
+    u64 stride;
+    u64 cell_size;
+    u8* cells;
+
+    // Keep the producer and consumer cursors on separate cache lines.
+    u8 pad0[64];
+    // Next position to be claimed by a producer. Atomic.
+    u64 tail;
+    u8 pad1[64];
+    // Next position to be read by the consumer. Only touched by the consumer.
+    u64 head;
+} mpsc_queue;
+
+/**
+ * @brief Creates a queue.
+ *
+ * @param capacity The maximum number of elements. Rounded up to a power of 2.
+ * @param stride The size of each element in bytes.
+ * @param out_queue A pointer to the queue to be initialized.
+ * @return True if successful; otherwise false.
+ */
+DAPI b8 mpsc_queue_create(u64 capacity, u64 stride, mpsc_queue* out_queue);
+
+/**
+ * @brief Destroys the queue and frees its memory. No other thread may be using it.
+ */
+DAPI void mpsc_queue_destroy(mpsc_queue* queue);
+
+/**
+ * @brief Copies stride bytes from value into the queue. Safe to call from any thread.
+ *
+ * @return True if pushed; false if the queue is full.
+ */
+DAPI b8 mpsc_queue_push(mpsc_queue* queue, const void* value);
+
+/**
+ * @brief Copies the oldest published element into out_value and removes it.
+ * Must only be called from the consumer thread.
+ *
+ * @return True if an element was popped; false if the queue is empty.
+ */
+DAPI b8 mpsc_queue_pop(mpsc_queue* queue, void* out_value);
+
+/**
+ * @brief The number of positions claimed by producers so far. Positions below this value
+ * are either published or about to be; the consumer can use it to bound a drain.
+ */
+DAPI u64 mpsc_queue_claimed(mpsc_queue* queue);
+
+/**
+ * @brief The number of elements popped by the consumer so far.
+ */
+DAPI u64 mpsc_queue_consumed(mpsc_queue* queue);
@@ -6,11 +6,20 @@
 #include "core/event.h"
 #include "core/input.h"
 #include "core/clock.h"
+#include "core/frame_pacer.h"
+#include "core/job_system.h"
+#include "core/fiber_scheduler.h"
+#include "core/game_module.h"
+#include "platform/async_io.h"
+#include "platform/thread.h"
 
 #include "memory/linear_allocator.h"
 
 #include "renderer/renderer_frontend.h"
 
+// Longest time a suspended application blocks waiting for OS messages.
+#define APPLICATION_SUSPENDED_WAIT_MS 100
+
 /*
  * 
  */
@@ -22,6 +31,9 @@ typedef struct application_state{
     i16 height;
     clock clock;
     f64 last_time;
+    frame_pacer pacer;
+    b8 game_module_loaded;
+    game_module game_module;
     linear_allocator systems_allocator;
 
     u64 event_system_memory_requirement;
@@ -36,6 +48,15 @@ typedef struct application_state{
     u64 input_system_memory_requirement;
     void* input_system_state;
 
+    u64 job_system_memory_requirement;
+    void* job_system_state;
+
+    u64 fiber_scheduler_memory_requirement;
+    void* fiber_scheduler_state;
+
+    u64 async_io_memory_requirement;
+    void* async_io_state;
+
     u64 platform_system_memory_requirement;
     void* platform_system_state;
 
@@ -45,9 +66,17 @@ typedef struct application_state{
 
 static application_state *app_state;
 
+// The app's part of a frame, passed to application_update_and_render.
+typedef struct application_frame{
+    app* app_instance;
+    f32 delta_time;
+    b8 succeeded;
+}application_frame;
+
 b8 application_on_evnet(u16 code, void* sender, void* listener, event_context data);
 b8 application_on_key(u16 code, void* sender, void* listener, event_context data);
 b8 application_on_resize(u16 code, void* sender, void* listener, event_context data);
+static void application_update_and_render(void* params);
 
 b8 application_create(app* app_instance)
 {
@@ -62,6 +91,7 @@ b8 application_create(app* app_instance)
     app_state->app_instance = app_instance;
     app_state->is_running = false;
     app_state->is_suspended = false;
+    app_state->game_module_loaded = false;
 
     u64 system_allocator_total_size = 64 * 1024 * 1024; // 64MB
     linear_allocator_create(system_allocator_total_size, 0, &app_state->systems_allocator);
@@ -91,6 +121,61 @@ b8 application_create(app* app_instance)
     input_system_initialize(&app_state->input_system_memory_requirement, 0);
     app_state->input_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->input_system_memory_requirement);
     input_system_initialize(&app_state->input_system_memory_requirement, app_state->input_system_state);
+    if(app_instance->app_config.input_replay_path)
+    {
+        input_replay_start(app_instance->app_config.input_replay_path);
+    }
+    if(app_instance->app_config.input_record_path)
+    {
+        input_record_start(app_instance->app_config.input_record_path);
+    }
+
+    // The job system and fiber scheduler split the threads between them rather than each
+    // starting one per processor.
+    u32 job_thread_count = app_instance->app_config.job_thread_count;
+    u32 fiber_thread_count = 0;
+    if(app_instance->app_config.use_fiber_scheduler)
+    {
+        u32 thread_count = job_thread_count;
+        if(thread_count == 0)
+        {
+            u32 processor_count = platform_get_processor_count();
+            thread_count = processor_count > 1 ? processor_count - 1 : 1;
+        }
+        job_thread_count = thread_count > 1 ? thread_count / 2 : 1;
+        fiber_thread_count = thread_count > job_thread_count ? thread_count - job_thread_count : 1;
+    }
+
+    // Initialize job subsystem
+    job_system_initialize(&app_state->job_system_memory_requirement, 0, job_thread_count);
+    app_state->job_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->job_system_memory_requirement);
+    if(!job_system_initialize(&app_state->job_system_memory_requirement, app_state->job_system_state, job_thread_count))
+    {
+        DERROR("Failed to initialize job system; shutting down.");
+        return false;
+    }
+
+    // Initialize fiber scheduler
+    app_state->fiber_scheduler_state = 0;
+    if(app_instance->app_config.use_fiber_scheduler)
+    {
+        fiber_scheduler_initialize(&app_state->fiber_scheduler_memory_requirement, 0, fiber_thread_count, 0);
+        app_state->fiber_scheduler_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->fiber_scheduler_memory_requirement);
+        if(!fiber_scheduler_initialize(&app_state->fiber_scheduler_memory_requirement, app_state->fiber_scheduler_state, fiber_thread_count, 0))
+        {
+            DERROR("Failed to initialize fiber scheduler; shutting down.");
+            return false;
+        }
+    }
+
+    // Initialize async I/O
+    async_io_initialize(&app_state->async_io_memory_requirement, 0, true);
+    app_state->async_io_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->async_io_memory_requirement);
+    if(!async_io_initialize(&app_state->async_io_memory_requirement, app_state->async_io_state, true))
+    {
+        DERROR("Failed to initialize async I/O; shutting down.");
+        return false;
+    }
 
     // Register the specific event
     event_register(EVENT_CODE_APPLICATION_QUIT, 0, application_on_evnet);
@@ -99,7 +184,7 @@ b8 application_create(app* app_instance)
     event_register(EVENT_CODE_RESIZED, 0, application_on_resize);
 
     // Platform
-    platform_system_startup(&app_state->platform_system_memory_requirement, 0, 0, 0, 0, 0, 0);
+    platform_system_startup(&app_state->platform_system_memory_requirement, 0, 0, 0, 0, 0, 0, false);
     app_state->platform_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->platform_system_memory_requirement);
     if(!platform_system_startup(
         &app_state->platform_system_memory_requirement,
@@ -108,7 +193,8 @@ b8 application_create(app* app_instance)
         app_instance->app_config.start_pos_x, 
         app_instance->app_config.start_pos_y, 
         app_instance->app_config.start_width, 
-        app_instance->app_config.start_height))
+        app_instance->app_config.start_height,
+        app_instance->app_config.headless))
     {
         return false;
     }
@@ -122,6 +208,17 @@ b8 application_create(app* app_instance)
         return false;
     }
 
+    // Load the app callbacks from the game library, if there is one
+    if(app_instance->app_config.game_library_path)
+    {
+        if(!game_module_load(&app_state->game_module, app_instance->app_config.game_library_path, app_instance))
+        {
+            DFATAL("Failed to load game library.");
+            return false;
+        }
+        app_state->game_module_loaded = true;
+    }
+
     // Initialize the app
     if (!app_state->app_instance->initialize(app_state->app_instance))
     {
@@ -143,9 +240,7 @@ b8 application_run()
     clock_start(&app_state->clock);
     clock_update(&app_state->clock);
     app_state->last_time = app_state->clock.elapsed;
-    f64 running_time = 0.0;
-    u8 frame_count = 0;
-    f64 target_frame_seconds = 1.0f / 60.0;
+    frame_pacer_create(&app_state->pacer, app_state->app_instance->app_config.target_frame_rate);
 
     // the application is going to continuously be in this function for the rest of its life until the user actually choose to quit  
     while(app_state->is_running)
@@ -155,23 +250,59 @@ b8 application_run()
             app_state->is_running = false;
         }
 
+        // Feed this frame's recorded input, in place of the input from the message pump.
+        b8 replaying = input_replay_active();
+        if(replaying && !input_replay_update())
+        {
+            event_context data = {};
+            event_post(EVENT_CODE_APPLICATION_QUIT, 0, data);
+        }
+
+        // Deliver events posted since last frame, including those from the message pump.
+        event_dispatch_posted();
+
+        // Run the completion callbacks of jobs finished since last frame.
+        job_system_update();
+        // And those of file reads.
+        async_io_update();
+
         if(!app_state->is_suspended)
         {
+            // Between frames, nothing from the game library is on the stack.
+            if(app_state->game_module_loaded)
+            {
+                game_module_reload_if_changed(&app_state->game_module, app_state->app_instance);
+            }
+
             clock_update(&app_state->clock);
             f64 current_time = app_state->clock.elapsed;
             f64 delta_time = current_time - app_state->last_time;
-            f64 frame_start_time = platform_get_absolute_time();
-
-            if(!app_state->app_instance->update(app_state->app_instance, (f32)delta_time))
+            if(replaying)
             {
-                DFATAL("App update failed, shutting down...");
-                app_state->is_running = false;
-                break;
+                // Replays run with a fixed step so that runs are comparable.
+                f32 replay_delta_time = app_state->app_instance->app_config.replay_delta_time;
+                delta_time = replay_delta_time > 0.0f ? replay_delta_time : 1.0 / 60.0;
             }
 
-            if (!app_state->app_instance->render(app_state->app_instance, (f32)delta_time))
+            application_frame frame;
+            frame.app_instance = app_state->app_instance;
+            frame.delta_time = (f32)delta_time;
+            frame.succeeded = false;
+            if(fiber_scheduler_running())
+            {
+                // Run on a fiber, so the app can fiber_wait on its own tasks. It stays on the main
+                // thread, where the job system and async I/O expect it.
+                fiber_task task;
+                task.entry = application_update_and_render;
+                task.params = &frame;
+                fiber_task_run(&task);
+            }
+            else
+            {
+                application_update_and_render(&frame);
+            }
+            if(!frame.succeeded)
             {
-                DFATAL("App render failed, shutting down...");
                 app_state->is_running = false;
                 break;
             }
@@ -181,22 +312,8 @@ b8 application_run()
             packet.delta_time = delta_time;
             renderer_draw_frame(&packet);
 
-            f64 frame_end_time = platform_get_absolute_time();
-            f64 frame_elapsed_time = frame_end_time - frame_start_time;
-            running_time += frame_elapsed_time;
-            f64 frame_remaining_time = target_frame_seconds - frame_elapsed_time;
-            if(frame_remaining_time > 0.0)
-            {
-                u64 remaining_ms = (u64)frame_remaining_time * 1000;
-                // If there is time left, give it back to the OS.
-                b8 limit_frames = false;
-                if(remaining_ms > 0 && limit_frames)
-                {
-                    platform_sleep(remaining_ms);
-                }
-
-                frame_count++;
-            }
+            // Hold the frame to the target rate, giving the spare time back to the OS.
+            frame_pacer_wait(&app_state->pacer);
 
             // NOTE: Input update/state copying should always be handled
             // after any input should be recorded; I.E. before this line.
@@ -204,9 +321,26 @@ b8 application_run()
             // this frame ends.
             input_update(delta_time);
 
+            // Format any binary log records deferred during this frame.
+            log_flush();
+
+            // Publish this frame's event profiling samples, if enabled.
+            event_profile_frame_end();
+
             // Update last time
             app_state->last_time = current_time;
         }
+        else
+        {
+            // Nothing to draw: sleep until the OS has messages (e.g. the window being restored).
+            // The timeout keeps events posted from other threads flowing.
+            platform_wait_for_events(APPLICATION_SUSPENDED_WAIT_MS);
+
+            // Don't count the time spent suspended towards the next frame.
+            clock_update(&app_state->clock);
+            app_state->last_time = app_state->clock.elapsed;
+            frame_pacer_reset(&app_state->pacer);
+        }
     }
 
     app_state->is_running = false;
@@ -216,7 +350,18 @@ b8 application_run()
     event_unregister(EVENT_CODE_KEY_PRESSED, 0, application_on_key);
     event_unregister(EVENT_CODE_KEY_RELEASED, 0, application_on_key);
     event_unregister(EVENT_CODE_RESIZED, 0, application_on_resize);
-    input_system_shutdown();
+    async_io_shutdown(app_state->async_io_state);
+    if(app_state->fiber_scheduler_state)
+    {
+        fiber_scheduler_shutdown(app_state->fiber_scheduler_state);
+    }
+    job_system_shutdown(app_state->job_system_state);
+    if(app_state->game_module_loaded)
+    {
+        game_module_unload(&app_state->game_module);
+    }
+
+    input_system_shutdown(app_state->input_system_state);
 
     renderer_system_shutdown(app_state->renderer_system_state);
 
@@ -224,11 +369,30 @@ b8 application_run()
 
     memory_system_shutdown(app_state->memory_system_state);
 
+    shutdown_logging(app_state->logging_system_state);
+
     event_system_shutdown();
 
     return true;
 }
 
+static void application_update_and_render(void* params)
+{
+    application_frame* frame = params;
+    if(!frame->app_instance->update(frame->app_instance, frame->delta_time))
+    {
+        DFATAL("App update failed, shutting down...");
+        return;
+    }
+
+    if (!frame->app_instance->render(frame->app_instance, frame->delta_time))
+    {
+        DFATAL("App render failed, shutting down...");
+        return;
+    }
+    frame->succeeded = true;
+}
+
 void application_get_framebuffer_size(u32* width, u32* height) 
 {
     *width = app_state->width;
@@ -259,8 +423,9 @@ b8 application_on_key(u16 code, void* sender, void* listener, event_context data
         {
             case KEY_ESCAPE:
             {
+                // Posted rather than fired, as we are inside a handler already.
                 event_context data = {};
-                event_fire(EVENT_CODE_APPLICATION_QUIT, 0, data);
+                event_post(EVENT_CODE_APPLICATION_QUIT, 0, data);
                 return true;
             }
             case KEY_LALT:
@@ -11,6 +11,32 @@ typedef struct application_config{
     i16 start_width;
     i16 start_height;
     char* name;
+
+    // Job threads to start. 0 starts one per core of the main thread's NUMA node, less one for the main thread.
+    u32 job_thread_count;
+
+    // Start the fiber scheduler alongside the job system and run the app's update/render as a
+    // fiber task on the main thread, so they can fiber_wait on the work they submit. The two
+    // split job_thread_count threads between them.
+    b8 use_fiber_scheduler;
+
+    // Frames per second the main loop is held to. 0 runs unlimited (or at the present rate).
+    f32 target_frame_rate;
+
+    // If set, all input is recorded to this file (see input_record_start).
+    char* input_record_path;
+    // If set, input is replayed from this file instead of read from the platform, and the
+    // application quits when the replay ends. Used for repeatable benchmark runs.
+    char* input_replay_path;
+    // Fixed delta time, in seconds, passed to every frame while replaying. 0 uses 1/60.
+    f32 replay_delta_time;
+
+    // If set, the app callbacks are loaded from this shared library instead of the ones
+    // create_app assigned, and swapped for each new build of it between frames (see game_module.h).
+    char* game_library_path;
+
+    // Run without a window or display; start_width/start_height give the offscreen framebuffer size.
+    b8 headless;
 }application_config;
 
 DAPI b8 application_create(struct app* app_instance);
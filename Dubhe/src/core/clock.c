@@ -4,19 +4,19 @@
 
 void clock_update(clock* clock)
 {
-    if(clock->start_time != 0.0)
+    if(clock->start_ticks != 0)
     {
-        clock->elapsed = platform_get_absolute_time() - clock->start_time;
+        clock->elapsed = (f64)platform_ticks_to_ns(platform_get_ticks() - clock->start_ticks) * 0.000000001;
     }
 }
 
 void clock_start(clock* clock)
 {
-    clock->start_time = platform_get_absolute_time();
+    clock->start_ticks = platform_get_ticks();
     clock->elapsed = 0.0;
 }
 
 void clock_stop(clock* clock)
 {
-    clock->start_time = 0.0;
+    clock->start_ticks = 0;
 }
\ No newline at end of file
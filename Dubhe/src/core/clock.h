@@ -3,7 +3,9 @@
 #include "defines.h"
 
 typedef struct clock {
-    f64 start_time;
+    // platform_get_ticks at clock_start; 0 when stopped.
+    u64 start_ticks;
+    // Seconds since clock_start, as of the last clock_update.
     f64 elapsed;
 } clock;
 
@@ -31,7 +31,9 @@ static const char* memory_tag_strings[MEMORY_TAG_MAX_TAGS] = {
     "TRANSFORM                      ",
     "ENTITY                         ",
     "ENTITY_NODE                    ",
-    "SCENE                          "};
+    "SCENE                          ",
+    "FILE                           ",
+    "EVENT                          "};
 
 static struct memory_stats stats;
 
@@ -57,7 +59,7 @@ void memory_system_initialize(u64* memory_requirements, void* state)
 
 void memory_system_shutdown(void* state)
 {
-    DINFO("shutdown_memory");
+    DLOG_INFO(LOG_CATEGORY_MEMORY, "shutdown_memory");
     state_ptr = 0;
 }
 
@@ -65,7 +67,7 @@ void* dallocate(u64 size, memory_tag tag)
 {
     if(tag == MEMORY_TAG_UNKNOWN)
     {
-        DWARN("dallocate called using MEMORY_TAG_UNKNOWN. Re-calss this allocation.");
+        DLOG_WARN(LOG_CATEGORY_MEMORY, "dallocate called using MEMORY_TAG_UNKNOWN. Re-calss this allocation.");
     }
 
     if(state_ptr)
@@ -84,7 +86,7 @@ void dfree(void* block, u64 size, memory_tag tag)
 {
     if(tag == MEMORY_TAG_UNKNOWN)
     {
-        DWARN("dallocate called using MEMORY_TAG_UNKNOWN. Re-calss this allocation.");
+        DLOG_WARN(LOG_CATEGORY_MEMORY, "dallocate called using MEMORY_TAG_UNKNOWN. Re-calss this allocation.");
     }
 
     if(state_ptr)
@@ -107,6 +109,11 @@ void* dcopy_memory(void* dest, const void* src, u64 size)
     return platform_copy_memory(dest, src, size);
 }
 
+void* dmove_memory(void* dest, const void* src, u64 size)
+{
+    return platform_move_memory(dest, src, size);
+}
+
 void* dset_memory(void* dest, i32 value, u64 size)
 {
     return platform_set_memory(dest, value, size);
@@ -150,7 +157,11 @@ char* get_memory_usage_str()
     }
 
     // This is actually a leak mem, but don't worry about it.
+#if DPLATFORM_WINDOWS
     char* out_string = _strdup(buffer);
+#else
+    char* out_string = strdup(buffer);
+#endif
     return out_string;
 }
 
@@ -22,6 +22,8 @@ typedef enum memory_tag {
     MEMORY_TAG_ENTITY,
     MEMORY_TAG_ENTITY_NODE,
     MEMORY_TAG_SCENE,
+    MEMORY_TAG_FILE,
+    MEMORY_TAG_EVENT,
 
     MEMORY_TAG_MAX_TAGS
 } memory_tag;
@@ -37,6 +39,9 @@ DAPI void* dzero_memory(void* block, u64 size);
 
 DAPI void* dcopy_memory(void* dest, const void* source, u64 size);
 
+// Copies size bytes from source to dest, which may overlap.
+DAPI void* dmove_memory(void* dest, const void* source, u64 size);
+
 DAPI void* dset_memory(void* dest, i32 value, u64 size);
 
 DAPI char* get_memory_usage_str();
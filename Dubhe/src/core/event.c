@@ -3,25 +3,213 @@
 #include "core/logger.h"
 #include "core/dmemory.h"
 #include "containers/darray.h"
+#include "containers/mpsc_queue.h"
+#include "platform/platform.h"
+#include "platform/atomic.h"
 
 typedef struct registered_event {
     void* listener;
     PFN_on_event callback;
+    i32 priority;
+    // The generation at registration. Unique, and ascending in registration order.
+    u64 sequence;
 }registered_event;
 
 typedef struct event_code_entry {
-    registered_event* events; // Dynamic array of the events
+    u16 code;
+    // Span of this code's listeners within event_system_state.listeners.
+    u32 first;
+    u32 count;
 } event_code_entry;
 
-#define MAX_EVENT_CODES 16384
+typedef struct queued_event {
+    u16 code;
+    // 1 + the index of the payload arena holding this event's payload, or 0 if it has none.
+    u8 payload_arena;
+    void* sender;
+    event_context data;
+} queued_event;
+
+/*
+ Payloads posted with event_post_payload are copied into one of two arenas. Producers bump
+ allocate from the current arena with atomics, from any thread. Each dispatch switches the
+ current arena, and an arena is only reset once every event referencing it has been fired
+ (pending reaches 0), so payloads from late producers survive until their own dispatch.
+*/
+typedef struct payload_arena {
+    u8* memory;
+    // Bytes allocated so far. Atomic. Never exceeds EVENT_PAYLOAD_ARENA_SIZE.
+    u64 offset;
+    // Producers allocating from, and posted events not yet fired out of, this arena. Atomic.
+    u64 pending;
+} payload_arena;
+
+// Size of each payload arena. A frame can post up to this many bytes of payloads.
+#define EVENT_PAYLOAD_ARENA_SIZE (1024 * 1024)
+// Alignment of each payload.
+#define EVENT_PAYLOAD_ALIGNMENT 16
+
+// coalesce_rule.pending_index when no event of the code has been batched yet this frame.
+#define NO_PENDING_EVENT ((u64)-1)
+
+typedef struct coalesce_rule {
+    u16 code;
+    event_coalesce_policy policy;
+    PFN_event_merge merge;
+    // Index in the dispatch batch of this frame's pending event, or NO_PENDING_EVENT.
+    u64 pending_index;
+} coalesce_rule;
+
+// Initial capacities. Both arrays grow as needed.
+#define EVENT_CODES_INITIAL_CAPACITY 32
+#define EVENT_LISTENERS_INITIAL_CAPACITY 64
+
+// Maximum number of events which can be posted between two dispatches.
+#define MAX_POSTED_EVENTS 4096
 
 // Event state structure
 typedef struct event_system_state {
-    event_code_entry registered_events[MAX_EVENT_CODES];
+    // Codes with at least one listener, sorted by code. Dynamic array.
+    event_code_entry* codes;
+    // Listeners of every code in one contiguous array, grouped in the same order as codes.
+    // Each group is sorted by descending priority, then registration order. Dynamic array.
+    registered_event* listeners;
+    // Incremented on every register/unregister, so event_fire can detect changes made by handlers.
+    u64 generation;
+
+    // Events posted for the next dispatch, from any thread. Drained by the main thread.
+    mpsc_queue posted;
+    // Events being dispatched, popped from posted at the start of each dispatch. Dynamic array.
+    queued_event* dispatching;
+    // Whether event_fire records profiling samples.
+    b8 profiling;
+    // Per-code samples of the frame in progress and of the last completed frame, sorted by code. Dynamic arrays.
+    event_code_profile* profile_frame;
+    event_code_profile* profile_last;
+
+    payload_arena payload_arenas[2];
+    // Index of the arena producers allocate from. Atomic; only changed by the main thread.
+    u32 payload_current;
+
+    // Codes which do not use EVENT_COALESCE_KEEP_ALL. Few, so searched linearly. Dynamic array.
+    coalesce_rule* coalesce_rules;
 } event_system_state;
 
 static event_system_state* state_ptr;
 
+/**
+ * Binary searches the sorted code entries. Returns true if found. out_index receives the
+ * index of the entry, or the index it should be inserted at if not found.
+ */
+static b8 find_code(u16 code, u64* out_index)
+{
+    u64 low = 0;
+    u64 high = darray_length(state_ptr->codes);
+    while(low < high)
+    {
+        u64 mid = low + (high - low) / 2;
+        u16 mid_code = state_ptr->codes[mid].code;
+        if(mid_code == code)
+        {
+            *out_index = mid;
+            return true;
+        }
+        if(mid_code < code)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    *out_index = low;
+    return false;
+}
+
+// Whether a fires after b: lower priority, or equal priority and registered later.
+static b8 fires_after(const registered_event* a, const registered_event* b)
+{
+    return a->priority < b->priority || (a->priority == b->priority && a->sequence > b->sequence);
+}
+
+// Moves the spans of all codes after code_index by delta listeners.
+static void shift_spans(u64 code_index, i32 delta)
+{
+    u64 code_count = darray_length(state_ptr->codes);
+    for(u64 i = code_index + 1; i < code_count; i++)
+    {
+        state_ptr->codes[i].first += delta;
+    }
+}
+
+// Binary searches a profile array sorted by code, like find_code.
+static b8 find_profile(event_code_profile* profiles, u16 code, u64* out_index)
+{
+    u64 low = 0;
+    u64 high = darray_length(profiles);
+    while(low < high)
+    {
+        u64 mid = low + (high - low) / 2;
+        if(profiles[mid].code == code)
+        {
+            *out_index = mid;
+            return true;
+        }
+        if(profiles[mid].code < code)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    *out_index = low;
+    return false;
+}
+
+// Adds a single event_fire sample to the frame in progress.
+static void profile_record(const event_code_profile* sample)
+{
+    u64 index;
+    if(!find_profile(state_ptr->profile_frame, sample->code, &index))
+    {
+        event_code_profile entry = {0};
+        entry.code = sample->code;
+        darray_insert_at(state_ptr->profile_frame, index, entry);
+    }
+
+    event_code_profile* entry = &state_ptr->profile_frame[index];
+    entry->fire_count += sample->fire_count;
+    entry->listener_count += sample->listener_count;
+    entry->total_time += sample->total_time;
+    if(sample->max_time > entry->max_time)
+    {
+        entry->max_time = sample->max_time;
+    }
+}
+
+static coalesce_rule* find_coalesce_rule(u16 code)
+{
+    u64 rule_count = darray_length(state_ptr->coalesce_rules);
+    for(u64 i = 0; i < rule_count; i++)
+    {
+        if(state_ptr->coalesce_rules[i].code == code)
+        {
+            return &state_ptr->coalesce_rules[i];
+        }
+    }
+    return 0;
+}
+
+// Sums wheel deltas, clamped to the range of the i8 they are stored in.
+static void merge_mouse_wheel(event_context* accumulated, const event_context* incoming)
+{
+    i32 z = (i32)accumulated->data.i8[0] + (i32)incoming->data.i8[0];
+    accumulated->data.i8[0] = (i8)(z < -128 ? -128 : (z > 127 ? 127 : z));
+}
+
 void event_system_initialize(u64* memory_requirement, void* state)
 {
     *memory_requirement = sizeof(event_system_state);
@@ -29,51 +217,99 @@ void event_system_initialize(u64* memory_requirement, void* state)
     {
         return;
     }
-    dzero_memory(state, sizeof(state));
+    dzero_memory(state, sizeof(event_system_state));
     state_ptr = state;
+    state_ptr->codes = darray_reserve(event_code_entry, EVENT_CODES_INITIAL_CAPACITY);
+    state_ptr->listeners = darray_reserve(registered_event, EVENT_LISTENERS_INITIAL_CAPACITY);
+    mpsc_queue_create(MAX_POSTED_EVENTS, sizeof(queued_event), &state_ptr->posted);
+    state_ptr->dispatching = darray_create(queued_event);
+    state_ptr->coalesce_rules = darray_create(coalesce_rule);
+    state_ptr->profile_frame = darray_create(event_code_profile);
+    state_ptr->profile_last = darray_create(event_code_profile);
+    for(u32 i = 0; i < 2; i++)
+    {
+        state_ptr->payload_arenas[i].memory = dallocate(EVENT_PAYLOAD_ARENA_SIZE, MEMORY_TAG_EVENT);
+    }
+
+    event_set_coalesce_policy(EVENT_CODE_MOUSE_MOVE, EVENT_COALESCE_KEEP_LATEST, 0);
+    event_set_coalesce_policy(EVENT_CODE_RESIZED, EVENT_COALESCE_KEEP_LATEST, 0);
+    event_set_coalesce_policy(EVENT_CODE_MOUSE_WHEEL, EVENT_COALESCE_ACCUMULATE, merge_mouse_wheel);
 }
 
 void event_system_shutdown()
 {
     if(state_ptr)
     {
-        for(u16 i = 0; i < MAX_EVENT_CODES; i++)
+        darray_destroy(state_ptr->codes);
+        darray_destroy(state_ptr->listeners);
+        state_ptr->codes = 0;
+        state_ptr->listeners = 0;
+        mpsc_queue_destroy(&state_ptr->posted);
+        darray_destroy(state_ptr->dispatching);
+        state_ptr->dispatching = 0;
+        darray_destroy(state_ptr->coalesce_rules);
+        state_ptr->coalesce_rules = 0;
+        darray_destroy(state_ptr->profile_frame);
+        darray_destroy(state_ptr->profile_last);
+        state_ptr->profile_frame = 0;
+        state_ptr->profile_last = 0;
+        for(u32 i = 0; i < 2; i++)
         {
-            if(state_ptr->registered_events[i].events != 0)
-            {
-                darray_destroy((void*)(state_ptr->registered_events[i].events));
-                state_ptr->registered_events[i].events = 0;
-            }
+            dfree(state_ptr->payload_arenas[i].memory, EVENT_PAYLOAD_ARENA_SIZE, MEMORY_TAG_EVENT);
+            state_ptr->payload_arenas[i].memory = 0;
         }
     }
     state_ptr = 0;
 }
 
 b8 event_register(u16 code, void* listener, PFN_on_event callback)
+{
+    return event_register_priority(code, listener, callback, 0);
+}
+
+b8 event_register_priority(u16 code, void* listener, PFN_on_event callback, i32 priority)
 {
     if(!state_ptr)
     {
         return false;
     }
 
-    if(state_ptr->registered_events[code].events == 0)
+    u64 code_index;
+    if(!find_code(code, &code_index))
     {
-        state_ptr->registered_events[code].events = darray_create(registered_event);
+        event_code_entry entry;
+        entry.code = code;
+        entry.first = code_index < darray_length(state_ptr->codes) ? state_ptr->codes[code_index].first : (u32)darray_length(state_ptr->listeners);
+        entry.count = 0;
+        darray_insert_at(state_ptr->codes, code_index, entry);
     }
 
-    u64 registered_count = darray_length(state_ptr->registered_events[code].events);
-    for(u64 i = 0; i < registered_count; i++)
+    event_code_entry* entry = &state_ptr->codes[code_index];
+    u32 insert_at = entry->first + entry->count;
+    for(u32 i = entry->first; i < entry->first + entry->count; i++)
     {
-        if(state_ptr->registered_events[code].events[i].listener == listener)
+        registered_event* e = &state_ptr->listeners[i];
+        if(e->listener == listener && e->callback == callback)
         {
-            DWARN("The listener is already registered.");
+            DLOG_WARN(LOG_CATEGORY_EVENT, "The listener is already registered.");
             return false;
         }
+        // After all listeners of equal or higher priority.
+        if(insert_at == entry->first + entry->count && e->priority < priority)
+        {
+            insert_at = i;
+        }
     }
+
     registered_event new_event;
     new_event.callback = callback;
     new_event.listener = listener;
-    darray_push(state_ptr->registered_events[code].events, new_event);
+    new_event.priority = priority;
+    new_event.sequence = state_ptr->generation;
+    darray_insert_at(state_ptr->listeners, insert_at, new_event);
+    entry->count++;
+    shift_spans(code_index, 1);
+    state_ptr->generation++;
 
     return true;
 }
@@ -85,21 +321,29 @@ b8 event_unregister(u16 code, void* listener, PFN_on_event callback)
         return false;
     }
 
-    if(state_ptr->registered_events[code].events == 0)
+    u64 code_index;
+    if(!find_code(code, &code_index))
     {
         // TODO: warn
         return false;
     }
 
-    u64 registered_count = darray_length(state_ptr->registered_events[code].events);
-    u64 index;
-    for(index = 0; index < registered_count; index++)
+    event_code_entry* entry = &state_ptr->codes[code_index];
+    for(u32 i = entry->first; i < entry->first + entry->count; i++)
     {
-        registered_event e = state_ptr->registered_events[code].events[index];
+        registered_event e = state_ptr->listeners[i];
         if(e.listener == listener && e.callback == callback)
         {
             registered_event event;
-            darray_pop_at(state_ptr->registered_events[code].events, index, &event);
+            darray_pop_at(state_ptr->listeners, i, &event);
+            entry->count--;
+            shift_spans(code_index, -1);
+            if(entry->count == 0)
+            {
+                event_code_entry removed;
+                darray_pop_at(state_ptr->codes, code_index, &removed);
+            }
+            state_ptr->generation++;
             return true;
         }
     }
@@ -115,22 +359,315 @@ b8 event_fire(u16 code, void* sender, event_context data)
         return false;
     }
 
-    if(state_ptr->registered_events[code].events == 0)
+    b8 profiling = state_ptr->profiling;
+    event_code_profile sample = {0};
+    sample.code = code;
+    sample.fire_count = 1;
+
+    b8 handled = false;
+    u64 code_index;
+    if(find_code(code, &code_index))
+    {
+        u32 first = state_ptr->codes[code_index].first;
+        u32 count = state_ptr->codes[code_index].count;
+        u64 generation = state_ptr->generation;
+        registered_event e = {0};
+        for(u32 i = 0; i < count; i++)
+        {
+            if(generation != state_ptr->generation)
+            {
+                // A handler (un)registered listeners, which may have moved this code's span and
+                // the listeners within it. Resume after the last listener called, by its place
+                // in the firing order rather than its old index.
+                if(!find_code(code, &code_index))
+                {
+                    break;
+                }
+                first = state_ptr->codes[code_index].first;
+                count = state_ptr->codes[code_index].count;
+                generation = state_ptr->generation;
+                i = 0;
+                while(i < count && !fires_after(&state_ptr->listeners[first + i], &e))
+                {
+                    i++;
+                }
+                if(i >= count)
+                {
+                    break;
+                }
+            }
+
+            e = state_ptr->listeners[first + i];
+            if(profiling)
+            {
+                u64 start = platform_get_ticks();
+                handled = e.callback(code, sender, e.listener, data);
+                f64 elapsed = (f64)platform_ticks_to_ns(platform_get_ticks() - start) * 0.000000001;
+                sample.listener_count++;
+                sample.total_time += elapsed;
+                sample.max_time = elapsed > sample.max_time ? elapsed : sample.max_time;
+            }
+            else
+            {
+                handled = e.callback(code, sender, e.listener, data);
+            }
+
+            if(handled)
+            {
+                break;
+            }
+        }
+    }
+
+    // Recorded after the handlers, since nested fires may grow the profile array.
+    if(profiling)
+    {
+        profile_record(&sample);
+    }
+
+    // NOTE: 这个返回基本上不影响事件处理流程
+    return handled;
+}
+
+static b8 post_queued(const queued_event* e)
+{
+    if(!mpsc_queue_push(&state_ptr->posted, e))
+    {
+        DLOG_LIMITED(LOG_CATEGORY_EVENT, LOG_LEVEL_WARN, 1, "Posted event queue is full, dropping event code %u.", e->code);
+        return false;
+    }
+    return true;
+}
+
+b8 event_post(u16 code, void* sender, event_context data)
+{
+    if(!state_ptr)
+    {
+        return false;
+    }
+
+    queued_event e;
+    e.code = code;
+    e.payload_arena = 0;
+    e.sender = sender;
+    e.data = data;
+    return post_queued(&e);
+}
+
+b8 event_post_payload(u16 code, void* sender, const void* payload, u64 size)
+{
+    if(!state_ptr)
     {
-        // TODO: warn
         return false;
     }
-    u64 registered_count = darray_length(state_ptr->registered_events[code].events);
-    for(u64 i = 0; i < registered_count; i++)
+
+    // Join the current arena. If the main thread switched arenas in the meantime, leave and
+    // retry, since the arena may already have been reset.
+    payload_arena* arena;
+    u32 index;
+    for(;;)
     {
-        registered_event e = state_ptr->registered_events[code].events[i];
-        if(e.callback(code, sender, e.listener, data))
+        index = datomic_load_u32(&state_ptr->payload_current, DATOMIC_SEQ_CST);
+        arena = &state_ptr->payload_arenas[index];
+        datomic_fetch_add_u64(&arena->pending, 1, DATOMIC_SEQ_CST);
+        if(datomic_load_u32(&state_ptr->payload_current, DATOMIC_SEQ_CST) == index)
         {
-            // NOTE: 这个返回基本上不影响事件处理流程
-            return true;
+            break;
         }
+        datomic_fetch_sub_u64(&arena->pending, 1, DATOMIC_SEQ_CST);
     }
 
-    // NOTE: 这个返回基本上不影响事件处理流程
-    return false;
+    u64 aligned_size = (size + EVENT_PAYLOAD_ALIGNMENT - 1) & ~(u64)(EVENT_PAYLOAD_ALIGNMENT - 1);
+    // Only take the space if the payload fits, so one oversized post doesn't use up the arena
+    // for the smaller ones after it.
+    u64 offset = datomic_load_u64(&arena->offset, DATOMIC_RELAXED);
+    do
+    {
+        if(aligned_size > EVENT_PAYLOAD_ARENA_SIZE - offset)
+        {
+            datomic_fetch_sub_u64(&arena->pending, 1, DATOMIC_SEQ_CST);
+            DLOG_LIMITED(LOG_CATEGORY_EVENT, LOG_LEVEL_WARN, 1, "Event payload arena is full, dropping event code %u (%llu bytes).", code, size);
+            return false;
+        }
+    } while(!datomic_compare_exchange_weak_u64(&arena->offset, &offset, offset + aligned_size, DATOMIC_RELAXED));
+
+    void* block = arena->memory + offset;
+    dcopy_memory(block, payload, size);
+
+    queued_event e;
+    e.code = code;
+    e.payload_arena = (u8)(index + 1);
+    e.sender = sender;
+    e.data.data.u64[0] = (u64)block;
+    e.data.data.u64[1] = size;
+    if(!post_queued(&e))
+    {
+        // The space is reclaimed when the arena is reset.
+        datomic_fetch_sub_u64(&arena->pending, 1, DATOMIC_SEQ_CST);
+        return false;
+    }
+    // pending stays held until the event has been fired.
+    return true;
+}
+
+const void* event_context_payload(event_context data, u64* out_size)
+{
+    if(out_size)
+    {
+        *out_size = data.data.u64[1];
+    }
+    return (const void*)data.data.u64[0];
+}
+
+void event_dispatch_posted()
+{
+    if(!state_ptr)
+    {
+        return;
+    }
+
+    // Switch producers to the other payload arena, once every event using it has been fired.
+    u32 other = 1 - state_ptr->payload_current;
+    payload_arena* other_arena = &state_ptr->payload_arenas[other];
+    if(datomic_load_u64(&other_arena->pending, DATOMIC_SEQ_CST) == 0)
+    {
+        datomic_store_u64(&other_arena->offset, 0, DATOMIC_SEQ_CST);
+        datomic_store_u32(&state_ptr->payload_current, other, DATOMIC_SEQ_CST);
+    }
+
+    // Only take what was posted before this point; anything posted by the handlers
+    // below, or still being written by another thread, waits for the next frame.
+    u64 count = mpsc_queue_claimed(&state_ptr->posted) - mpsc_queue_consumed(&state_ptr->posted);
+    if(count == 0)
+    {
+        return;
+    }
+
+    u64 rule_count = darray_length(state_ptr->coalesce_rules);
+    for(u64 i = 0; i < rule_count; i++)
+    {
+        state_ptr->coalesce_rules[i].pending_index = NO_PENDING_EVENT;
+    }
+
+    queued_event e;
+    for(u64 i = 0; i < count && mpsc_queue_pop(&state_ptr->posted, &e); i++)
+    {
+        // Payload events are never coalesced; each one holds its arena until fired.
+        coalesce_rule* rule = (rule_count && !e.payload_arena) ? find_coalesce_rule(e.code) : 0;
+        if(rule)
+        {
+            if(rule->pending_index != NO_PENDING_EVENT)
+            {
+                queued_event* pending = &state_ptr->dispatching[rule->pending_index];
+                pending->sender = e.sender;
+                if(rule->policy == EVENT_COALESCE_ACCUMULATE)
+                {
+                    rule->merge(&pending->data, &e.data);
+                }
+                else
+                {
+                    pending->data = e.data;
+                }
+                continue;
+            }
+            rule->pending_index = darray_length(state_ptr->dispatching);
+        }
+        darray_push(state_ptr->dispatching, e);
+    }
+
+    u64 batch_count = darray_length(state_ptr->dispatching);
+    for(u64 i = 0; i < batch_count; i++)
+    {
+        queued_event* batched = &state_ptr->dispatching[i];
+        event_fire(batched->code, batched->sender, batched->data);
+        if(batched->payload_arena)
+        {
+            datomic_fetch_sub_u64(&state_ptr->payload_arenas[batched->payload_arena - 1].pending, 1, DATOMIC_SEQ_CST);
+        }
+    }
+    darray_clear(state_ptr->dispatching);
+}
+
+b8 event_set_coalesce_policy(u16 code, event_coalesce_policy policy, PFN_event_merge merge)
+{
+    if(!state_ptr)
+    {
+        return false;
+    }
+    if(policy == EVENT_COALESCE_ACCUMULATE && !merge)
+    {
+        DLOG_ERROR(LOG_CATEGORY_EVENT, "event_set_coalesce_policy - EVENT_COALESCE_ACCUMULATE requires a merge callback.");
+        return false;
+    }
+
+    coalesce_rule* rule = find_coalesce_rule(code);
+    if(policy == EVENT_COALESCE_KEEP_ALL)
+    {
+        if(rule)
+        {
+            coalesce_rule removed;
+            darray_pop_at(state_ptr->coalesce_rules, rule - state_ptr->coalesce_rules, &removed);
+        }
+        return true;
+    }
+
+    if(!rule)
+    {
+        coalesce_rule new_rule;
+        new_rule.code = code;
+        new_rule.pending_index = NO_PENDING_EVENT;
+        darray_push(state_ptr->coalesce_rules, new_rule);
+        rule = &state_ptr->coalesce_rules[darray_length(state_ptr->coalesce_rules) - 1];
+    }
+    rule->policy = policy;
+    rule->merge = merge;
+    return true;
+}
+
+void event_profiling_enable(b8 enabled)
+{
+    if(state_ptr)
+    {
+        state_ptr->profiling = enabled;
+    }
+}
+
+b8 event_profiling_enabled()
+{
+    return state_ptr && state_ptr->profiling;
+}
+
+void event_profile_frame_end()
+{
+    if(!state_ptr)
+    {
+        return;
+    }
+
+    event_code_profile* completed = state_ptr->profile_frame;
+    state_ptr->profile_frame = state_ptr->profile_last;
+    state_ptr->profile_last = completed;
+    darray_clear(state_ptr->profile_frame);
+}
+
+b8 event_profile_get(u16 code, event_code_profile* out_profile)
+{
+    u64 index;
+    if(!state_ptr || !find_profile(state_ptr->profile_last, code, &index))
+    {
+        return false;
+    }
+    *out_profile = state_ptr->profile_last[index];
+    return true;
+}
+
+const event_code_profile* event_profile_get_all(u32* out_count)
+{
+    if(!state_ptr)
+    {
+        *out_count = 0;
+        return 0;
+    }
+    *out_count = (u32)darray_length(state_ptr->profile_last);
+    return state_ptr->profile_last;
 }
\ No newline at end of file
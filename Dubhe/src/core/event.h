@@ -25,8 +25,8 @@ typedef struct event_context {
 
 typedef b8 (*PFN_on_event)(u16 code, void* sender, void* listener, event_context data);
 
-void event_system_initialize(u64* memory_requirement, void* state);
-void event_system_shutdown();
+DAPI void event_system_initialize(u64* memory_requirement, void* state);
+DAPI void event_system_shutdown();
 
 /**
  * Register to listen for when events are sent with the provided code. Events with duplicate
@@ -38,6 +38,17 @@ void event_system_shutdown();
  */
 DAPI b8 event_register(u16 code, void* listener, PFN_on_event callback);
 
+/**
+ * Register to listen for the provided code with a priority. Listeners with a higher priority
+ * are invoked first; equal priorities are invoked in registration order. event_register uses priority 0.
+ * @param code The event code to listen for.
+ * @param listener A pointer to a listener instance. Can be 0/NULL.
+ * @param callback The callback function pointer to be invoked when the event code is fired.
+ * @param priority The priority of this listener. Higher runs earlier.
+ * @returns true if the event is successfully registered; otherwise false.
+ */
+DAPI b8 event_register_priority(u16 code, void* listener, PFN_on_event callback, i32 priority);
+
 /**
  * Unregister from listening for when events are sent with the provided code. If no matching
  * registration is found, this function returns false.
@@ -58,6 +69,122 @@ DAPI b8 event_unregister(u16 code, void* listener, PFN_on_event callback);
  */
 DAPI b8 event_fire(u16 code, void* sender, event_context data);
 
+/**
+ * Queues an event to be fired later, at the point each frame where the application calls
+ * event_dispatch_posted. Use this instead of event_fire from inside event handlers and OS
+ * callbacks to avoid reentrancy. Events posted while dispatching are delivered next frame.
+ * Lock-free and safe to call from any thread; listeners always run on the main thread.
+ * @param code The event code to post.
+ * @param sender A pointer to the sender. Can be 0/NULL. Must still be valid when dispatched.
+ * @param data The event data.
+ * @returns true if the event was queued; false if the queue is full.
+ */
+DAPI b8 event_post(u16 code, void* sender, event_context data);
+
+/**
+ * Queues an event carrying a copy of a variable-size payload, for payloads which do not fit in
+ * event_context. The payload is copied into a per-frame arena, so no allocation is needed by the
+ * sender, and is released automatically once the event has been dispatched. Listeners receive
+ * data.data.u64[0] = pointer to the payload and data.data.u64[1] = its size (see
+ * event_context_payload); the pointer is only valid during the callback. Payload events are
+ * never coalesced. Lock-free and safe to call from any thread.
+ * @param code The event code to post.
+ * @param sender A pointer to the sender. Can be 0/NULL. Must still be valid when dispatched.
+ * @param payload A pointer to the payload to copy.
+ * @param size The size of the payload in bytes.
+ * @returns true if the event was queued; false if the queue or this frame's payload arena is full.
+ */
+DAPI b8 event_post_payload(u16 code, void* sender, const void* payload, u64 size);
+
+/**
+ * Gets the payload of an event posted with event_post_payload.
+ * @param data The event data passed to the listener.
+ * @param out_size A pointer to hold the size of the payload in bytes. Can be 0/NULL.
+ * @returns A pointer to the payload, valid until the listener returns.
+ */
+DAPI const void* event_context_payload(event_context data, u64* out_size);
+
+/**
+ * Fires every event posted since the last call, in the order they were posted.
+ * Events whose code has a coalescing policy are collapsed first (see event_set_coalesce_policy).
+ * Called once per frame by the application.
+ */
+DAPI void event_dispatch_posted();
+
+typedef enum event_coalesce_policy {
+    // Every posted event is dispatched. The default for all codes.
+    EVENT_COALESCE_KEEP_ALL = 0,
+    // Only the most recently posted event of the code is dispatched each frame.
+    EVENT_COALESCE_KEEP_LATEST,
+    // Events of the code are folded into one using a merge callback.
+    EVENT_COALESCE_ACCUMULATE
+} event_coalesce_policy;
+
+/**
+ * Folds an incoming event into the one already pending for this frame.
+ * @param accumulated The pending event's data, updated in place.
+ * @param incoming The data of the event being folded in.
+ */
+typedef void (*PFN_event_merge)(event_context* accumulated, const event_context* incoming);
+
+/**
+ * Sets how events of the given code are collapsed when several are posted within one frame.
+ * The collapsed event is dispatched at the position of the first one posted, with the sender of
+ * the last. Only affects event_post; event_fire always invokes listeners immediately.
+ * Mouse move and resize default to EVENT_COALESCE_KEEP_LATEST, mouse wheel accumulates.
+ * @param code The event code.
+ * @param policy The coalescing policy.
+ * @param merge The merge callback. Required for EVENT_COALESCE_ACCUMULATE, otherwise ignored.
+ * @returns true if the policy was set; otherwise false.
+ */
+DAPI b8 event_set_coalesce_policy(u16 code, event_coalesce_policy policy, PFN_event_merge merge);
+
+typedef struct event_code_profile {
+    u16 code;
+    // Number of event_fire calls for the code, including posted events when dispatched.
+    u32 fire_count;
+    // Number of listener callbacks invoked across those calls.
+    u32 listener_count;
+    // Time spent in listener callbacks, in seconds. Includes any events they fire themselves.
+    f64 total_time;
+    // Longest single listener callback, in seconds.
+    f64 max_time;
+} event_code_profile;
+
+/**
+ * Enables or disables recording of per-code profiling samples in event_fire. Off by default;
+ * when off, event_fire does no timing.
+ * @param enabled true to record samples.
+ */
+DAPI void event_profiling_enable(b8 enabled);
+
+/**
+ * @returns true if event profiling is enabled.
+ */
+DAPI b8 event_profiling_enabled();
+
+/**
+ * Completes the current profiling frame: its samples become the ones returned by the query
+ * functions, and a new frame is started. Called once per frame by the application.
+ */
+DAPI void event_profile_frame_end();
+
+/**
+ * Gets the profile of a code for the last completed frame.
+ * @param code The event code.
+ * @param out_profile A pointer to hold the profile.
+ * @returns true if the code was fired during the last completed frame; otherwise false.
+ */
+DAPI b8 event_profile_get(u16 code, event_code_profile* out_profile);
+
+/**
+ * Gets the profiles of every code fired during the last completed frame, sorted by code.
+ * The array is owned by the event system and valid until the next event_profile_frame_end.
+ * @param out_count A pointer to hold the number of profiles.
+ * @returns A pointer to the first profile, or 0 if there are none.
+ */
+DAPI const event_code_profile* event_profile_get_all(u32* out_count);
+
 // System internal event codes. Application code should use codes beyond 255
 
 typedef enum system_event_code {
@@ -86,7 +213,8 @@ typedef enum system_event_code {
 
     // Mouse Scroll
     /*
-     * data usage: u8 z = data.data.u8[0];
+     * data usage: i8 z = data.data.i8[0];
+     * Accumulated when posted: z is the sum of the frame's deltas.
      */
     EVENT_CODE_MOUSE_WHEEL = 0x07,
 
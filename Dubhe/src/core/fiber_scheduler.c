@@ -0,0 +1,630 @@
+#include "fiber_scheduler.h"
+
+#include "core/logger.h"
+#include "core/dmemory.h"
+#include "platform/fiber.h"
+#include "platform/thread.h"
+#include "platform/atomic.h"
+
+#include <stdio.h>
+
+// Most scheduler threads started, regardless of the processor count.
+#define FIBER_SCHEDULER_MAX_THREADS 32
+// Fibers in the pool when none is specified.
+#define FIBER_DEFAULT_POOL_SIZE 128
+// Stack size of each fiber. Tasks may call into drivers, so keep it generous.
+#define FIBER_STACK_SIZE (256 * 1024)
+// Tasks that can be queued at once.
+#define FIBER_TASK_QUEUE_SIZE 4096
+// Marks "no fiber", e.g. a thread running on its own stack rather than a pool fiber.
+#define FIBER_NONE 0xFFFFFFFFu
+
+typedef struct fiber_slot
+{
+    platform_fiber fiber;
+    // Set once the fiber's context has been stored after switching away from it; a parked
+    // fiber must not be resumed before then. Atomic.
+    u32 saved;
+    // The counter a parked fiber waits on.
+    fiber_counter* wait_counter;
+} fiber_slot;
+
+typedef struct queued_task
+{
+    fiber_task task;
+    fiber_counter* counter;
+} queued_task;
+
+typedef enum fiber_cleanup_action
+{
+    FIBER_CLEANUP_NONE,
+    // Return the fiber switched away from to the free pool.
+    FIBER_CLEANUP_FREE,
+    // Mark the parked fiber switched away from as resumable.
+    FIBER_CLEANUP_PARKED
+} fiber_cleanup_action;
+
+/*
+ Per-thread scheduler data. Work left by a fiber switching away (returning itself to the pool
+ or finishing parking) is done by whichever fiber runs next on the same thread, once the
+ switch has saved the old context.
+*/
+typedef struct scheduler_thread
+{
+    platform_fiber thread_fiber;
+    u32 current_fiber;
+    u32 cleanup_fiber;
+    fiber_cleanup_action cleanup_action;
+} scheduler_thread;
+
+typedef enum fiber_work
+{
+    FIBER_WORK_TASK,
+    FIBER_WORK_RESUME,
+    FIBER_WORK_STOP
+} fiber_work;
+
+typedef struct fiber_scheduler_state
+{
+    u32 thread_count;
+    platform_thread threads[FIBER_SCHEDULER_MAX_THREADS];
+    scheduler_thread thread_data[FIBER_SCHEDULER_MAX_THREADS];
+
+    u32 fiber_count;
+    fiber_slot* fibers;
+
+    // Guards everything below.
+    platform_mutex lock;
+    // Signalled when tasks are queued or parked fibers become ready.
+    platform_condition work_available;
+    // Broadcast whenever a counter reaches zero, for waiters outside the scheduler.
+    platform_condition counter_done;
+    b8 stopping;
+
+    // The thread that initialized the scheduler, which runs tasks given to fiber_task_run.
+    scheduler_thread main_thread;
+    fiber_task main_task;
+    // The fiber running main_task. It is resumed only on the main thread.
+    u32 main_fiber;
+    // Set once main_fiber has been woken from a wait.
+    b8 main_ready;
+    platform_condition main_wake;
+
+    // FIFO of tasks.
+    queued_task* tasks;
+    u32 task_head;
+    u32 task_count;
+
+    // Fiber indices. free is a stack, ready a FIFO ring, parked unordered.
+    u32* free_fibers;
+    u32 free_count;
+    u32* ready_fibers;
+    u32 ready_head;
+    u32 ready_count;
+    u32* parked_fibers;
+    u32 parked_count;
+} fiber_scheduler_state;
+
+static fiber_scheduler_state* state_ptr;
+
+static DTHREAD_LOCAL scheduler_thread* thread_data;
+
+// A fiber can resume on a different thread, but the compiler may keep a thread-local address
+// it computed before a switch. All thread-local access goes through these two functions,
+// which can't be inlined, so it is recomputed after every switch.
+static DNOINLINE scheduler_thread* get_thread()
+{
+    return thread_data;
+}
+
+static DNOINLINE void set_thread(scheduler_thread* thread)
+{
+    thread_data = thread;
+}
+
+static void run_cleanup()
+{
+    scheduler_thread* thread = get_thread();
+    u32 index = thread->cleanup_fiber;
+    if(index == FIBER_NONE)
+    {
+        return;
+    }
+    fiber_cleanup_action action = thread->cleanup_action;
+    thread->cleanup_fiber = FIBER_NONE;
+    thread->cleanup_action = FIBER_CLEANUP_NONE;
+
+    datomic_store_u32(&state_ptr->fibers[index].saved, 1, DATOMIC_RELEASE);
+    if(action == FIBER_CLEANUP_FREE)
+    {
+        platform_mutex_lock(&state_ptr->lock);
+        state_ptr->free_fibers[state_ptr->free_count++] = index;
+        platform_mutex_unlock(&state_ptr->lock);
+    }
+}
+
+/**
+ * Switches from the running fiber to another, leaving action to be done for the old one.
+ * next is FIBER_NONE to switch back to the thread's own fiber.
+ */
+static void switch_fiber(u32 next, fiber_cleanup_action action)
+{
+    scheduler_thread* thread = get_thread();
+    u32 self = thread->current_fiber;
+    platform_fiber* from = &state_ptr->fibers[self].fiber;
+    platform_fiber* to = next == FIBER_NONE ? &thread->thread_fiber : &state_ptr->fibers[next].fiber;
+
+    if(next != FIBER_NONE)
+    {
+        // A fiber parked on another thread may not have finished switching away yet.
+        while(!datomic_load_u32(&state_ptr->fibers[next].saved, DATOMIC_ACQUIRE))
+        {
+            datomic_pause();
+        }
+    }
+
+    thread->current_fiber = next;
+    thread->cleanup_fiber = self;
+    thread->cleanup_action = action;
+    platform_fiber_switch(from, to);
+
+    // Resumed, possibly on another thread.
+    run_cleanup();
+}
+
+static void finish_task(fiber_counter* counter)
+{
+    if(!counter || datomic_fetch_sub_u32(&counter->value, 1, DATOMIC_ACQ_REL) != 1)
+    {
+        return;
+    }
+
+    // The counter reached zero: make the fibers parked on it ready.
+    platform_mutex_lock(&state_ptr->lock);
+    b8 woke = false;
+    for(u32 i = 0; i < state_ptr->parked_count;)
+    {
+        u32 index = state_ptr->parked_fibers[i];
+        if(state_ptr->fibers[index].wait_counter != counter)
+        {
+            ++i;
+            continue;
+        }
+        state_ptr->fibers[index].wait_counter = 0;
+        state_ptr->parked_fibers[i] = state_ptr->parked_fibers[--state_ptr->parked_count];
+        if(index == state_ptr->main_fiber)
+        {
+            state_ptr->main_ready = true;
+            platform_condition_signal(&state_ptr->main_wake);
+            continue;
+        }
+        state_ptr->ready_fibers[(state_ptr->ready_head + state_ptr->ready_count) % state_ptr->fiber_count] = index;
+        state_ptr->ready_count++;
+        woke = true;
+    }
+    if(woke)
+    {
+        platform_condition_broadcast(&state_ptr->work_available);
+    }
+    platform_condition_broadcast(&state_ptr->counter_done);
+    platform_mutex_unlock(&state_ptr->lock);
+}
+
+static b8 pop_task(queued_task* out_task)
+{
+    if(state_ptr->task_count == 0)
+    {
+        return false;
+    }
+    *out_task = state_ptr->tasks[state_ptr->task_head];
+    state_ptr->task_head = (state_ptr->task_head + 1) % FIBER_TASK_QUEUE_SIZE;
+    state_ptr->task_count--;
+    return true;
+}
+
+/**
+ * Waits for something for a pool fiber to do. Parked fibers are resumed before new tasks are
+ * started, so started work finishes first.
+ */
+static fiber_work next_work(queued_task* out_task, u32* out_fiber)
+{
+    platform_mutex_lock(&state_ptr->lock);
+    fiber_work work;
+    for(;;)
+    {
+        if(state_ptr->ready_count > 0)
+        {
+            *out_fiber = state_ptr->ready_fibers[state_ptr->ready_head];
+            state_ptr->ready_head = (state_ptr->ready_head + 1) % state_ptr->fiber_count;
+            state_ptr->ready_count--;
+            work = FIBER_WORK_RESUME;
+            break;
+        }
+        if(pop_task(out_task))
+        {
+            work = FIBER_WORK_TASK;
+            break;
+        }
+        if(state_ptr->stopping)
+        {
+            if(state_ptr->parked_count == 0)
+            {
+                work = FIBER_WORK_STOP;
+                break;
+            }
+            // Tasks running elsewhere will wake the parked fibers; keep checking.
+            platform_condition_wait_timeout(&state_ptr->work_available, &state_ptr->lock, 1);
+            continue;
+        }
+        platform_condition_wait(&state_ptr->work_available, &state_ptr->lock);
+    }
+    platform_mutex_unlock(&state_ptr->lock);
+    return work;
+}
+
+static void fiber_main(void* params)
+{
+    run_cleanup();
+    for(;;)
+    {
+        if(get_thread() == &state_ptr->main_thread)
+        {
+            // Started by fiber_task_run: run its task, then hand the main thread back.
+            state_ptr->main_task.entry(state_ptr->main_task.params);
+            switch_fiber(FIBER_NONE, FIBER_CLEANUP_FREE);
+            continue;
+        }
+
+        queued_task task;
+        u32 next;
+        switch(next_work(&task, &next))
+        {
+            case FIBER_WORK_TASK:
+                task.task.entry(task.task.params);
+                finish_task(task.counter);
+                break;
+            case FIBER_WORK_RESUME:
+                // This fiber goes back to the pool; the parked one carries on from its wait.
+                switch_fiber(next, FIBER_CLEANUP_FREE);
+                break;
+            case FIBER_WORK_STOP:
+                switch_fiber(FIBER_NONE, FIBER_CLEANUP_FREE);
+                break;
+        }
+    }
+}
+
+static u32 scheduler_thread_run(void* params)
+{
+    u32 index = (u32)(u64)params;
+    scheduler_thread* thread = &state_ptr->thread_data[index];
+    set_thread(thread);
+
+    char name[16];
+    snprintf(name, sizeof(name), "dubhe-fiber-%u", index);
+    platform_thread_set_name(name);
+
+    if(!platform_fiber_convert_thread(&thread->thread_fiber))
+    {
+        return 1;
+    }
+
+    // The pool holds more fibers than there are threads, so one is always free here.
+    platform_mutex_lock(&state_ptr->lock);
+    u32 first = state_ptr->free_fibers[--state_ptr->free_count];
+    platform_mutex_unlock(&state_ptr->lock);
+
+    thread->current_fiber = first;
+    platform_fiber_switch(&thread->thread_fiber, &state_ptr->fibers[first].fiber);
+
+    // Back on the thread's own fiber: the scheduler is stopping.
+    thread = get_thread();
+    run_cleanup();
+    platform_fiber_convert_to_thread(&thread->thread_fiber);
+    set_thread(0);
+    return 0;
+}
+
+b8 fiber_scheduler_initialize(u64* memory_requirement, void* state, u32 thread_count, u32 fiber_count)
+{
+    *memory_requirement = sizeof(fiber_scheduler_state);
+    if(state == 0)
+    {
+        return true;
+    }
+
+    if(thread_count == 0)
+    {
+        u32 processor_count = platform_get_processor_count();
+        thread_count = processor_count > 1 ? processor_count - 1 : 1;
+    }
+    if(thread_count > FIBER_SCHEDULER_MAX_THREADS)
+    {
+        thread_count = FIBER_SCHEDULER_MAX_THREADS;
+    }
+    if(fiber_count == 0)
+    {
+        fiber_count = FIBER_DEFAULT_POOL_SIZE;
+    }
+    // Counting the main thread's.
+    if(fiber_count < (thread_count + 1) * 2)
+    {
+        fiber_count = (thread_count + 1) * 2;
+    }
+
+    state_ptr = state;
+    dzero_memory(state_ptr, sizeof(fiber_scheduler_state));
+    state_ptr->thread_count = thread_count;
+    state_ptr->fiber_count = fiber_count;
+
+    state_ptr->fibers = dallocate(sizeof(fiber_slot) * fiber_count, MEMORY_TAG_JOB);
+    state_ptr->free_fibers = dallocate(sizeof(u32) * fiber_count, MEMORY_TAG_JOB);
+    state_ptr->ready_fibers = dallocate(sizeof(u32) * fiber_count, MEMORY_TAG_JOB);
+    state_ptr->parked_fibers = dallocate(sizeof(u32) * fiber_count, MEMORY_TAG_JOB);
+    state_ptr->tasks = dallocate(sizeof(queued_task) * FIBER_TASK_QUEUE_SIZE, MEMORY_TAG_JOB);
+    dzero_memory(state_ptr->fibers, sizeof(fiber_slot) * fiber_count);
+
+    for(u32 i = 0; i < fiber_count; ++i)
+    {
+        if(!platform_fiber_create(FIBER_STACK_SIZE, fiber_main, (void*)(u64)i, &state_ptr->fibers[i].fiber))
+        {
+            DLOG_ERROR(LOG_CATEGORY_CORE, "Failed to create fiber %u of %u.", i, fiber_count);
+            return false;
+        }
+        state_ptr->fibers[i].saved = 1;
+        // Pop order matches creation order.
+        state_ptr->free_fibers[i] = fiber_count - 1 - i;
+    }
+    state_ptr->free_count = fiber_count;
+
+    for(u32 i = 0; i < thread_count; ++i)
+    {
+        state_ptr->thread_data[i].current_fiber = FIBER_NONE;
+        state_ptr->thread_data[i].cleanup_fiber = FIBER_NONE;
+    }
+    state_ptr->main_thread.current_fiber = FIBER_NONE;
+    state_ptr->main_thread.cleanup_fiber = FIBER_NONE;
+    state_ptr->main_fiber = FIBER_NONE;
+
+    if(!platform_mutex_create(&state_ptr->lock) ||
+       !platform_condition_create(&state_ptr->work_available) ||
+       !platform_condition_create(&state_ptr->counter_done) ||
+       !platform_condition_create(&state_ptr->main_wake))
+    {
+        DLOG_ERROR(LOG_CATEGORY_CORE, "Failed to create fiber scheduler synchronization objects.");
+        return false;
+    }
+
+    if(!platform_fiber_convert_thread(&state_ptr->main_thread.thread_fiber))
+    {
+        DLOG_ERROR(LOG_CATEGORY_CORE, "Failed to convert the main thread to a fiber.");
+        return false;
+    }
+    set_thread(&state_ptr->main_thread);
+
+    for(u32 i = 0; i < thread_count; ++i)
+    {
+        if(!platform_thread_create(scheduler_thread_run, (void*)(u64)i, false, &state_ptr->threads[i]))
+        {
+            DLOG_ERROR(LOG_CATEGORY_CORE, "Failed to start fiber scheduler thread %u.", i);
+            state_ptr->thread_count = i;
+            fiber_scheduler_shutdown(state_ptr);
+            return false;
+        }
+    }
+
+    DLOG_INFO(LOG_CATEGORY_CORE, "Fiber scheduler initialized with %u threads and %u fibers.", thread_count, fiber_count);
+    return true;
+}
+
+void fiber_scheduler_shutdown(void* state)
+{
+    if(!state_ptr)
+    {
+        return;
+    }
+
+    platform_mutex_lock(&state_ptr->lock);
+    state_ptr->stopping = true;
+    platform_condition_broadcast(&state_ptr->work_available);
+    platform_mutex_unlock(&state_ptr->lock);
+
+    for(u32 i = 0; i < state_ptr->thread_count; ++i)
+    {
+        platform_thread_join(&state_ptr->threads[i], 0);
+    }
+
+    platform_fiber_convert_to_thread(&state_ptr->main_thread.thread_fiber);
+    set_thread(0);
+
+    platform_condition_destroy(&state_ptr->main_wake);
+    platform_condition_destroy(&state_ptr->counter_done);
+    platform_condition_destroy(&state_ptr->work_available);
+    platform_mutex_destroy(&state_ptr->lock);
+
+    u32 fiber_count = state_ptr->fiber_count;
+    for(u32 i = 0; i < fiber_count; ++i)
+    {
+        platform_fiber_destroy(&state_ptr->fibers[i].fiber);
+    }
+    dfree(state_ptr->fibers, sizeof(fiber_slot) * fiber_count, MEMORY_TAG_JOB);
+    dfree(state_ptr->free_fibers, sizeof(u32) * fiber_count, MEMORY_TAG_JOB);
+    dfree(state_ptr->ready_fibers, sizeof(u32) * fiber_count, MEMORY_TAG_JOB);
+    dfree(state_ptr->parked_fibers, sizeof(u32) * fiber_count, MEMORY_TAG_JOB);
+    dfree(state_ptr->tasks, sizeof(queued_task) * FIBER_TASK_QUEUE_SIZE, MEMORY_TAG_JOB);
+
+    state_ptr = 0;
+}
+
+b8 fiber_scheduler_running()
+{
+    return state_ptr != 0;
+}
+
+b8 fiber_task_submit(const fiber_task* tasks, u32 count, fiber_counter* counter)
+{
+    if(!state_ptr || !tasks)
+    {
+        return false;
+    }
+
+    platform_mutex_lock(&state_ptr->lock);
+    if(state_ptr->task_count + count > FIBER_TASK_QUEUE_SIZE)
+    {
+        platform_mutex_unlock(&state_ptr->lock);
+        DLOG_LIMITED(LOG_CATEGORY_CORE, LOG_LEVEL_WARN, 1, "Fiber task queue is full; %u tasks were not submitted.", count);
+        return false;
+    }
+
+    if(counter)
+    {
+        datomic_fetch_add_u32(&counter->value, count, DATOMIC_RELAXED);
+    }
+    for(u32 i = 0; i < count; ++i)
+    {
+        queued_task* queued = &state_ptr->tasks[(state_ptr->task_head + state_ptr->task_count) % FIBER_TASK_QUEUE_SIZE];
+        queued->task = tasks[i];
+        queued->counter = counter;
+        state_ptr->task_count++;
+    }
+    if(count == 1)
+    {
+        platform_condition_signal(&state_ptr->work_available);
+    }
+    else
+    {
+        platform_condition_broadcast(&state_ptr->work_available);
+    }
+    platform_mutex_unlock(&state_ptr->lock);
+    return true;
+}
+
+void fiber_task_run(const fiber_task* task)
+{
+    scheduler_thread* thread = get_thread();
+    if(!state_ptr || thread != &state_ptr->main_thread || thread->current_fiber != FIBER_NONE)
+    {
+        task->entry(task->params);
+        return;
+    }
+
+    platform_mutex_lock(&state_ptr->lock);
+    u32 fiber = state_ptr->free_count > 0 ? state_ptr->free_fibers[--state_ptr->free_count] : FIBER_NONE;
+    state_ptr->main_fiber = fiber;
+    state_ptr->main_ready = false;
+    platform_mutex_unlock(&state_ptr->lock);
+    if(fiber == FIBER_NONE)
+    {
+        DLOG_LIMITED(LOG_CATEGORY_CORE, LOG_LEVEL_WARN, 1, "Fiber pool exhausted; running a main thread task without a fiber.");
+        task->entry(task->params);
+        return;
+    }
+
+    state_ptr->main_task = *task;
+    for(;;)
+    {
+        thread->current_fiber = fiber;
+        platform_fiber_switch(&thread->thread_fiber, &state_ptr->fibers[fiber].fiber);
+
+        // Back on the main thread's own fiber: the task has either finished or is waiting.
+        if(thread->cleanup_action == FIBER_CLEANUP_FREE)
+        {
+            // Before the fiber returns to the pool, where another thread may park it.
+            platform_mutex_lock(&state_ptr->lock);
+            state_ptr->main_fiber = FIBER_NONE;
+            platform_mutex_unlock(&state_ptr->lock);
+            run_cleanup();
+            return;
+        }
+        run_cleanup();
+
+        platform_mutex_lock(&state_ptr->lock);
+        while(!state_ptr->main_ready)
+        {
+            platform_condition_wait(&state_ptr->main_wake, &state_ptr->lock);
+        }
+        state_ptr->main_ready = false;
+        platform_mutex_unlock(&state_ptr->lock);
+    }
+}
+
+void fiber_wait(fiber_counter* counter)
+{
+    if(!state_ptr || datomic_load_u32(&counter->value, DATOMIC_ACQUIRE) == 0)
+    {
+        return;
+    }
+
+    scheduler_thread* thread = get_thread();
+    if(!thread || thread->current_fiber == FIBER_NONE)
+    {
+        // Not on a scheduler fiber: block.
+        platform_mutex_lock(&state_ptr->lock);
+        while(datomic_load_u32(&counter->value, DATOMIC_ACQUIRE) != 0)
+        {
+            platform_condition_wait(&state_ptr->counter_done, &state_ptr->lock);
+        }
+        platform_mutex_unlock(&state_ptr->lock);
+        return;
+    }
+
+    platform_mutex_lock(&state_ptr->lock);
+    u32 next = FIBER_NONE;
+    for(;;)
+    {
+        // finish_task takes the lock after the counter reaches zero, so checking under the lock
+        // means the wake-up can't be missed.
+        if(datomic_load_u32(&counter->value, DATOMIC_ACQUIRE) == 0)
+        {
+            platform_mutex_unlock(&state_ptr->lock);
+            return;
+        }
+
+        if(thread == &state_ptr->main_thread)
+        {
+            // Park and return to fiber_task_run, which resumes this fiber once woken.
+            break;
+        }
+
+        // Carry on with a ready fiber if there is one, otherwise with a fresh one from the pool.
+        if(state_ptr->ready_count > 0)
+        {
+            next = state_ptr->ready_fibers[state_ptr->ready_head];
+            state_ptr->ready_head = (state_ptr->ready_head + 1) % state_ptr->fiber_count;
+            state_ptr->ready_count--;
+            break;
+        }
+        if(state_ptr->free_count > 0)
+        {
+            next = state_ptr->free_fibers[--state_ptr->free_count];
+            break;
+        }
+
+        // Every fiber is parked. Run a queued task on this fiber's stack, or wait for a counter to
+        // reach zero, which may make a fiber ready to switch to. New tasks don't signal
+        // counter_done, so don't sleep long.
+        queued_task task;
+        if(pop_task(&task))
+        {
+            platform_mutex_unlock(&state_ptr->lock);
+            DLOG_LIMITED(LOG_CATEGORY_CORE, LOG_LEVEL_WARN, 1, "Fiber pool exhausted; running tasks nested inside a waiting task.");
+            task.task.entry(task.task.params);
+            finish_task(task.counter);
+            platform_mutex_lock(&state_ptr->lock);
+        }
+        else
+        {
+            platform_condition_wait_timeout(&state_ptr->counter_done, &state_ptr->lock, 1);
+        }
+    }
+
+    u32 self = thread->current_fiber;
+    fiber_slot* slot = &state_ptr->fibers[self];
+    datomic_store_u32(&slot->saved, 0, DATOMIC_RELAXED);
+    slot->wait_counter = counter;
+    state_ptr->parked_fibers[state_ptr->parked_count++] = self;
+    platform_mutex_unlock(&state_ptr->lock);
+
+    switch_fiber(next, FIBER_CLEANUP_PARKED);
+    // Resumed by finish_task, via next_work or fiber_task_run: the counter is zero.
+}
\ No newline at end of file
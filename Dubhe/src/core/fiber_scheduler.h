@@ -0,0 +1,89 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+ Fiber-based task scheduler, an opt-in alternative to the job system for work that has to
+ wait on other work.
+
+ Tasks run on a pool of fibers spread over the scheduler's threads. When a task waits on a
+ counter that isn't zero yet, its fiber is parked on that counter and the thread picks up
+ another fiber, so waiting never blocks a thread. Once the counter reaches zero the parked
+ fibers are resumed, possibly on different threads.
+
+ Tasks may be submitted from any thread. The main thread is not a scheduler thread; waits
+ from it block until the counter reaches zero. It can still run a task of its own on a fiber
+ with fiber_task_run, for code which has to stay on the main thread but also wait on tasks.
+*/
+
+/**
+ * @brief A task's entry point. Runs on a fiber on one of the scheduler threads.
+ * @param params The params the task was submitted with.
+ */
+typedef void (*pfn_fiber_task)(void* params);
+
+/**
+ * A count of unfinished tasks. Zero-initialize it, pass it to fiber_task_submit, then
+ * fiber_wait on it.
+ */
+typedef struct fiber_counter
+{
+    // Atomic.
+    u32 value;
+} fiber_counter;
+
+typedef struct fiber_task
+{
+    pfn_fiber_task entry;
+    // Owned by the submitter; must stay valid until the task has finished.
+    void* params;
+} fiber_task;
+
+/**
+ * @brief Initializes the scheduler and starts its threads. Call twice: once with state 0 to
+ * get the memory requirement, then with a block of that size. Must be called from the main
+ * thread.
+ *
+ * @param memory_requirement Receives the size of the state.
+ * @param state A block of memory_requirement bytes, or 0.
+ * @param thread_count The number of scheduler threads. 0 uses one per logical processor,
+ *        less one for the main thread. Split the processors with the job system rather than
+ *        giving each its own full set.
+ * @param fiber_count The number of fibers in the pool, which bounds how many tasks can be
+ *        parked at once. 0 uses a default.
+ * @returns True on success; otherwise false.
+ */
+DAPI b8 fiber_scheduler_initialize(u64* memory_requirement, void* state, u32 thread_count, u32 fiber_count);
+
+/**
+ * @brief Finishes the queued tasks and stops the scheduler threads. Must be called from the
+ * main thread.
+ */
+DAPI void fiber_scheduler_shutdown(void* state);
+
+/**
+ * @returns True if the scheduler has been initialized.
+ */
+DAPI b8 fiber_scheduler_running();
+
+/**
+ * @brief Queues tasks. The counter, if given, is incremented by count now and decremented as
+ * each task finishes.
+ *
+ * @returns False if the scheduler is not running or the task queue is full.
+ */
+DAPI b8 fiber_task_submit(const fiber_task* tasks, u32 count, fiber_counter* counter);
+
+/**
+ * @brief Runs a task on a fiber on the main thread and returns once it has finished. When the
+ * task waits, its fiber is parked like any other but only ever resumed on the main thread, so
+ * the task can use main-thread-only systems such as job_submit. The main thread blocks while
+ * the task is parked. Called from anywhere else, the task simply runs on the calling thread.
+ */
+DAPI void fiber_task_run(const fiber_task* task);
+
+/**
+ * @brief Waits until counter reaches zero. On a scheduler fiber the fiber is parked and the
+ * thread runs other work meanwhile; on any other thread the call blocks.
+ */
+DAPI void fiber_wait(fiber_counter* counter);
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "frame_pacer.h"
+
+#include "platform/platform.h"
+
+// Starting spin margin. Covers the usual wake-up latency of a 1ms sleep.
+#define FRAME_PACER_INITIAL_MARGIN 0.002
+// Bounds on the spin margin, so one long stall or a run of punctual wake-ups cannot
+// push it to spinning whole frames or to missing deadlines.
+#define FRAME_PACER_MIN_MARGIN 0.0005
+#define FRAME_PACER_MAX_MARGIN 0.004
+
+void frame_pacer_create(frame_pacer* pacer, f32 target_frame_rate)
+{
+    pacer->target_seconds = 0.0;
+    pacer->deadline = 0.0;
+    pacer->spin_margin = FRAME_PACER_INITIAL_MARGIN;
+    frame_pacer_set_target(pacer, target_frame_rate);
+}
+
+void frame_pacer_set_target(frame_pacer* pacer, f32 target_frame_rate)
+{
+    pacer->target_seconds = target_frame_rate > 0.0f ? 1.0 / (f64)target_frame_rate : 0.0;
+    pacer->deadline = 0.0;
+}
+
+void frame_pacer_reset(frame_pacer* pacer)
+{
+    pacer->deadline = 0.0;
+}
+
+f64 frame_pacer_wait(frame_pacer* pacer)
+{
+    f64 start = platform_get_absolute_time();
+    if(pacer->target_seconds <= 0.0)
+    {
+        return 0.0;
+    }
+
+    if(pacer->deadline == 0.0)
+    {
+        // First paced frame: it started roughly now.
+        pacer->deadline = start;
+    }
+
+    f64 deadline = pacer->deadline;
+    if(start >= deadline)
+    {
+        // Overran. Keep the schedule if only slightly late; otherwise restart it from now.
+        pacer->deadline = (start - deadline > pacer->target_seconds) ? start + pacer->target_seconds : deadline + pacer->target_seconds;
+        return 0.0;
+    }
+
+    f64 remaining = deadline - start;
+    if(remaining > pacer->spin_margin)
+    {
+        u64 sleep_ms = (u64)((remaining - pacer->spin_margin) * 1000.0);
+        if(sleep_ms > 0)
+        {
+            f64 before = platform_get_absolute_time();
+            platform_sleep(sleep_ms);
+            f64 oversleep = (platform_get_absolute_time() - before) - (f64)sleep_ms * 0.001;
+
+            // Jump up to a late wake-up immediately, decay back down slowly.
+            f64 margin = oversleep > pacer->spin_margin ? oversleep : pacer->spin_margin * 0.95 + oversleep * 0.05;
+            if(margin < FRAME_PACER_MIN_MARGIN)
+            {
+                margin = FRAME_PACER_MIN_MARGIN;
+            }
+            if(margin > FRAME_PACER_MAX_MARGIN)
+            {
+                margin = FRAME_PACER_MAX_MARGIN;
+            }
+            pacer->spin_margin = margin;
+        }
+    }
+
+    f64 now = platform_get_absolute_time();
+    while(now < deadline)
+    {
+        now = platform_get_absolute_time();
+    }
+
+    pacer->deadline = deadline + pacer->target_seconds;
+    return now - start;
+}
\ No newline at end of file
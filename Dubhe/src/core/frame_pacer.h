@@ -0,0 +1,48 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+ Holds the main loop to a target frame rate. Each frame has a deadline one target period
+ after the previous one; the pacer sleeps until shortly before the deadline and spins the
+ rest, since OS sleeps only wake to within about a millisecond. The margin left for spinning
+ tracks how late recent sleeps woke up.
+*/
+typedef struct frame_pacer
+{
+    // Seconds per frame. 0 disables pacing.
+    f64 target_seconds;
+    // Absolute time the current frame should end at. 0 until the first wait.
+    f64 deadline;
+    // Time before the deadline at which sleeping stops and spinning starts, in seconds.
+    f64 spin_margin;
+} frame_pacer;
+
+/**
+ * @brief Initializes a pacer.
+ *
+ * @param pacer A pointer to the pacer to initialize.
+ * @param target_frame_rate Frames per second to pace to. 0 runs unlimited.
+ */
+DAPI void frame_pacer_create(frame_pacer* pacer, f32 target_frame_rate);
+
+/**
+ * @brief Changes the target rate. Takes effect from the next frame.
+ */
+DAPI void frame_pacer_set_target(frame_pacer* pacer, f32 target_frame_rate);
+
+/**
+ * @brief Forgets the current deadline, so the next frame is paced from the time of the
+ * next wait. Call after the loop has been stalled, e.g. while suspended.
+ */
+DAPI void frame_pacer_reset(frame_pacer* pacer);
+
+/**
+ * @brief Waits until the end of the current frame period. Returns immediately if the frame
+ * overran; if it overran by more than a whole period the schedule restarts from now rather
+ * than running frames back to back to catch up.
+ *
+ * @param pacer A pointer to the pacer.
+ * @returns The time spent waiting, in seconds.
+ */
+DAPI f64 frame_pacer_wait(frame_pacer* pacer);
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "game_module.h"
+
+#include "app_types.h"
+#include "core/logger.h"
+#include "core/dstring.h"
+#include "platform/platform.h"
+#include "platform/filesystem.h"
+
+#include <string.h>
+#include <stdio.h>
+
+typedef b8 (*pfn_app_initialize)(struct app* app_instance);
+typedef b8 (*pfn_app_update)(struct app* app_instance, f32 delta_time);
+typedef b8 (*pfn_app_render)(struct app* app_instance, f32 delta_time);
+typedef void (*pfn_app_on_resize)(struct app* app_instance, u32 width, u32 height);
+
+// Copies the built library to a path of its own and loads the copy.
+static b8 load_copy(game_module* module, u32 load_index, char* out_path, dynamic_library* out_library, app* out_callbacks)
+{
+    snprintf(out_path, GAME_MODULE_MAX_PATH, "%s.live%u", module->source_path, load_index);
+    if(!filesystem_copy(module->source_path, out_path))
+    {
+        DLOG_ERROR(LOG_CATEGORY_CORE, "Failed to copy game library '%s' to '%s'.", module->source_path, out_path);
+        filesystem_delete(out_path);
+        return false;
+    }
+    if(!platform_dynamic_library_load(out_path, out_library))
+    {
+        filesystem_delete(out_path);
+        return false;
+    }
+
+    out_callbacks->initialize = (pfn_app_initialize)platform_dynamic_library_symbol(out_library, "app_initialize");
+    out_callbacks->update = (pfn_app_update)platform_dynamic_library_symbol(out_library, "app_update");
+    out_callbacks->render = (pfn_app_render)platform_dynamic_library_symbol(out_library, "app_render");
+    out_callbacks->on_resize = (pfn_app_on_resize)platform_dynamic_library_symbol(out_library, "app_on_resize");
+    if(!out_callbacks->initialize || !out_callbacks->update || !out_callbacks->render || !out_callbacks->on_resize)
+    {
+        DLOG_ERROR(LOG_CATEGORY_CORE, "Game library '%s' must export app_initialize, app_update, app_render and app_on_resize.", module->source_path);
+        platform_dynamic_library_unload(out_library);
+        filesystem_delete(out_path);
+        return false;
+    }
+    return true;
+}
+
+static void set_callbacks(app* app_instance, const app* callbacks)
+{
+    app_instance->initialize = callbacks->initialize;
+    app_instance->update = callbacks->update;
+    app_instance->render = callbacks->render;
+    app_instance->on_resize = callbacks->on_resize;
+}
+
+b8 game_module_load(game_module* module, const char* path, app* app_instance)
+{
+    memset(module, 0, sizeof(game_module));
+    if(string_length(path) + 16 > GAME_MODULE_MAX_PATH)
+    {
+        DLOG_ERROR(LOG_CATEGORY_CORE, "Game library path '%s' is too long.", path);
+        return false;
+    }
+    strcpy(module->source_path, path);
+    if(!filesystem_last_write_time(path, &module->loaded_write_time))
+    {
+        DLOG_ERROR(LOG_CATEGORY_CORE, "Game library '%s' not found.", path);
+        return false;
+    }
+
+    app callbacks;
+    if(!load_copy(module, module->load_count, module->loaded_path, &module->library, &callbacks))
+    {
+        return false;
+    }
+    set_callbacks(app_instance, &callbacks);
+    module->load_count++;
+    module->last_poll_time = platform_get_absolute_time();
+    DLOG_INFO(LOG_CATEGORY_CORE, "Loaded game library '%s'.", path);
+    return true;
+}
+
+b8 game_module_reload_if_changed(game_module* module, app* app_instance)
+{
+    f64 now = platform_get_absolute_time();
+    if(now - module->last_poll_time < GAME_MODULE_POLL_INTERVAL)
+    {
+        return false;
+    }
+    module->last_poll_time = now;
+
+    u64 write_time;
+    if(!filesystem_last_write_time(module->source_path, &write_time) || write_time == module->loaded_write_time)
+    {
+        // Missing while the build replaces it, or unchanged.
+        module->pending_write_time = 0;
+        return false;
+    }
+    if(write_time != module->pending_write_time)
+    {
+        // Still being written, possibly; wait for it to stay the same for a whole poll.
+        module->pending_write_time = write_time;
+        return false;
+    }
+    module->pending_write_time = 0;
+    // Don't retry this build if it fails to load; the next one will be picked up.
+    module->loaded_write_time = write_time;
+
+    char path[GAME_MODULE_MAX_PATH];
+    dynamic_library library;
+    app callbacks;
+    if(!load_copy(module, module->load_count, path, &library, &callbacks))
+    {
+        DLOG_WARN(LOG_CATEGORY_CORE, "Game library reload failed; keeping the previous build.");
+        return false;
+    }
+
+    // The new build's code is in place before the old one goes.
+    set_callbacks(app_instance, &callbacks);
+    platform_dynamic_library_unload(&module->library);
+    filesystem_delete(module->loaded_path);
+    module->library = library;
+    strcpy(module->loaded_path, path);
+    module->load_count++;
+    DLOG_INFO(LOG_CATEGORY_CORE, "Reloaded game library '%s' (build %u).", module->source_path, module->load_count);
+    return true;
+}
+
+void game_module_unload(game_module* module)
+{
+    if(module->library.internal_data)
+    {
+        platform_dynamic_library_unload(&module->library);
+        filesystem_delete(module->loaded_path);
+    }
+}
\ No newline at end of file
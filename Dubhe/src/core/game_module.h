@@ -0,0 +1,61 @@
+#pragma once
+
+#include "defines.h"
+#include "platform/dynamic_library.h"
+
+struct app;
+
+/*
+ An app's callbacks loaded from a shared library, which is swapped for each new build of it
+ while the application runs.
+
+ The library exports app_initialize, app_update, app_render and app_on_resize, with the
+ signatures of the matching app callbacks. A reload replaces the library's code and static
+ data, so everything a game keeps between frames must live in app->state or other engine-owned
+ memory, keeping the same layout between builds. Pointers into the library, such as event
+ listeners and job callbacks, must not outlive the build they point into.
+*/
+
+// Longest library path supported, including the suffix of the loaded copy.
+#define GAME_MODULE_MAX_PATH 512
+// Seconds between checks of the library's write time.
+#define GAME_MODULE_POLL_INTERVAL 0.25
+
+typedef struct game_module
+{
+    // The library the build writes.
+    char source_path[GAME_MODULE_MAX_PATH];
+    // The copy that is actually loaded, so that the build can overwrite source_path
+    // (Windows locks loaded DLLs, and dlopen may hand back a cached library for the same path).
+    char loaded_path[GAME_MODULE_MAX_PATH];
+    dynamic_library library;
+    u32 load_count;
+    // Write time of source_path when it was last loaded.
+    u64 loaded_write_time;
+    // A newer write time, seen at the last poll; the library is reloaded once it stops changing.
+    u64 pending_write_time;
+    f64 last_poll_time;
+} game_module;
+
+/**
+ * @brief Loads the library at path and points app_instance's callbacks at its exports.
+ *
+ * @param module The module to load into.
+ * @param path The path of the library the build writes.
+ * @param app_instance The app whose callbacks are set.
+ * @returns True on success; otherwise false, leaving the callbacks alone.
+ */
+DAPI b8 game_module_load(game_module* module, const char* path, struct app* app_instance);
+
+/**
+ * @brief Checks whether the library was rebuilt and, if so, swaps app_instance's callbacks for
+ * the new build's. Call at a frame boundary, where no callback is running. Cheap between polls.
+ *
+ * @returns True if the library was reloaded.
+ */
+DAPI b8 game_module_reload_if_changed(game_module* module, struct app* app_instance);
+
+/**
+ * @brief Unloads the library. The app's callbacks must not be called afterwards.
+ */
+DAPI void game_module_unload(game_module* module);
\ No newline at end of file
@@ -5,6 +5,9 @@
 #include "core/logger.h"
 #include "core/event.h"
 
+#include "platform/platform.h"
+#include "platform/filesystem.h"
+
 typedef struct keyboard_state{
     b8 keys[256];
 } keyboard_state;
@@ -20,10 +23,101 @@ typedef struct input_state{
     keyboard_state keyboard_previous;
     mousebutton_state mousebutton_current;
     mousebutton_state mousebutton_previous;
+
+    // Ring buffer of raw input events.
+    input_event events[INPUT_EVENT_BUFFER_SIZE];
+    // Total number of events recorded. The next event is written at events[event_head % size].
+    u64 event_head;
+    // Value of event_head at the start of the current frame.
+    u64 event_frame_start;
+
+    // Number of input_update calls so far.
+    u32 frame_index;
+
+    b8 recording;
+    file_handle record_file;
+
+    b8 replaying;
+    // Contents of the replay file, and the offset of the next record to apply.
+    u8* replay_data;
+    u64 replay_size;
+    u64 replay_offset;
 } input_state;
 
+/*
+ Input recording file format (little endian):
+    input_recording_header
+    input_recording_record, repeated, in the order the input was processed.
+*/
+#define INPUT_RECORDING_MAGIC 0x504E4944 // "DINP"
+#define INPUT_RECORDING_VERSION 1
+
+typedef struct input_recording_header {
+    u32 magic;
+    u32 version;
+} input_recording_header;
+
+typedef struct input_recording_record {
+    // The frame_index the input was processed in.
+    u32 frame;
+    // An input_event_type.
+    u8 type;
+    // Keys and buttons: pressed. Wheel: the i8 delta.
+    u8 value;
+    // Key or button code.
+    u16 code;
+    // Mouse move position.
+    i16 x;
+    i16 y;
+} input_recording_record;
+
+STATIC_ASSERT(sizeof(input_recording_record) == 12, "Expected input_recording_record to be 12 bytes.");
+
+STATIC_ASSERT((INPUT_EVENT_BUFFER_SIZE & (INPUT_EVENT_BUFFER_SIZE - 1)) == 0, "INPUT_EVENT_BUFFER_SIZE must be a power of 2.");
+
 static input_state* state_ptr;
 
+static void record_event(input_event_type type, u16 code, b8 pressed, i8 z_delta)
+{
+    if(!state_ptr)
+    {
+        return;
+    }
+    if(state_ptr->event_head - state_ptr->event_frame_start == INPUT_EVENT_BUFFER_SIZE)
+    {
+        // Full for this frame: drop the oldest.
+        state_ptr->event_frame_start++;
+        DLOG_LIMITED(LOG_CATEGORY_INPUT, LOG_LEVEL_WARN, 1, "Input event buffer is full, dropping the oldest events of this frame.");
+    }
+
+    input_event* e = &state_ptr->events[state_ptr->event_head & (INPUT_EVENT_BUFFER_SIZE - 1)];
+    e->timestamp = platform_get_absolute_time();
+    e->type = (u8)type;
+    e->pressed = pressed;
+    e->z_delta = z_delta;
+    e->code = code;
+    e->x = state_ptr->mousebutton_current.x;
+    e->y = state_ptr->mousebutton_current.y;
+    state_ptr->event_head++;
+
+    if(state_ptr->recording)
+    {
+        input_recording_record record;
+        record.frame = state_ptr->frame_index;
+        record.type = (u8)type;
+        record.value = type == INPUT_EVENT_MOUSE_WHEEL ? (u8)z_delta : (u8)pressed;
+        record.code = code;
+        record.x = state_ptr->mousebutton_current.x;
+        record.y = state_ptr->mousebutton_current.y;
+        u64 written = 0;
+        if(!filesystem_write(&state_ptr->record_file, sizeof(record), &record, &written))
+        {
+            DLOG_ERROR(LOG_CATEGORY_INPUT, "Failed to write input recording, stopping.");
+            input_record_stop();
+        }
+    }
+}
+
 void input_system_initialize(u64* memory_requirement, void* state)
 {
     *memory_requirement = sizeof(input_state);
@@ -31,13 +125,15 @@ void input_system_initialize(u64* memory_requirement, void* state)
     {
         return;
     }
-    dzero_memory(state, sizeof(state));
+    dzero_memory(state, sizeof(input_state));
     state_ptr = state;
-    DINFO("Input subsystem initialized.");
+    DLOG_INFO(LOG_CATEGORY_INPUT, "Input subsystem initialized.");
 }
 
 void input_system_shutdown(void* state)
 {
+    input_record_stop();
+    input_replay_stop();
     // TODO: Add shutdown routines when needed.
     state_ptr = 0;
 }
@@ -52,13 +148,18 @@ void input_update(f64 delta_time)
     // Copy current states to previous states.
     dcopy_memory(&state_ptr->keyboard_previous, &state_ptr->keyboard_current, sizeof(state_ptr->keyboard_current));
     dcopy_memory(&state_ptr->mousebutton_previous, &state_ptr->mousebutton_current, sizeof(state_ptr->mousebutton_current));
+
+    // Start a new frame of raw events.
+    state_ptr->event_frame_start = state_ptr->event_head;
+    state_ptr->frame_index++;
 }
 
-void input_process_key(key_code key, b8 pressed)
+static void apply_key(key_code key, b8 pressed)
 {
     if(state_ptr && state_ptr->keyboard_current.keys[key] != pressed)
     {
         state_ptr->keyboard_current.keys[key] = pressed;
+        record_event(INPUT_EVENT_KEY, key, pressed, 0);
 
         // if (key == KEY_LALT) 
         // {
@@ -95,11 +196,12 @@ void input_process_key(key_code key, b8 pressed)
     }
 }
 
-void input_process_button(mouse_button button, b8 pressed)
+static void apply_button(mouse_button button, b8 pressed)
 {
     if(state_ptr->mousebutton_current.buttons[button] != pressed)
     {
         state_ptr->mousebutton_current.buttons[button] = pressed;
+        record_event(INPUT_EVENT_BUTTON, button, pressed, 0);
 
         event_context data;
         data.data.u16[0] = button;
@@ -109,25 +211,63 @@ void input_process_button(mouse_button button, b8 pressed)
     }
 }
 
-void input_process_mouse_move(i16 x, i16 y)
+static void apply_mouse_move(i16 x, i16 y)
 {
     if(state_ptr->mousebutton_current.x != x || state_ptr->mousebutton_current.y != y)
     {
         state_ptr->mousebutton_current.x = x;
         state_ptr->mousebutton_current.y = y;
+        record_event(INPUT_EVENT_MOUSE_MOVE, 0, false, 0);
 
         event_context data;
         data.data.u16[0] = x;
         data.data.u16[1] = y;
-        event_fire(EVENT_CODE_MOUSE_MOVE, 0, data);
+        // Posted so that a burst of OS move messages collapses into one dispatch per frame.
+        event_post(EVENT_CODE_MOUSE_MOVE, 0, data);
     }
 }
 
-void input_process_mouse_wheel(i8 z_delta)
+static void apply_mouse_wheel(i8 z_delta)
 {
+    record_event(INPUT_EVENT_MOUSE_WHEEL, 0, false, z_delta);
+
     event_context data;
-    data.data.u8[0] = z_delta;
-    event_fire(EVENT_CODE_MOUSE_WHEEL, 0, data);
+    data.data.i8[0] = z_delta;
+    // Posted so that the frame's deltas are accumulated into one dispatch.
+    event_post(EVENT_CODE_MOUSE_WHEEL, 0, data);
+}
+
+void input_process_key(key_code key, b8 pressed)
+{
+    // Live input is ignored while replaying.
+    if(state_ptr && !state_ptr->replaying)
+    {
+        apply_key(key, pressed);
+    }
+}
+
+void input_process_button(mouse_button button, b8 pressed)
+{
+    if(state_ptr && !state_ptr->replaying)
+    {
+        apply_button(button, pressed);
+    }
+}
+
+void input_process_mouse_move(i16 x, i16 y)
+{
+    if(state_ptr && !state_ptr->replaying)
+    {
+        apply_mouse_move(x, y);
+    }
+}
+
+void input_process_mouse_wheel(i8 z_delta)
+{
+    if(state_ptr && !state_ptr->replaying)
+    {
+        apply_mouse_wheel(z_delta);
+    }
 }
 
 b8 input_is_key_down(key_code key)
@@ -222,4 +362,187 @@ void input_get_prev_mouse_pos(i32* x, i32* y)
     }
     *x = state_ptr->mousebutton_previous.x;
     *y = state_ptr->mousebutton_previous.y;
+}
+
+u32 input_event_count()
+{
+    if(!state_ptr)
+    {
+        return 0;
+    }
+    return (u32)(state_ptr->event_head - state_ptr->event_frame_start);
+}
+
+const input_event* input_event_get(u32 index)
+{
+    if(!state_ptr || index >= input_event_count())
+    {
+        return 0;
+    }
+    return &state_ptr->events[(state_ptr->event_frame_start + index) & (INPUT_EVENT_BUFFER_SIZE - 1)];
+}
+
+b8 input_record_start(const char* path)
+{
+    if(!state_ptr)
+    {
+        return false;
+    }
+    input_record_stop();
+
+    if(!filesystem_open(path, FILE_MODE_WRITE, true, &state_ptr->record_file))
+    {
+        DLOG_ERROR(LOG_CATEGORY_INPUT, "Unable to open input recording file '%s'.", path);
+        return false;
+    }
+
+    // Buffered, and flushed on a crash so the input leading up to it is kept.
+    file_write_buffer_config config;
+    config.buffer_size = 64 * 1024;
+    config.flush_policy = FILE_FLUSH_ON_SIZE | FILE_FLUSH_ON_CRASH;
+    config.flush_interval = 0.0;
+    filesystem_enable_write_buffer(&state_ptr->record_file, &config);
+
+    input_recording_header header;
+    header.magic = INPUT_RECORDING_MAGIC;
+    header.version = INPUT_RECORDING_VERSION;
+    u64 written = 0;
+    if(!filesystem_write(&state_ptr->record_file, sizeof(header), &header, &written))
+    {
+        filesystem_close(&state_ptr->record_file);
+        return false;
+    }
+
+    state_ptr->recording = true;
+    // Frame indices in the file are relative to the start of the recording.
+    state_ptr->frame_index = 0;
+    DLOG_INFO(LOG_CATEGORY_INPUT, "Recording input to '%s'.", path);
+    return true;
+}
+
+void input_record_stop()
+{
+    if(state_ptr && state_ptr->recording)
+    {
+        state_ptr->recording = false;
+        filesystem_close(&state_ptr->record_file);
+    }
+}
+
+b8 input_replay_start(const char* path)
+{
+    if(!state_ptr)
+    {
+        return false;
+    }
+    input_replay_stop();
+
+    file_handle file;
+    if(!filesystem_open(path, FILE_MODE_READ, true, &file))
+    {
+        DLOG_ERROR(LOG_CATEGORY_INPUT, "Unable to open input replay file '%s'.", path);
+        return false;
+    }
+    u8* data = 0;
+    u64 size = 0;
+    b8 result = filesystem_read_all_bytes(&file, &data, &size);
+    filesystem_close(&file);
+
+    input_recording_header header;
+    if(result && size >= sizeof(header))
+    {
+        dcopy_memory(&header, data, sizeof(header));
+    }
+    if(!result || size < sizeof(header) || header.magic != INPUT_RECORDING_MAGIC || header.version != INPUT_RECORDING_VERSION)
+    {
+        DLOG_ERROR(LOG_CATEGORY_INPUT, "'%s' is not a valid input recording.", path);
+        if(data)
+        {
+            dfree(data, size, MEMORY_TAG_STRING);
+        }
+        return false;
+    }
+
+    state_ptr->replay_data = data;
+    state_ptr->replay_size = size;
+    state_ptr->replay_offset = sizeof(header);
+    state_ptr->replaying = true;
+    // Frame indices in the file are relative to the start of the recording.
+    state_ptr->frame_index = 0;
+    DLOG_INFO(LOG_CATEGORY_INPUT, "Replaying input from '%s' (%llu records).", path, (size - sizeof(header)) / sizeof(input_recording_record));
+    return true;
+}
+
+void input_replay_stop()
+{
+    if(state_ptr && state_ptr->replay_data)
+    {
+        dfree(state_ptr->replay_data, state_ptr->replay_size, MEMORY_TAG_STRING);
+        state_ptr->replay_data = 0;
+        state_ptr->replay_size = 0;
+        state_ptr->replay_offset = 0;
+    }
+    if(state_ptr)
+    {
+        state_ptr->replaying = false;
+    }
+}
+
+b8 input_replay_active()
+{
+    return state_ptr && state_ptr->replaying;
+}
+
+b8 input_replay_update()
+{
+    if(!state_ptr || !state_ptr->replaying)
+    {
+        return false;
+    }
+
+    while(state_ptr->replay_offset + sizeof(input_recording_record) <= state_ptr->replay_size)
+    {
+        input_recording_record record;
+        dcopy_memory(&record, state_ptr->replay_data + state_ptr->replay_offset, sizeof(record));
+        if(record.frame > state_ptr->frame_index)
+        {
+            // Belongs to a later frame.
+            return true;
+        }
+        state_ptr->replay_offset += sizeof(record);
+
+        // Recordings come from disk, so codes are checked before they index the state.
+        switch(record.type)
+        {
+            case INPUT_EVENT_KEY:
+                if(record.code >= sizeof(state_ptr->keyboard_current.keys))
+                {
+                    DLOG_WARN(LOG_CATEGORY_INPUT, "Skipping unknown input record: key code %u.", record.code);
+                    break;
+                }
+                apply_key((key_code)record.code, record.value != 0);
+                break;
+            case INPUT_EVENT_BUTTON:
+                if(record.code >= MOUSEBUTTONS_COUNT)
+                {
+                    DLOG_WARN(LOG_CATEGORY_INPUT, "Skipping unknown input record: button code %u.", record.code);
+                    break;
+                }
+                apply_button((mouse_button)record.code, record.value != 0);
+                break;
+            case INPUT_EVENT_MOUSE_MOVE:
+                apply_mouse_move(record.x, record.y);
+                break;
+            case INPUT_EVENT_MOUSE_WHEEL:
+                apply_mouse_wheel((i8)record.value);
+                break;
+            default:
+                DLOG_WARN(LOG_CATEGORY_INPUT, "Skipping unknown input record: type %u.", record.type);
+                break;
+        }
+    }
+
+    DLOG_INFO(LOG_CATEGORY_INPUT, "Input replay finished after %u frames.", state_ptr->frame_index);
+    input_replay_stop();
+    return false;
 }
\ No newline at end of file
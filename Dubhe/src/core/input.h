@@ -144,9 +144,9 @@ typedef enum key_code {
     KEYS_MAX_KEYS
 } key_code;
 
-void input_system_initialize();
-void input_system_shutdown();
-void input_update(f64 delta_time);
+DAPI void input_system_initialize(u64* memory_requirement, void* state);
+DAPI void input_system_shutdown(void* state);
+DAPI void input_update(f64 delta_time);
 
 // Query keyboards state
 DAPI b8 input_is_key_down(key_code key);
@@ -154,7 +154,7 @@ DAPI b8 input_was_key_down(key_code key);
 DAPI b8 input_is_key_up(key_code key);
 DAPI b8 input_was_key_up(key_code key);
 
-void input_process_key(key_code key, b8 pressed);
+DAPI void input_process_key(key_code key, b8 pressed);
 
 // Query mousebuttons state
 DAPI b8 input_is_button_down(mouse_button button);
@@ -164,7 +164,92 @@ DAPI b8 input_was_button_up(mouse_button button);
 DAPI void input_get_mouse_pos(i32* x, i32* y);
 DAPI void input_get_prev_mouse_pos(i32* x, i32* y);
 
-void input_process_button(mouse_button button, b8 pressed);
-void input_process_mouse_move(i16 x, i16 y);
-void input_process_mouse_wheel(i8 z_delta);
-
+DAPI void input_process_button(mouse_button button, b8 pressed);
+DAPI void input_process_mouse_move(i16 x, i16 y);
+DAPI void input_process_mouse_wheel(i8 z_delta);
+
+typedef enum input_event_type {
+    INPUT_EVENT_KEY = 0,
+    INPUT_EVENT_BUTTON,
+    INPUT_EVENT_MOUSE_MOVE,
+    INPUT_EVENT_MOUSE_WHEEL
+} input_event_type;
+
+/*
+ A raw input event, recorded in the order the platform delivered it.
+ Unlike the current/previous snapshots, every change within a frame is kept.
+*/
+typedef struct input_event {
+    // Time the event was processed, in seconds (platform_get_absolute_time).
+    f64 timestamp;
+    // An input_event_type.
+    u8 type;
+    // INPUT_EVENT_KEY and INPUT_EVENT_BUTTON: true if pressed, false if released.
+    b8 pressed;
+    // INPUT_EVENT_MOUSE_WHEEL: the wheel delta.
+    i8 z_delta;
+    // INPUT_EVENT_KEY: the key_code. INPUT_EVENT_BUTTON: the mouse_button.
+    u16 code;
+    // INPUT_EVENT_MOUSE_MOVE: the new mouse position. Other types: the position at the time.
+    i16 x;
+    i16 y;
+} input_event;
+
+// Number of raw input events buffered. If a frame receives more, the oldest are dropped.
+#define INPUT_EVENT_BUFFER_SIZE 1024
+
+/**
+ * @brief Gets the number of raw input events received during the current frame, i.e. since
+ * the last input_update.
+ */
+DAPI u32 input_event_count();
+
+/**
+ * @brief Gets a raw input event of the current frame, in the order they were received.
+ *
+ * @param index The index of the event, from 0 to input_event_count() - 1.
+ * @return A pointer to the event, valid until the next input_update; or 0 if index is out of range.
+ */
+DAPI const input_event* input_event_get(u32 index);
+
+/**
+ * @brief Starts recording every processed key, button, mouse move and wheel change, with the
+ * index of the frame it happened in, to a compact binary file. Replaces any recording in progress.
+ *
+ * @param path The path of the file to write.
+ * @return True if recording started; otherwise false.
+ */
+DAPI b8 input_record_start(const char* path);
+
+/**
+ * @brief Stops recording and closes the file. Does nothing if not recording.
+ */
+DAPI void input_record_stop();
+
+/**
+ * @brief Starts replaying a file written by input_record_start. While replaying, live input
+ * from the platform is ignored and input_replay_update feeds the recorded input back
+ * frame by frame, starting from frame 0.
+ *
+ * @param path The path of the recording.
+ * @return True if the file was loaded and replay started; otherwise false.
+ */
+DAPI b8 input_replay_start(const char* path);
+
+/**
+ * @brief Stops replaying and returns to live input.
+ */
+DAPI void input_replay_stop();
+
+/**
+ * @brief Returns true while a replay is in progress.
+ */
+DAPI b8 input_replay_active();
+
+/**
+ * @brief Applies the recorded input of the current frame. Called by the application once per
+ * frame, before posted events are dispatched.
+ *
+ * @return True if the replay continues; false if it is not active or has just finished.
+ */
+DAPI b8 input_replay_update();
\ No newline at end of file
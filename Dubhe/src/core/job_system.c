@@ -0,0 +1,502 @@
+#include "job_system.h"
+
+#include "core/logger.h"
+#include "core/dmemory.h"
+#include "containers/mpsc_queue.h"
+#include "platform/thread.h"
+#include "platform/atomic.h"
+
+#include <stdio.h>
+
+// Most job threads started, regardless of the processor count.
+#define JOB_SYSTEM_MAX_THREADS 32
+// Jobs each deque can hold. Must be a power of 2.
+#define JOB_DEQUE_CAPACITY 1024
+// Finished jobs whose completion callbacks can wait for the main thread at once.
+#define JOB_COMPLETION_QUEUE_SIZE 4096
+// Empty polls of the deques before an idle job thread goes to sleep.
+#define JOB_IDLE_SPIN_COUNT 256
+// queue_index of threads which may not submit jobs.
+#define JOB_NO_QUEUE 0xFFFFFFFFu
+
+/*
+ Chase-Lev deque with a fixed capacity. The owning thread pushes and pops at the bottom;
+ any thread steals from the top. Both indices only grow and are masked on access.
+*/
+typedef struct job_deque
+{
+    // Next index to steal. Atomic.
+    u64 top;
+    u8 pad0[56];
+    // Next index to push. Atomic; only written by the owner.
+    u64 bottom;
+    u8 pad1[56];
+    job_info* jobs;
+} job_deque;
+
+typedef struct job_thread_queues
+{
+    job_deque deques[JOB_PRIORITY_COUNT];
+} job_thread_queues;
+
+typedef struct job_completion
+{
+    pfn_job_complete on_complete;
+    void* params;
+} job_completion;
+
+typedef struct job_system_state
+{
+    u32 thread_count;
+    platform_thread threads[JOB_SYSTEM_MAX_THREADS];
+
+    // Logical processors the job threads are restricted to. 0 leaves them to the OS.
+    u32 processor_count;
+    u32 processor_ids[PLATFORM_MAX_LOGICAL_PROCESSORS];
+
+    // thread_count + 1 sets of deques. The last set belongs to the main thread.
+    job_thread_queues* queues;
+
+    // Set at shutdown. Atomic.
+    u32 stopping;
+    // Job threads asleep or about to sleep on wake. Atomic.
+    u32 sleeping;
+    platform_semaphore wake;
+
+    // Finished jobs with a completion callback, for the main thread.
+    mpsc_queue completions;
+    // Submitted jobs with a completion callback which job_system_update hasn't popped yet.
+    // Kept within JOB_COMPLETION_QUEUE_SIZE, so pushing a completion can't fail. Atomic.
+    u32 completions_outstanding;
+} job_system_state;
+
+static job_system_state* state_ptr;
+
+// Index of the calling thread's deques in state_ptr->queues.
+static DTHREAD_LOCAL u32 queue_index = JOB_NO_QUEUE;
+
+static b8 deque_push(job_deque* deque, const job_info* job)
+{
+    i64 bottom = (i64)datomic_load_u64(&deque->bottom, DATOMIC_RELAXED);
+    i64 top = (i64)datomic_load_u64(&deque->top, DATOMIC_ACQUIRE);
+    if(bottom - top >= JOB_DEQUE_CAPACITY)
+    {
+        return false;
+    }
+
+    deque->jobs[bottom & (JOB_DEQUE_CAPACITY - 1)] = *job;
+    datomic_store_u64(&deque->bottom, (u64)(bottom + 1), DATOMIC_RELEASE);
+    return true;
+}
+
+static b8 deque_pop(job_deque* deque, job_info* out_job)
+{
+    // Reserve the bottom job before looking at top, so a thief can't take it as well.
+    i64 bottom = (i64)datomic_load_u64(&deque->bottom, DATOMIC_RELAXED) - 1;
+    datomic_store_u64(&deque->bottom, (u64)bottom, DATOMIC_RELAXED);
+    datomic_thread_fence(DATOMIC_SEQ_CST);
+    i64 top = (i64)datomic_load_u64(&deque->top, DATOMIC_RELAXED);
+
+    if(top > bottom)
+    {
+        // Empty.
+        datomic_store_u64(&deque->bottom, (u64)(bottom + 1), DATOMIC_RELAXED);
+        return false;
+    }
+
+    *out_job = deque->jobs[bottom & (JOB_DEQUE_CAPACITY - 1)];
+    if(top != bottom)
+    {
+        return true;
+    }
+
+    // The last job: thieves may be after it too.
+    u64 expected = (u64)top;
+    b8 won = datomic_compare_exchange_strong_u64(&deque->top, &expected, (u64)(top + 1), DATOMIC_SEQ_CST);
+    datomic_store_u64(&deque->bottom, (u64)(bottom + 1), DATOMIC_RELAXED);
+    return won;
+}
+
+static b8 deque_steal(job_deque* deque, job_info* out_job)
+{
+    i64 top = (i64)datomic_load_u64(&deque->top, DATOMIC_ACQUIRE);
+    datomic_thread_fence(DATOMIC_SEQ_CST);
+    i64 bottom = (i64)datomic_load_u64(&deque->bottom, DATOMIC_ACQUIRE);
+    if(top >= bottom)
+    {
+        return false;
+    }
+
+    // The slot cannot be reused while top still equals this value, so the copy is only
+    // torn if the exchange below fails, in which case it is discarded.
+    job_info job = deque->jobs[top & (JOB_DEQUE_CAPACITY - 1)];
+    u64 expected = (u64)top;
+    if(!datomic_compare_exchange_strong_u64(&deque->top, &expected, (u64)(top + 1), DATOMIC_SEQ_CST))
+    {
+        return false;
+    }
+    *out_job = job;
+    return true;
+}
+
+/**
+ * Takes the highest priority job available to the thread owning queues[index]: its own
+ * deque first, then the other threads' deques.
+ */
+static b8 find_job(u32 index, job_info* out_job)
+{
+    u32 queue_count = state_ptr->thread_count + 1;
+    for(u32 priority = 0; priority < JOB_PRIORITY_COUNT; ++priority)
+    {
+        if(deque_pop(&state_ptr->queues[index].deques[priority], out_job))
+        {
+            return true;
+        }
+        for(u32 i = 1; i < queue_count; ++i)
+        {
+            u32 victim = (index + i) % queue_count;
+            if(deque_steal(&state_ptr->queues[victim].deques[priority], out_job))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void run_job(const job_info* job)
+{
+    job->entry(job->params);
+
+    // The completion is queued before the counter drops, so a job_system_update after
+    // job_wait returns always runs it.
+    if(job->on_complete)
+    {
+        job_completion completion;
+        completion.on_complete = job->on_complete;
+        completion.params = job->params;
+        // Can't fail: job_submit reserved room for it.
+        mpsc_queue_push(&state_ptr->completions, &completion);
+    }
+
+    if(job->counter)
+    {
+        datomic_fetch_sub_u32(&job->counter->value, 1, DATOMIC_RELEASE);
+    }
+}
+
+static u32 job_thread_run(void* params)
+{
+    u32 index = (u32)(u64)params;
+    queue_index = index;
+
+    char name[16];
+    snprintf(name, sizeof(name), "dubhe-job-%u", index);
+    platform_thread_set_name(name);
+    if(state_ptr->processor_count > 0)
+    {
+        platform_thread_set_affinity(state_ptr->processor_ids, state_ptr->processor_count);
+    }
+
+    u32 idle_count = 0;
+    for(;;)
+    {
+        job_info job;
+        if(find_job(index, &job))
+        {
+            run_job(&job);
+            idle_count = 0;
+            continue;
+        }
+
+        // Queued jobs are finished before exiting.
+        if(datomic_load_u32(&state_ptr->stopping, DATOMIC_ACQUIRE))
+        {
+            break;
+        }
+
+        if(++idle_count < JOB_IDLE_SPIN_COUNT)
+        {
+            datomic_pause();
+            continue;
+        }
+
+        // Announce the sleep before the final check, so a concurrent job_submit either
+        // sees this thread as sleeping or has its job found here.
+        datomic_fetch_add_u32(&state_ptr->sleeping, 1, DATOMIC_SEQ_CST);
+        if(find_job(index, &job))
+        {
+            datomic_fetch_sub_u32(&state_ptr->sleeping, 1, DATOMIC_SEQ_CST);
+            run_job(&job);
+            idle_count = 0;
+            continue;
+        }
+        if(!datomic_load_u32(&state_ptr->stopping, DATOMIC_ACQUIRE))
+        {
+            platform_semaphore_wait(&state_ptr->wake);
+        }
+        datomic_fetch_sub_u32(&state_ptr->sleeping, 1, DATOMIC_SEQ_CST);
+        idle_count = 0;
+    }
+
+    return 0;
+}
+
+/*
+ Picks the processors for the job threads: one hardware thread of each core on the calling
+ thread's NUMA node, other than the calling thread's own core. Keeps job threads off each
+ other's SMT siblings and their data on the node's memory. The hardware threads of the core
+ left out go in out_main_processor_ids, for the main thread. Returns 0 on machines with no
+ SMT and a single node, where there is nothing to avoid.
+*/
+static u32 select_job_processors(u32* out_processor_ids, u32* out_main_processor_ids, u32* out_main_processor_count)
+{
+    *out_main_processor_count = 0;
+    platform_cpu_topology topology;
+    if(!platform_get_cpu_topology(&topology))
+    {
+        DLOG_WARN(LOG_CATEGORY_CORE, "CPU topology unavailable; job threads are not pinned.");
+        return 0;
+    }
+    DLOG_INFO(LOG_CATEGORY_CORE, "CPU: %u logical processors, %u cores, %u NUMA nodes, L1d %lluKB, L2 %lluKB, L3 %lluKB.",
+        topology.logical_processor_count, topology.physical_core_count, topology.numa_node_count,
+        topology.l1_data_cache_size / 1024, topology.l2_cache_size / 1024, topology.l3_cache_size / 1024);
+    if(topology.numa_node_count == 1 && topology.physical_core_count == topology.logical_processor_count)
+    {
+        return 0;
+    }
+
+    u32 current_id = platform_thread_current_processor();
+    platform_logical_processor* current = &topology.processors[0];
+    for(u32 i = 0; i < topology.logical_processor_count; ++i)
+    {
+        if(topology.processors[i].id == current_id)
+        {
+            current = &topology.processors[i];
+            break;
+        }
+    }
+
+    u32 count = 0;
+    for(u32 i = 0; i < topology.logical_processor_count; ++i)
+    {
+        platform_logical_processor* processor = &topology.processors[i];
+        if(processor->core == current->core)
+        {
+            out_main_processor_ids[(*out_main_processor_count)++] = processor->id;
+        }
+        else if(processor->smt_index == 0 && processor->numa_node == current->numa_node)
+        {
+            out_processor_ids[count++] = processor->id;
+        }
+    }
+    return count;
+}
+
+b8 job_system_initialize(u64* memory_requirement, void* state, u32 thread_count)
+{
+    *memory_requirement = sizeof(job_system_state);
+    if(state == 0)
+    {
+        return true;
+    }
+
+    state_ptr = state;
+    dzero_memory(state_ptr, sizeof(job_system_state));
+    u32 main_processor_ids[PLATFORM_MAX_LOGICAL_PROCESSORS];
+    u32 main_processor_count = 0;
+    state_ptr->processor_count = select_job_processors(state_ptr->processor_ids, main_processor_ids, &main_processor_count);
+
+    if(thread_count == 0)
+    {
+        // The main thread runs jobs while it waits, so leave it a processor.
+        u32 processor_count = platform_get_processor_count();
+        thread_count = processor_count > 1 ? processor_count - 1 : 1;
+        if(state_ptr->processor_count > 0)
+        {
+            thread_count = state_ptr->processor_count;
+        }
+    }
+    if(thread_count > JOB_SYSTEM_MAX_THREADS)
+    {
+        thread_count = JOB_SYSTEM_MAX_THREADS;
+    }
+    if(thread_count > state_ptr->processor_count && state_ptr->processor_count > 0)
+    {
+        // More threads than chosen cores would have them share cores anyway.
+        DLOG_INFO(LOG_CATEGORY_CORE, "%u job threads requested for %u cores; job threads are not pinned.", thread_count, state_ptr->processor_count);
+        state_ptr->processor_count = 0;
+    }
+    if(state_ptr->processor_count > 0)
+    {
+        // The job threads were placed around the core the main thread is on now; keep it there,
+        // or the scheduler may move it onto a job thread's core.
+        if(!platform_thread_set_affinity(main_processor_ids, main_processor_count))
+        {
+            DLOG_WARN(LOG_CATEGORY_CORE, "Failed to pin the main thread; job threads are not pinned.");
+            state_ptr->processor_count = 0;
+        }
+    }
+    state_ptr->thread_count = thread_count;
+
+    u32 queue_count = thread_count + 1;
+    state_ptr->queues = dallocate(sizeof(job_thread_queues) * queue_count, MEMORY_TAG_JOB);
+    dzero_memory(state_ptr->queues, sizeof(job_thread_queues) * queue_count);
+    for(u32 i = 0; i < queue_count; ++i)
+    {
+        for(u32 priority = 0; priority < JOB_PRIORITY_COUNT; ++priority)
+        {
+            state_ptr->queues[i].deques[priority].jobs = dallocate(sizeof(job_info) * JOB_DEQUE_CAPACITY, MEMORY_TAG_JOB);
+        }
+    }
+
+    if(!mpsc_queue_create(JOB_COMPLETION_QUEUE_SIZE, sizeof(job_completion), &state_ptr->completions) ||
+       !platform_semaphore_create(0, 0x7FFFFFFF, &state_ptr->wake))
+    {
+        DLOG_ERROR(LOG_CATEGORY_CORE, "Failed to create job system queues.");
+        return false;
+    }
+
+    // The calling thread is the main thread.
+    queue_index = thread_count;
+
+    for(u32 i = 0; i < thread_count; ++i)
+    {
+        if(!platform_thread_create(job_thread_run, (void*)(u64)i, false, &state_ptr->threads[i]))
+        {
+            DLOG_ERROR(LOG_CATEGORY_CORE, "Failed to start job thread %u.", i);
+            state_ptr->thread_count = i;
+            job_system_shutdown(state_ptr);
+            return false;
+        }
+    }
+
+    DLOG_INFO(LOG_CATEGORY_CORE, "Job system initialized with %u threads%s.", thread_count, state_ptr->processor_count > 0 ? " on separate cores" : "");
+    return true;
+}
+
+void job_system_shutdown(void* state)
+{
+    if(!state_ptr)
+    {
+        return;
+    }
+
+    datomic_store_u32(&state_ptr->stopping, 1, DATOMIC_RELEASE);
+    platform_semaphore_signal(&state_ptr->wake, state_ptr->thread_count);
+    for(u32 i = 0; i < state_ptr->thread_count; ++i)
+    {
+        platform_thread_join(&state_ptr->threads[i], 0);
+    }
+
+    // Job threads steal the main thread's jobs too, so everything has run by now.
+    job_system_update();
+
+    platform_semaphore_destroy(&state_ptr->wake);
+    mpsc_queue_destroy(&state_ptr->completions);
+    u32 queue_count = state_ptr->thread_count + 1;
+    for(u32 i = 0; i < queue_count; ++i)
+    {
+        for(u32 priority = 0; priority < JOB_PRIORITY_COUNT; ++priority)
+        {
+            dfree(state_ptr->queues[i].deques[priority].jobs, sizeof(job_info) * JOB_DEQUE_CAPACITY, MEMORY_TAG_JOB);
+        }
+    }
+    dfree(state_ptr->queues, sizeof(job_thread_queues) * queue_count, MEMORY_TAG_JOB);
+
+    queue_index = JOB_NO_QUEUE;
+    state_ptr = 0;
+}
+
+void job_system_update()
+{
+    if(!state_ptr)
+    {
+        return;
+    }
+
+    // Only run what finished before this point; jobs completing meanwhile wait for next frame.
+    u64 count = mpsc_queue_claimed(&state_ptr->completions) - mpsc_queue_consumed(&state_ptr->completions);
+    job_completion completion;
+    for(u64 i = 0; i < count && mpsc_queue_pop(&state_ptr->completions, &completion); ++i)
+    {
+        datomic_fetch_sub_u32(&state_ptr->completions_outstanding, 1, DATOMIC_RELEASE);
+        completion.on_complete(completion.params);
+    }
+}
+
+b8 job_submit(const job_info* info)
+{
+    if(!state_ptr || !info || !info->entry)
+    {
+        return false;
+    }
+    if(queue_index > state_ptr->thread_count)
+    {
+        DLOG_ERROR(LOG_CATEGORY_CORE, "job_submit called from a thread which is not the main thread or a job thread.");
+        return false;
+    }
+
+    if(info->on_complete)
+    {
+        // Reserve room for the completion, so the job never waits on the main thread to finish.
+        u32 outstanding = datomic_load_u32(&state_ptr->completions_outstanding, DATOMIC_ACQUIRE);
+        do
+        {
+            if(outstanding >= JOB_COMPLETION_QUEUE_SIZE)
+            {
+                DLOG_LIMITED(LOG_CATEGORY_CORE, LOG_LEVEL_WARN, 1, "Too many jobs are waiting for completion callbacks; job not submitted.");
+                return false;
+            }
+        } while(!datomic_compare_exchange_weak_u32(&state_ptr->completions_outstanding, &outstanding, outstanding + 1, DATOMIC_ACQ_REL));
+    }
+
+    if(info->counter)
+    {
+        datomic_fetch_add_u32(&info->counter->value, 1, DATOMIC_RELAXED);
+    }
+
+    job_priority priority = info->priority < JOB_PRIORITY_COUNT ? info->priority : JOB_PRIORITY_NORMAL;
+    if(!deque_push(&state_ptr->queues[queue_index].deques[priority], info))
+    {
+        DLOG_LIMITED(LOG_CATEGORY_CORE, LOG_LEVEL_WARN, 1, "Job queue is full; running the job on the submitting thread.");
+        run_job(info);
+        return true;
+    }
+
+    // Pairs with the sleeping announcement in job_thread_run.
+    datomic_thread_fence(DATOMIC_SEQ_CST);
+    if(datomic_load_u32(&state_ptr->sleeping, DATOMIC_RELAXED) > 0)
+    {
+        platform_semaphore_signal(&state_ptr->wake, 1);
+    }
+    return true;
+}
+
+void job_wait(job_counter* counter)
+{
+    u32 idle_count = 0;
+    while(datomic_load_u32(&counter->value, DATOMIC_ACQUIRE) != 0)
+    {
+        job_info job;
+        if(state_ptr && queue_index <= state_ptr->thread_count && find_job(queue_index, &job))
+        {
+            run_job(&job);
+            idle_count = 0;
+        }
+        else if(++idle_count < JOB_IDLE_SPIN_COUNT)
+        {
+            datomic_pause();
+        }
+        else
+        {
+            // The remaining jobs are running elsewhere.
+            platform_thread_yield();
+        }
+    }
+}
+
+u32 job_system_thread_count()
+{
+    return state_ptr ? state_ptr->thread_count : 0;
+}
\ No newline at end of file
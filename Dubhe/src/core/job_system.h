@@ -0,0 +1,107 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+ Work-stealing job system.
+
+ Each job thread owns one Chase-Lev deque per priority. A thread pushes and pops jobs at the
+ bottom of its own deques and, when they are empty, steals from the top of other threads'
+ deques, checking high priority work everywhere before lower priority work. The main thread
+ owns a set of deques too, so it can submit jobs and help run them while it waits.
+
+ Jobs may only be submitted from the main thread or from inside a job.
+*/
+
+typedef enum job_priority
+{
+    JOB_PRIORITY_HIGH,
+    JOB_PRIORITY_NORMAL,
+    JOB_PRIORITY_LOW,
+
+    JOB_PRIORITY_COUNT
+} job_priority;
+
+/**
+ * @brief Runs on a job thread (or on a thread helping in job_wait).
+ * @param params The params the job was submitted with.
+ */
+typedef void (*pfn_job_entry)(void* params);
+
+/**
+ * @brief Runs on the main thread, from job_system_update, after the job's entry has returned.
+ * @param params The params the job was submitted with.
+ */
+typedef void (*pfn_job_complete)(void* params);
+
+/**
+ * A count of unfinished jobs. Zero-initialize it, pass it to any number of job_submit calls,
+ * then job_wait on it.
+ */
+typedef struct job_counter
+{
+    // Atomic.
+    u32 value;
+} job_counter;
+
+typedef struct job_info
+{
+    pfn_job_entry entry;
+    // Optional.
+    pfn_job_complete on_complete;
+    // Passed to entry and on_complete. Owned by the submitter and must stay valid until
+    // on_complete has run (or entry, if there is no on_complete).
+    void* params;
+    job_priority priority;
+    // Optional. Incremented on submit, decremented when entry returns.
+    job_counter* counter;
+} job_info;
+
+/**
+ * @brief Initializes the job system and starts its threads. Call twice: once with state 0 to
+ * get the memory requirement, then with a block of that size.
+ *
+ * @param memory_requirement Receives the size of the state.
+ * @param state A block of memory_requirement bytes, or 0.
+ * @param thread_count The number of job threads. 0 uses one per physical core on the calling
+ *        thread's NUMA node, less one for the main thread; or one per logical processor, less
+ *        one, when the CPU has neither SMT nor several nodes. Job threads are restricted to
+ *        one hardware thread per core on that node when there are enough cores for them, and
+ *        the calling thread is then restricted to the core they leave free.
+ * @returns True on success; otherwise false.
+ */
+DAPI b8 job_system_initialize(u64* memory_requirement, void* state, u32 thread_count);
+
+/**
+ * @brief Finishes the queued jobs, stops the job threads and runs outstanding completion
+ * callbacks.
+ */
+DAPI void job_system_shutdown(void* state);
+
+/**
+ * @brief Runs the completion callbacks of jobs finished since the last call. Call once per
+ * frame on the main thread.
+ */
+DAPI void job_system_update();
+
+/**
+ * @brief Queues a job. If the calling thread's queue for that priority is full, the job runs
+ * immediately on the calling thread instead.
+ *
+ * @returns False if the job system is not running, the caller may not submit jobs, or the job
+ *          has an on_complete and JOB_COMPLETION_QUEUE_SIZE such jobs are already waiting for
+ *          job_system_update.
+ */
+DAPI b8 job_submit(const job_info* info);
+
+/**
+ * @brief Waits until counter reaches zero, running queued jobs in the meantime rather than
+ * blocking. Completions of the jobs counted are queued before the counter reaches zero, and
+ * run at the next job_system_update.
+ */
+DAPI void job_wait(job_counter* counter);
+
+/**
+ * @returns The number of job threads, not counting the main thread.
+ */
+DAPI u32 job_system_thread_count();
\ No newline at end of file
@@ -1,7 +1,9 @@
 #include "logger.h"
+#include "logger_binary.h"
 #include "asserts.h"
 #include "platform/platform.h"
 #include "platform/filesystem.h"
+#include "platform/thread.h"
 #include "core/dstring.h"
 #include "core/dmemory.h"
 
@@ -10,18 +12,173 @@
 #include <string.h>
 #include <stdarg.h>
 
+// Size of each thread's binary record buffer.
+#define LOG_THREAD_BUFFER_SIZE (64 * 1024)
+// Size of a single formatted message, including level prefix.
+#define LOG_MESSAGE_MAX_LENGTH 32000
+// Size of the console.log write buffer.
+#define LOG_FILE_BUFFER_SIZE (256 * 1024)
+// Maximum time in seconds buffered log output waits before being flushed.
+#define LOG_FILE_FLUSH_INTERVAL 1.0
+// Default size at which console.log is rotated.
+#define LOG_FILE_DEFAULT_MAX_SIZE (16 * 1024 * 1024)
+// Default number of rotated files (console.1.log ... console.N.log) kept.
+#define LOG_FILE_DEFAULT_RETAINED 4
+
+#define LOG_FILE_NAME "console.log"
+
+// Number of distinct keys tracked by the rate limiter. Must be a power of 2.
+#define LOG_LIMIT_TABLE_SIZE 256
+// Number of slots probed before evicting the stalest entry.
+#define LOG_LIMIT_MAX_PROBE 8
+// Length of the rate limiting window in seconds.
+#define LOG_LIMIT_WINDOW 1.0
+// Characters of the first message kept to identify it in "repeated" summaries.
+#define LOG_LIMIT_PREVIEW_LENGTH 96
+// Marks a slot whose entry was removed. Unlike an empty slot it doesn't end a probe, so keys
+// stored further along the chain are still found.
+#define LOG_LIMIT_TOMBSTONE 0xFFFFFFFFFFFFFFFFull
+
+typedef struct log_limit_entry
+{
+    // 0 marks an empty slot, LOG_LIMIT_TOMBSTONE a removed one.
+    u64 key;
+    f64 window_start;
+    u32 emitted;
+    u32 suppressed;
+    log_level level;
+    char preview[LOG_LIMIT_PREVIEW_LENGTH];
+} log_limit_entry;
+
+typedef struct log_thread_buffer
+{
+    // Held by the owning thread while it records, and by whichever thread drains the buffer.
+    platform_mutex lock;
+    struct log_thread_buffer* next;
+    u64 used;
+    u8 data[LOG_THREAD_BUFFER_SIZE];
+} log_thread_buffer;
+
 typedef struct logger_system_state
 {
+    // Guards the output below: console, file, rotation. Taken last, after any buffer lock.
+    platform_mutex lock;
     file_handle handle;
+    log_mode mode;
+    // Bytes written to the current log file.
+    u64 file_size;
+    // 0 disables rotation.
+    u64 max_file_size;
+    u32 retained_files;
+
+    // Rate limiter for log_output_limited, keyed by call site or message hash. Guarded by lock.
+    log_limit_entry limits[LOG_LIMIT_TABLE_SIZE];
+    // Number of entries with suppressed messages awaiting a summary.
+    u32 pending_summaries;
+
+    // Guards the list of thread buffers. Taken before any buffer's lock.
+    platform_mutex buffers_lock;
+    // Every thread's binary record buffer, so any thread can drain them all.
+    log_thread_buffer* buffers;
 } logger_system_state;
 
+typedef struct log_limit_summary
+{
+    log_level level;
+    char text[LOG_LIMIT_PREVIEW_LENGTH + 96];
+} log_limit_summary;
+
 static logger_system_state* state_ptr;
+// Incremented by initialize_logging; thread buffers from an earlier run are not reused.
+static u32 logging_generation;
+
+// Binary records are written into a buffer owned by the logging thread.
+static DTHREAD_LOCAL log_thread_buffer* thread_buffer;
+static DTHREAD_LOCAL u32 thread_buffer_generation;
+// Set while this thread writes output. Messages logged meanwhile (e.g. by a failing file
+// write) go straight to the console rather than back into the logger.
+static DTHREAD_LOCAL b8 writing_output;
+
+u8 log_category_levels[LOG_CATEGORY_MAX] = {
+    LOG_LEVEL_TRACE, LOG_LEVEL_TRACE, LOG_LEVEL_TRACE, LOG_LEVEL_TRACE,
+    LOG_LEVEL_TRACE, LOG_LEVEL_TRACE, LOG_LEVEL_TRACE, LOG_LEVEL_TRACE};
+STATIC_ASSERT(LOG_CATEGORY_MAX == 8, "log_category_levels initializer must cover every category.");
+
+static const char* level_strings[6] = {"[FATAL]: ", "[ERROR]: ", "[WARN]:  ", "[INFO]:  ", "[DEBUG]: ", "[TRACE]: "};
+
+static void log_limit_flush_expired(b8 flush_all);
+
+static void rotated_file_name(u32 index, char* out_name)
+{
+    string_format(out_name, "console.%u.log", index);
+}
+
+/**
+ * Shifts console.log to console.1.log, console.1.log to console.2.log and so on,
+ * dropping the oldest file beyond the retained count.
+ */
+static void log_rotate_files()
+{
+    char from[64];
+    char to[64];
+    if(state_ptr->retained_files == 0)
+    {
+        filesystem_delete(LOG_FILE_NAME);
+        return;
+    }
+
+    rotated_file_name(state_ptr->retained_files, to);
+    filesystem_delete(to);
+    for(u32 i = state_ptr->retained_files - 1; i > 0; i--)
+    {
+        rotated_file_name(i, from);
+        rotated_file_name(i + 1, to);
+        if(filesystem_exists(from))
+        {
+            filesystem_rename(from, to);
+        }
+    }
+    rotated_file_name(1, to);
+    filesystem_rename(LOG_FILE_NAME, to);
+}
+
+static b8 log_open_file()
+{
+    state_ptr->file_size = 0;
+    if(!filesystem_open(LOG_FILE_NAME, FILE_MODE_WRITE, false, &state_ptr->handle))
+    {
+        return false;
+    }
+
+    // Avoid a flush per line. Errors and crashes still reach the file immediately.
+    file_write_buffer_config buffer_config;
+    buffer_config.buffer_size = LOG_FILE_BUFFER_SIZE;
+    buffer_config.flush_policy = FILE_FLUSH_ON_SIZE | FILE_FLUSH_ON_INTERVAL | FILE_FLUSH_ON_ERROR | FILE_FLUSH_ON_CRASH;
+    buffer_config.flush_interval = LOG_FILE_FLUSH_INTERVAL;
+    if(!filesystem_enable_write_buffer(&state_ptr->handle, &buffer_config))
+    {
+        platform_console_write_error("ERROR: Unable to buffer console.log, writing unbuffered.", LOG_LEVEL_WARN);
+    }
+    return true;
+}
 
 void append_to_log_file(const char* message)
 {
     if(state_ptr && state_ptr->handle.is_valid)
     {
         u64 length = string_length(message);
+        if(state_ptr->max_file_size && state_ptr->file_size + length > state_ptr->max_file_size)
+        {
+            filesystem_close(&state_ptr->handle);
+            log_rotate_files();
+            if(!log_open_file())
+            {
+                platform_console_write_error("ERROR: Unable to reopen console.log after rotation.", LOG_LEVEL_ERROR);
+                return;
+            }
+        }
+        state_ptr->file_size += length;
+
         u64 written = 0;
         if(!filesystem_write(&state_ptr->handle, length, message, &written))
         {
@@ -39,8 +196,26 @@ b8 initialize_logging(u64* memory_requirement, void* state)
     }
 
     state_ptr = state;
-    // Create new/wipe existing log file, then open it.
-    if(!filesystem_open("console.log", FILE_MODE_WRITE, false, &state_ptr->handle))
+    logging_generation++;
+    state_ptr->mode = LOG_MODE_TEXT;
+    state_ptr->buffers = 0;
+    if(!platform_mutex_create(&state_ptr->lock) || !platform_mutex_create(&state_ptr->buffers_lock))
+    {
+        platform_console_write_error("ERROR: Unable to create the logger's locks.", LOG_LEVEL_ERROR);
+        state_ptr = 0;
+        return false;
+    }
+    dzero_memory(state_ptr->limits, sizeof(state_ptr->limits));
+    state_ptr->pending_summaries = 0;
+    state_ptr->max_file_size = LOG_FILE_DEFAULT_MAX_SIZE;
+    state_ptr->retained_files = LOG_FILE_DEFAULT_RETAINED;
+
+    // Keep the previous run's log instead of wiping it, then start a new file.
+    if(filesystem_exists(LOG_FILE_NAME))
+    {
+        log_rotate_files();
+    }
+    if(!log_open_file())
     {
         // 这里不能用D*****等函数，因为日志子系统还没有建立成功
         platform_console_write_error("ERROR: Unable to open console.log for writing.", LOG_LEVEL_ERROR);
@@ -52,30 +227,47 @@ b8 initialize_logging(u64* memory_requirement, void* state)
 
 void shutdown_logging(void* state)
 {
-    // TODO: cleanup logging/write queued entries
+    log_flush();
+    if(state_ptr)
+    {
+        // Don't lose counts still inside their window.
+        log_limit_flush_expired(true);
+
+        // Threads still running lose their buffers; their generation no longer matches.
+        log_thread_buffer* buffer = state_ptr->buffers;
+        while(buffer)
+        {
+            log_thread_buffer* next = buffer->next;
+            platform_mutex_destroy(&buffer->lock);
+            platform_free(buffer, false);
+            buffer = next;
+        }
+        state_ptr->buffers = 0;
+        platform_mutex_destroy(&state_ptr->buffers_lock);
+        filesystem_close(&state_ptr->handle);
+        platform_mutex_destroy(&state_ptr->lock);
+    }
+    thread_buffer = 0;
     state_ptr = 0;
 }
 
-void log_output(log_level level, const char* message, ...)
+static void log_write(log_level level, const char* out_message)
 {
-    // TODO: These string operations are all pretty slow. This needs to be
-    // moved to another thread eventually, along with the file writes, to
-    // avoid slowing things down while the engine is trying to run.
-    const char* level_strings[6] = {"[FATAL]: ", "[ERROR]: ", "[WARN]:  ", "[INFO]:  ", "[DEBUG]: ", "[TRACE]: "};
-    b8 is_error = level < LOG_LEVEL_WARN;
-
-    char out_message[32000];
-    dzero_memory(out_message, sizeof(out_message));
-
-    __builtin_va_list arg_ptr;
-    va_start(arg_ptr, message);
-    string_format_v(out_message, message, arg_ptr);
-    va_end(arg_ptr);
-
-    string_format(out_message, "%s%s\n", level_strings[level], out_message);
+    if(writing_output)
+    {
+        platform_console_write_error(out_message, level);
+        return;
+    }
+    writing_output = true;
+    // Lines from different threads must not interleave in the write buffer, nor rotate twice.
+    logger_system_state* state = state_ptr;
+    if(state)
+    {
+        platform_mutex_lock(&state->lock);
+    }
 
     // Print accordingly
-    if (is_error) 
+    if (level < LOG_LEVEL_WARN) 
     {
         platform_console_write_error(out_message, level);
     } 
@@ -86,6 +278,429 @@ void log_output(log_level level, const char* message, ...)
 
     // Queue a copy to be written to the log file.
     append_to_log_file(out_message);
+
+    if(level <= LOG_LEVEL_ERROR && state)
+    {
+        filesystem_flush_on(&state->handle, FILE_FLUSH_ON_ERROR);
+    }
+
+    if(state)
+    {
+        platform_mutex_unlock(&state->lock);
+    }
+    writing_output = false;
+}
+
+// Formats and writes the records in buffer. Requires buffer->lock.
+static void log_drain_buffer(log_thread_buffer* buffer)
+{
+    char message[LOG_MESSAGE_MAX_LENGTH];
+    char out_message[LOG_MESSAGE_MAX_LENGTH];
+    u64 offset = 0;
+    while(offset < buffer->used)
+    {
+        const log_binary_header* header = (const log_binary_header*)(buffer->data + offset);
+        offset += log_binary_decode(buffer->data + offset, message, sizeof(message));
+        snprintf(out_message, sizeof(out_message), "%s[%.6f] %s\n", level_strings[header->level], header->timestamp, message);
+        log_write(header->level, out_message);
+    }
+    buffer->used = 0;
+}
+
+// Drains every thread's buffer.
+static void log_drain_all_buffers()
+{
+    platform_mutex_lock(&state_ptr->buffers_lock);
+    for(log_thread_buffer* buffer = state_ptr->buffers; buffer; buffer = buffer->next)
+    {
+        platform_mutex_lock(&buffer->lock);
+        if(buffer->used > 0)
+        {
+            log_drain_buffer(buffer);
+        }
+        platform_mutex_unlock(&buffer->lock);
+    }
+    platform_mutex_unlock(&state_ptr->buffers_lock);
+}
+
+void log_thread_exit()
+{
+    if(!thread_buffer || thread_buffer_generation != logging_generation || !state_ptr)
+    {
+        // Never logged in binary mode, or already freed by shutdown_logging.
+        thread_buffer = 0;
+        return;
+    }
+
+    log_thread_buffer* buffer = thread_buffer;
+    thread_buffer = 0;
+    platform_mutex_lock(&state_ptr->buffers_lock);
+    log_thread_buffer** link = &state_ptr->buffers;
+    while(*link != buffer)
+    {
+        link = &(*link)->next;
+    }
+    *link = buffer->next;
+    platform_mutex_unlock(&state_ptr->buffers_lock);
+
+    // No other thread can reach it now.
+    log_drain_buffer(buffer);
+    platform_mutex_destroy(&buffer->lock);
+    platform_free(buffer, false);
+}
+
+void log_category_set_level(log_category category, log_level level)
+{
+    if(category < LOG_CATEGORY_MAX)
+    {
+        log_category_levels[category] = (u8)level;
+    }
+}
+
+log_level log_category_get_level(log_category category)
+{
+    if(category < LOG_CATEGORY_MAX)
+    {
+        return (log_level)log_category_levels[category];
+    }
+    return LOG_LEVEL_TRACE;
+}
+
+void log_set_file_rotation(u64 max_file_size, u32 retained_files)
+{
+    if(state_ptr)
+    {
+        platform_mutex_lock(&state_ptr->lock);
+        state_ptr->max_file_size = max_file_size;
+        state_ptr->retained_files = retained_files;
+        platform_mutex_unlock(&state_ptr->lock);
+    }
+}
+
+void log_set_mode(log_mode mode)
+{
+    if(state_ptr && state_ptr->mode != mode)
+    {
+        log_flush();
+        state_ptr->mode = mode;
+    }
+}
+
+/**
+ * Takes an entry's suppressed count as a summary, to be logged once the lock is released.
+ * Requires the lock. Returns false if nothing was suppressed.
+ */
+static b8 log_limit_summarize(log_limit_entry* entry, f64 now, log_limit_summary* out_summary)
+{
+    if(entry->suppressed == 0)
+    {
+        return false;
+    }
+    out_summary->level = entry->level;
+    snprintf(out_summary->text, sizeof(out_summary->text), "Previous message repeated %u more times in %.2fs: %s", entry->suppressed, now - entry->window_start, entry->preview);
+    entry->suppressed = 0;
+    state_ptr->pending_summaries--;
+    return true;
+}
+
+/**
+ * Emits summaries for keys which stopped repeating, so suppressed counts are not lost.
+ * With flush_all, also for keys still inside their window.
+ */
+static void log_limit_flush_expired(b8 flush_all)
+{
+    // Each summary is logged without the lock, so take them one at a time.
+    for(;;)
+    {
+        log_limit_summary summary;
+        b8 found = false;
+        platform_mutex_lock(&state_ptr->lock);
+        f64 now = platform_get_absolute_time();
+        for(u32 i = 0; i < LOG_LIMIT_TABLE_SIZE && state_ptr->pending_summaries > 0 && !found; i++)
+        {
+            log_limit_entry* entry = &state_ptr->limits[i];
+            if(entry->key && entry->key != LOG_LIMIT_TOMBSTONE && entry->suppressed > 0 &&
+               (flush_all || now - entry->window_start >= LOG_LIMIT_WINDOW))
+            {
+                found = log_limit_summarize(entry, now, &summary);
+                entry->key = LOG_LIMIT_TOMBSTONE;
+            }
+        }
+        platform_mutex_unlock(&state_ptr->lock);
+
+        if(!found)
+        {
+            break;
+        }
+        log_output(summary.level, "%s", summary.text);
+    }
+}
+
+void log_flush()
+{
+    if(state_ptr)
+    {
+        log_drain_all_buffers();
+    }
+
+    if(state_ptr)
+    {
+        log_limit_flush_expired(false);
+    }
+
+    if(state_ptr)
+    {
+        platform_mutex_lock(&state_ptr->lock);
+        filesystem_flush_on(&state_ptr->handle, FILE_FLUSH_ON_INTERVAL);
+        platform_mutex_unlock(&state_ptr->lock);
+    }
+}
+
+/**
+ * Records a message into the calling thread's binary buffer.
+ * Returns false if the message could not be deferred and must be formatted now.
+ */
+static b8 log_record_binary(log_level level, const char* message, va_list args)
+{
+    if(!thread_buffer || thread_buffer_generation != logging_generation)
+    {
+        log_thread_buffer* buffer = platform_allocate(sizeof(log_thread_buffer), false);
+        if(!platform_mutex_create(&buffer->lock))
+        {
+            platform_free(buffer, false);
+            return false;
+        }
+        buffer->used = 0;
+        platform_mutex_lock(&state_ptr->buffers_lock);
+        buffer->next = state_ptr->buffers;
+        state_ptr->buffers = buffer;
+        platform_mutex_unlock(&state_ptr->buffers_lock);
+        thread_buffer = buffer;
+        thread_buffer_generation = logging_generation;
+    }
+
+    log_thread_buffer* buffer = thread_buffer;
+    f64 timestamp = platform_get_absolute_time();
+    b8 recorded = false;
+    // Only contended while another thread drains this buffer.
+    platform_mutex_lock(&buffer->lock);
+    for(u32 attempt = 0; attempt < 2; attempt++)
+    {
+        va_list args_copy;
+        va_copy(args_copy, args);
+        u64 size = log_binary_encode(
+            buffer->data + buffer->used,
+            LOG_THREAD_BUFFER_SIZE - buffer->used,
+            level,
+            timestamp,
+            message,
+            args_copy);
+        va_end(args_copy);
+
+        if(size)
+        {
+            buffer->used += size;
+            recorded = true;
+            break;
+        }
+        if(buffer->used == 0)
+        {
+            // Does not fit even into an empty buffer, or cannot be deferred.
+            break;
+        }
+        // Out of space, drain and retry.
+        log_drain_buffer(buffer);
+    }
+    platform_mutex_unlock(&buffer->lock);
+    return recorded;
+}
+
+/**
+ * Formats the level prefix, the message and a newline into out_line, which holds
+ * LOG_MESSAGE_MAX_LENGTH characters. Long messages are truncated.
+ */
+static void log_format_line(char* out_line, log_level level, const char* message, va_list args)
+{
+    u64 prefix_length = string_length(level_strings[level]);
+    dcopy_memory(out_line, level_strings[level], prefix_length);
+
+    u64 available = LOG_MESSAGE_MAX_LENGTH - prefix_length - 1;
+    i32 written = vsnprintf(out_line + prefix_length, available, message, args);
+
+    u64 length = prefix_length;
+    if(written > 0)
+    {
+        length += ((u64)written < available) ? (u64)written : available - 1;
+    }
+    out_line[length] = '\n';
+    out_line[length + 1] = 0;
+}
+
+/**
+ * Writes a line formatted by log_format_line. In binary mode, records still buffered are
+ * written first so the order is kept.
+ */
+static void log_write_formatted(log_level level, const char* line)
+{
+    if(state_ptr && state_ptr->mode == LOG_MODE_BINARY && !writing_output)
+    {
+        log_flush();
+    }
+    log_write(level, line);
+}
+
+static void log_output_v(log_level level, const char* message, va_list args)
+{
+    if(state_ptr && state_ptr->mode == LOG_MODE_BINARY && !writing_output)
+    {
+        if(level > LOG_LEVEL_ERROR && log_record_binary(level, message, args))
+        {
+            return;
+        }
+        // Keep ordering with anything already buffered.
+        log_flush();
+    }
+
+    // Prefix and message are formatted in place, once.
+    char out_message[LOG_MESSAGE_MAX_LENGTH];
+    log_format_line(out_message, level, message, args);
+    log_write(level, out_message);
+}
+
+void log_output(log_level level, const char* message, ...)
+{
+    __builtin_va_list arg_ptr;
+    va_start(arg_ptr, message);
+    log_output_v(level, message, arg_ptr);
+    va_end(arg_ptr);
+}
+
+u64 log_hash_string(const char* str)
+{
+    // FNV-1a
+    u64 hash = 14695981039346656037ULL;
+    while(*str)
+    {
+        hash ^= (u8)*str++;
+        hash *= 1099511628211ULL;
+    }
+    return hash ? hash : 1;
+}
+
+void log_output_limited(log_level level, u64 key, u32 budget_per_second, const char* message, ...)
+{
+    if(!state_ptr || key == 0 || writing_output)
+    {
+        // No limiter state yet, or logging from inside the logger: log normally.
+        __builtin_va_list arg_ptr;
+        va_start(arg_ptr, message);
+        log_output_v(level, message, arg_ptr);
+        va_end(arg_ptr);
+        return;
+    }
+
+    if(key == LOG_LIMIT_TOMBSTONE)
+    {
+        key--;
+    }
+
+    log_limit_summary summary;
+    b8 has_summary = false;
+    platform_mutex_lock(&state_ptr->lock);
+    f64 now = platform_get_absolute_time();
+
+    // Find the key. Failing that, take the first removed or empty slot, or evict the stalest entry.
+    u32 start = (u32)(key ^ (key >> 32)) & (LOG_LIMIT_TABLE_SIZE - 1);
+    log_limit_entry* entry = 0;
+    log_limit_entry* free_slot = 0;
+    log_limit_entry* stalest = 0;
+    for(u32 i = 0; i < LOG_LIMIT_MAX_PROBE; i++)
+    {
+        log_limit_entry* candidate = &state_ptr->limits[(start + i) & (LOG_LIMIT_TABLE_SIZE - 1)];
+        if(candidate->key == key)
+        {
+            entry = candidate;
+            break;
+        }
+        if(candidate->key == 0 || candidate->key == LOG_LIMIT_TOMBSTONE)
+        {
+            if(!free_slot)
+            {
+                free_slot = candidate;
+            }
+            if(candidate->key == 0)
+            {
+                // The end of the chain; the key isn't further along.
+                break;
+            }
+            continue;
+        }
+        if(!stalest || candidate->window_start < stalest->window_start)
+        {
+            stalest = candidate;
+        }
+    }
+
+    if(!entry)
+    {
+        entry = free_slot;
+        if(!entry)
+        {
+            entry = stalest;
+            has_summary = log_limit_summarize(entry, now, &summary);
+        }
+        entry->key = key;
+        entry->window_start = now;
+        entry->emitted = 0;
+        entry->suppressed = 0;
+    }
+    else if(now - entry->window_start >= LOG_LIMIT_WINDOW)
+    {
+        has_summary = log_limit_summarize(entry, now, &summary);
+        entry->window_start = now;
+        entry->emitted = 0;
+    }
+
+    b8 over_budget = entry->emitted >= budget_per_second;
+    char out_message[LOG_MESSAGE_MAX_LENGTH];
+    if(over_budget)
+    {
+        // Over budget: no formatting, just count it.
+        if(entry->suppressed++ == 0)
+        {
+            state_ptr->pending_summaries++;
+        }
+    }
+    else
+    {
+        entry->emitted++;
+        entry->level = level;
+
+        // Formatted once, straight into the line that is written.
+        __builtin_va_list arg_ptr;
+        va_start(arg_ptr, message);
+        log_format_line(out_message, level, message, arg_ptr);
+        va_end(arg_ptr);
+
+        const char* text = out_message + string_length(level_strings[level]);
+        u64 preview_length = 0;
+        while(preview_length < LOG_LIMIT_PREVIEW_LENGTH - 1 && text[preview_length] && text[preview_length] != '\n')
+        {
+            preview_length++;
+        }
+        dcopy_memory(entry->preview, text, preview_length);
+        entry->preview[preview_length] = 0;
+    }
+    platform_mutex_unlock(&state_ptr->lock);
+
+    if(has_summary)
+    {
+        log_output(summary.level, "%s", summary.text);
+    }
+    if(!over_budget)
+    {
+        log_write_formatted(level, out_message);
+    }
 }
 
 void report_assertion_failure(const char* expression, const char* message, const char* file, i32 line)
@@ -6,17 +6,25 @@
  We are going incresing the capabilities of the logger as we progress through the series.
 */
 
-#define LOG_WARN_ENABLED 1
-#define LOG_INFO_ENABLED 1
-#define LOG_DEBUG_ENABLED 1
-#define LOG_TRACE_ENABLED 1
-
-// Disable debug and trace logging for release builds
+/*
+ Compile-time minimum level. Messages less severe than this are compiled out entirely,
+ including their argument expressions. Values match log_level:
+ 0 = FATAL, 1 = ERROR, 2 = WARN, 3 = INFO, 4 = DEBUG, 5 = TRACE.
+*/
+#ifndef LOG_COMPILE_LEVEL
 #ifdef DRELEASE
-#define LOG_DEBUG_ENABLED 0
-#define LOG_TRACE_ENABLED 0
+// Disable debug and trace logging for release builds
+#define LOG_COMPILE_LEVEL 3
+#else
+#define LOG_COMPILE_LEVEL 5
+#endif
 #endif
 
+#define LOG_WARN_ENABLED (LOG_COMPILE_LEVEL >= 2)
+#define LOG_INFO_ENABLED (LOG_COMPILE_LEVEL >= 3)
+#define LOG_DEBUG_ENABLED (LOG_COMPILE_LEVEL >= 4)
+#define LOG_TRACE_ENABLED (LOG_COMPILE_LEVEL >= 5)
+
 typedef enum log_level {
     LOG_LEVEL_FATAL = 0,
     LOG_LEVEL_ERROR,
@@ -26,6 +34,28 @@ typedef enum log_level {
     LOG_LEVEL_TRACE
 } log_level;
 
+typedef enum log_category {
+    LOG_CATEGORY_CORE = 0,
+    LOG_CATEGORY_PLATFORM,
+    LOG_CATEGORY_MEMORY,
+    LOG_CATEGORY_EVENT,
+    LOG_CATEGORY_INPUT,
+    LOG_CATEGORY_RENDERER,
+    LOG_CATEGORY_VULKAN,
+    LOG_CATEGORY_APP,
+
+    LOG_CATEGORY_MAX
+} log_category;
+
+typedef enum log_mode {
+    // Messages are formatted and written on the calling thread immediately.
+    LOG_MODE_TEXT = 0,
+    // Only the format pointer, a timestamp and the raw argument bytes are recorded into a
+    // per-thread buffer. Formatting happens when the buffer is flushed. Error and fatal
+    // messages are always written immediately. Format strings must be literals.
+    LOG_MODE_BINARY
+} log_mode;
+
 /**
  * @brief Initialize logging system. Call twice: once with state = 0 to get required memory size.
  * then a second time passing allocated memory to state.
@@ -34,37 +64,136 @@ typedef enum log_level {
  * @param state 0 if just request memory requirement, other allocated block of memory.
  * @return b8 ture on success, otherwise false.
  */
-b8 initialize_logging(u64* memory_requirement, void* state);
-void shutdown_logging(void* state);
+DAPI b8 initialize_logging(u64* memory_requirement, void* state);
+DAPI void shutdown_logging(void* state);
+
+/**
+ * @brief Writes out and frees the calling thread's binary record buffer. Called by each
+ * platform thread as it exits.
+ */
+void log_thread_exit();
+
+/**
+ * @brief Configures rotation of console.log. Once the file would exceed max_file_size bytes it is
+ * renamed to console.1.log (shifting older files up) and a new file is started. At most
+ * retained_files rotated files are kept. Defaults to 16MiB and 4 files.
+ * 
+ * @param max_file_size The size at which the log is rotated. 0 lets it grow without limit.
+ * @param retained_files The number of rotated files to keep.
+ */
+DAPI void log_set_file_rotation(u64 max_file_size, u32 retained_files);
+
+/**
+ * @brief Sets how messages are recorded. Switching modes flushes every thread's buffer.
+ */
+DAPI void log_set_mode(log_mode mode);
+
+/**
+ * @brief Formats and writes the binary records buffered by every thread, and flushes the
+ * log file once its flush interval has elapsed. Called once per frame by the application.
+ */
+DAPI void log_flush();
 
 DAPI void log_output(log_level level, const char* message, ...);
 
+/**
+ * @brief The most verbose level enabled at runtime for each category. Read directly by the
+ * logging macros so a disabled message costs a single branch, without evaluating its arguments.
+ * Use log_category_set_level to modify.
+ */
+extern DAPI u8 log_category_levels[LOG_CATEGORY_MAX];
+
+/**
+ * @brief Sets the most verbose level logged for the given category at runtime.
+ * Levels beyond LOG_COMPILE_LEVEL remain compiled out regardless.
+ */
+DAPI void log_category_set_level(log_category category, log_level level);
+
+DAPI log_level log_category_get_level(log_category category);
+
+/**
+ * @brief Logs a message for a category if its level is enabled both at compile time and at runtime.
+ */
+#define DLOG(category, level, message, ...)                                            \
+    do                                                                                  \
+    {                                                                                   \
+        if((level) <= LOG_COMPILE_LEVEL && (level) <= log_category_levels[(category)])  \
+        {                                                                               \
+            log_output((level), (message), ##__VA_ARGS__);                              \
+        }                                                                               \
+    } while(0)
+
+/**
+ * @brief Logs a message at most budget_per_second times per second for the given key.
+ * Messages over budget are counted without being formatted, and a "repeated N more times"
+ * summary is logged once the one second window ends.
+ * 
+ * @param level The log level of the message.
+ * @param key Identifies the message, e.g. LOG_SITE_KEY or log_hash_string(text). Must not be 0.
+ * @param budget_per_second How many messages with this key are logged per second.
+ * @param message The format string.
+ */
+DAPI void log_output_limited(log_level level, u64 key, u32 budget_per_second, const char* message, ...);
+
+/**
+ * @brief Hashes a string for use as a rate limiting key. Never returns 0.
+ */
+DAPI u64 log_hash_string(const char* str);
+
+// Rate limiting key for the current call site.
+#define LOG_SITE_KEY ((u64)(__FILE__) ^ ((u64)__LINE__ * 0x9E3779B97F4A7C15ULL))
+
+/**
+ * @brief Like DLOG, but limited to budget messages per second per key. See log_output_limited.
+ */
+#define DLOG_LIMITED_KEY(category, level, key, budget, message, ...)                   \
+    do                                                                                  \
+    {                                                                                   \
+        if((level) <= LOG_COMPILE_LEVEL && (level) <= log_category_levels[(category)])  \
+        {                                                                               \
+            log_output_limited((level), (key), (budget), (message), ##__VA_ARGS__);     \
+        }                                                                               \
+    } while(0)
+
+/**
+ * @brief Like DLOG, but limited to budget messages per second from this call site.
+ */
+#define DLOG_LIMITED(category, level, budget, message, ...) \
+    DLOG_LIMITED_KEY(category, level, LOG_SITE_KEY, budget, message, ##__VA_ARGS__)
+
 #define DFATAL(message, ...) log_output(LOG_LEVEL_FATAL, (message), ##__VA_ARGS__);
 
 #ifndef DERROR
 #define DERROR(message, ...) log_output(LOG_LEVEL_ERROR, (message), ##__VA_ARGS__);
 #endif
 
+#define DLOG_ERROR(category, message, ...) DLOG(category, LOG_LEVEL_ERROR, message, ##__VA_ARGS__)
+
 #if LOG_WARN_ENABLED == 1
-#define DWARN(message, ...) log_output(LOG_LEVEL_WARN, (message), ##__VA_ARGS__)
+#define DLOG_WARN(category, message, ...) DLOG(category, LOG_LEVEL_WARN, message, ##__VA_ARGS__)
 #else
-#define DWARN(message, ...)
+#define DLOG_WARN(category, message, ...)
 #endif
 
 #if LOG_INFO_ENABLED == 1
-#define DINFO(message, ...) log_output(LOG_LEVEL_INFO, (message), ##__VA_ARGS__)
+#define DLOG_INFO(category, message, ...) DLOG(category, LOG_LEVEL_INFO, message, ##__VA_ARGS__)
 #else
-#define DINFO(message, ...)
+#define DLOG_INFO(category, message, ...)
 #endif
 
 #if LOG_DEBUG_ENABLED == 1
-#define DDEBUG(message, ...) log_output(LOG_LEVEL_DEBUG, (message), ##__VA_ARGS__)
+#define DLOG_DEBUG(category, message, ...) DLOG(category, LOG_LEVEL_DEBUG, message, ##__VA_ARGS__)
 #else
-#define DDEBUG(message, ...)
+#define DLOG_DEBUG(category, message, ...)
 #endif
 
 #if LOG_TRACE_ENABLED == 1
-#define DTRACE(message, ...) log_output(LOG_LEVEL_TRACE, (message), ##__VA_ARGS__)
+#define DLOG_TRACE(category, message, ...) DLOG(category, LOG_LEVEL_TRACE, message, ##__VA_ARGS__)
 #else
-#define DTRACE(message, ...)
-#endif
\ No newline at end of file
+#define DLOG_TRACE(category, message, ...)
+#endif
+
+#define DWARN(message, ...) DLOG_WARN(LOG_CATEGORY_CORE, message, ##__VA_ARGS__)
+#define DINFO(message, ...) DLOG_INFO(LOG_CATEGORY_CORE, message, ##__VA_ARGS__)
+#define DDEBUG(message, ...) DLOG_DEBUG(LOG_CATEGORY_CORE, message, ##__VA_ARGS__)
+#define DTRACE(message, ...) DLOG_TRACE(LOG_CATEGORY_CORE, message, ##__VA_ARGS__)
\ No newline at end of file
@@ -0,0 +1,383 @@
+#include "logger_binary.h"
+
+#include "core/dmemory.h"
+#include "core/dstring.h"
+
+#include <stdio.h>
+
+typedef enum log_arg_type
+{
+    LOG_ARG_I32 = 1,
+    LOG_ARG_I64,
+    LOG_ARG_F64,
+    LOG_ARG_PTR,
+    LOG_ARG_STR,
+    LOG_ARG_UNSUPPORTED
+} log_arg_type;
+
+// Longest string argument (including terminator) copied into a record. Longer strings are truncated.
+#define LOG_BINARY_MAX_STRING 4096
+// Longest conversion specification (e.g. "%-08.3llx") that can be deferred.
+#define LOG_BINARY_MAX_SPEC 32
+
+typedef struct log_spec
+{
+    // Points at the '%' which starts the conversion.
+    const char* start;
+    u32 length;
+    // Number of '*' width/precision arguments consumed before the value.
+    u32 star_count;
+    log_arg_type type;
+} log_spec;
+
+/**
+ * Parses a conversion specification. p must point just past the '%'.
+ * Returns a pointer to the first character after the conversion.
+ */
+static const char* parse_spec(const char* p, log_spec* out_spec)
+{
+    out_spec->start = p - 1;
+    out_spec->star_count = 0;
+    out_spec->type = LOG_ARG_UNSUPPORTED;
+
+    // Flags
+    while(*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0')
+    {
+        p++;
+    }
+
+    // Width
+    if(*p == '*')
+    {
+        out_spec->star_count++;
+        p++;
+    }
+    while(*p >= '0' && *p <= '9')
+    {
+        p++;
+    }
+
+    // Precision
+    if(*p == '.')
+    {
+        p++;
+        if(*p == '*')
+        {
+            out_spec->star_count++;
+            p++;
+        }
+        while(*p >= '0' && *p <= '9')
+        {
+            p++;
+        }
+    }
+
+    // Length modifiers
+    b8 is_64 = false;
+    b8 is_long = false;
+    b8 is_long_double = false;
+    while(*p == 'h' || *p == 'l' || *p == 'z' || *p == 'j' || *p == 't' || *p == 'L')
+    {
+        if(*p == 'l')
+        {
+            is_64 = is_long ? true : sizeof(long) == 8;
+            is_long = true;
+        }
+        else if(*p == 'z' || *p == 'j' || *p == 't')
+        {
+            is_64 = true;
+        }
+        else if(*p == 'L')
+        {
+            is_long_double = true;
+        }
+        p++;
+    }
+
+    char conversion = *p;
+    if(conversion)
+    {
+        p++;
+    }
+
+    switch(conversion)
+    {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+            out_spec->type = is_64 ? LOG_ARG_I64 : LOG_ARG_I32;
+            break;
+        case 'c':
+            out_spec->type = is_long ? LOG_ARG_UNSUPPORTED : LOG_ARG_I32;
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            out_spec->type = is_long_double ? LOG_ARG_UNSUPPORTED : LOG_ARG_F64;
+            break;
+        case 's':
+            // Wide strings are not supported.
+            out_spec->type = is_long ? LOG_ARG_UNSUPPORTED : LOG_ARG_STR;
+            break;
+        case 'p':
+            out_spec->type = LOG_ARG_PTR;
+            break;
+        default:
+            // %n, unknown conversions and truncated specifications.
+            out_spec->type = LOG_ARG_UNSUPPORTED;
+            break;
+    }
+
+    out_spec->length = (u32)(p - out_spec->start);
+    if(out_spec->length > LOG_BINARY_MAX_SPEC)
+    {
+        out_spec->type = LOG_ARG_UNSUPPORTED;
+    }
+    return p;
+}
+
+static b8 write_bytes(u8** cursor, const u8* end, const void* data, u64 size)
+{
+    if(*cursor + size > end)
+    {
+        return false;
+    }
+    dcopy_memory(*cursor, data, size);
+    *cursor += size;
+    return true;
+}
+
+static b8 write_arg(u8** cursor, const u8* end, log_arg_type type, const void* data, u64 size)
+{
+    u8 tag = (u8)type;
+    return write_bytes(cursor, end, &tag, sizeof(tag)) && write_bytes(cursor, end, data, size);
+}
+
+u64 log_binary_encode(u8* dest, u64 capacity, log_level level, f64 timestamp, const char* format, va_list args)
+{
+    if(capacity < sizeof(log_binary_header))
+    {
+        return 0;
+    }
+
+    u8* cursor = dest + sizeof(log_binary_header);
+    const u8* end = dest + capacity;
+    u32 arg_count = 0;
+
+    const char* p = format;
+    while(*p)
+    {
+        if(*p != '%')
+        {
+            p++;
+            continue;
+        }
+        if(p[1] == '%')
+        {
+            p += 2;
+            continue;
+        }
+
+        log_spec spec;
+        p = parse_spec(p + 1, &spec);
+        if(spec.type == LOG_ARG_UNSUPPORTED)
+        {
+            return 0;
+        }
+
+        for(u32 i = 0; i < spec.star_count; i++)
+        {
+            i32 star = va_arg(args, i32);
+            if(!write_arg(&cursor, end, LOG_ARG_I32, &star, sizeof(star)))
+            {
+                return 0;
+            }
+            arg_count++;
+        }
+
+        b8 result = false;
+        switch(spec.type)
+        {
+            case LOG_ARG_I32:
+            {
+                i32 value = va_arg(args, i32);
+                result = write_arg(&cursor, end, LOG_ARG_I32, &value, sizeof(value));
+                break;
+            }
+            case LOG_ARG_I64:
+            {
+                i64 value = va_arg(args, i64);
+                result = write_arg(&cursor, end, LOG_ARG_I64, &value, sizeof(value));
+                break;
+            }
+            case LOG_ARG_F64:
+            {
+                f64 value = va_arg(args, f64);
+                result = write_arg(&cursor, end, LOG_ARG_F64, &value, sizeof(value));
+                break;
+            }
+            case LOG_ARG_PTR:
+            {
+                void* value = va_arg(args, void*);
+                result = write_arg(&cursor, end, LOG_ARG_PTR, &value, sizeof(value));
+                break;
+            }
+            case LOG_ARG_STR:
+            {
+                const char* value = va_arg(args, const char*);
+                if(!value)
+                {
+                    value = "(null)";
+                }
+                u64 length = string_length(value);
+                if(length > LOG_BINARY_MAX_STRING - 1)
+                {
+                    length = LOG_BINARY_MAX_STRING - 1;
+                }
+                u16 stored_length = (u16)(length + 1);
+                char terminator = 0;
+                result = write_arg(&cursor, end, LOG_ARG_STR, &stored_length, sizeof(stored_length)) &&
+                         write_bytes(&cursor, end, value, length) &&
+                         write_bytes(&cursor, end, &terminator, sizeof(terminator));
+                break;
+            }
+            default:
+                break;
+        }
+        if(!result)
+        {
+            return 0;
+        }
+        arg_count++;
+    }
+
+    if(arg_count > 0xFF)
+    {
+        return 0;
+    }
+
+    // Keep records 8 byte aligned so headers can be read in place.
+    u64 size = (u64)(cursor - dest);
+    size = (size + 7) & ~(u64)7;
+    if(size > capacity)
+    {
+        return 0;
+    }
+
+    log_binary_header header;
+    header.size = (u32)size;
+    header.level = (u8)level;
+    header.arg_count = (u8)arg_count;
+    header.reserved = 0;
+    header.timestamp = timestamp;
+    header.format = format;
+    dcopy_memory(dest, &header, sizeof(header));
+
+    return size;
+}
+
+u64 log_binary_decode(const u8* record, char* out_message, u64 out_size)
+{
+    log_binary_header header;
+    dcopy_memory(&header, record, sizeof(header));
+
+    const u8* cursor = record + sizeof(log_binary_header);
+    u64 offset = 0;
+
+    const char* p = header.format;
+    while(*p && offset + 1 < out_size)
+    {
+        if(*p != '%')
+        {
+            out_message[offset++] = *p++;
+            continue;
+        }
+        if(p[1] == '%')
+        {
+            out_message[offset++] = '%';
+            p += 2;
+            continue;
+        }
+
+        log_spec spec;
+        p = parse_spec(p + 1, &spec);
+
+        // Rebuild the conversion with each '*' replaced by its recorded value,
+        // so it can be formatted with a single argument.
+        char spec_text[LOG_BINARY_MAX_SPEC * 2];
+        u32 spec_offset = 0;
+        for(u32 i = 0; i < spec.length; i++)
+        {
+            if(spec.start[i] == '*')
+            {
+                i32 star;
+                dcopy_memory(&star, cursor + 1, sizeof(star));
+                cursor += 1 + sizeof(star);
+                spec_offset += snprintf(spec_text + spec_offset, sizeof(spec_text) - spec_offset, "%d", star);
+            }
+            else
+            {
+                spec_text[spec_offset++] = spec.start[i];
+            }
+        }
+        spec_text[spec_offset] = 0;
+
+        u8 type = *cursor++;
+        char* at = out_message + offset;
+        u64 remaining = out_size - offset;
+        i32 written = 0;
+        switch(type)
+        {
+            case LOG_ARG_I32:
+            {
+                i32 value;
+                dcopy_memory(&value, cursor, sizeof(value));
+                cursor += sizeof(value);
+                written = snprintf(at, remaining, spec_text, value);
+                break;
+            }
+            case LOG_ARG_I64:
+            {
+                i64 value;
+                dcopy_memory(&value, cursor, sizeof(value));
+                cursor += sizeof(value);
+                written = snprintf(at, remaining, spec_text, value);
+                break;
+            }
+            case LOG_ARG_F64:
+            {
+                f64 value;
+                dcopy_memory(&value, cursor, sizeof(value));
+                cursor += sizeof(value);
+                written = snprintf(at, remaining, spec_text, value);
+                break;
+            }
+            case LOG_ARG_PTR:
+            {
+                void* value;
+                dcopy_memory(&value, cursor, sizeof(value));
+                cursor += sizeof(value);
+                written = snprintf(at, remaining, spec_text, value);
+                break;
+            }
+            case LOG_ARG_STR:
+            {
+                u16 length;
+                dcopy_memory(&length, cursor, sizeof(length));
+                cursor += sizeof(length);
+                written = snprintf(at, remaining, spec_text, (const char*)cursor);
+                cursor += length;
+                break;
+            }
+            default:
+                break;
+        }
+
+        if(written > 0)
+        {
+            offset += ((u64)written < remaining) ? (u64)written : remaining - 1;
+        }
+    }
+
+    if(out_size > 0)
+    {
+        out_message[offset < out_size ? offset : out_size - 1] = 0;
+    }
+    return header.size;
+}
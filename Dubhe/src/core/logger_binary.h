@@ -0,0 +1,53 @@
+#pragma once
+
+#include "defines.h"
+#include "core/logger.h"
+
+#include <stdarg.h>
+
+/*
+ Binary log records. Instead of formatting a message on the calling thread, the logger
+ stores the format string pointer, a timestamp and the raw argument bytes, and formats
+ the record later when the buffer is drained.
+
+ Record layout (8 byte aligned):
+    log_binary_header
+    for each argument: u8 type, followed by the argument bytes.
+    Strings are copied as u16 length (including terminator) followed by the characters.
+*/
+
+typedef struct log_binary_header
+{
+    // Total size of the record in bytes, including this header and padding.
+    u32 size;
+    u8 level;
+    u8 arg_count;
+    u16 reserved;
+    f64 timestamp;
+    // Must point to a string with static storage duration (i.e. a literal).
+    const char* format;
+} log_binary_header;
+
+/**
+ * @brief Encodes a log call into a binary record without formatting it.
+ *
+ * @param dest The destination buffer.
+ * @param capacity The number of bytes available in dest.
+ * @param level The log level of the message.
+ * @param timestamp The time the message was logged, in seconds.
+ * @param format The format string. Only the pointer is stored.
+ * @param args The variadic argument list matching format.
+ * @return The size of the record in bytes. 0 if the record does not fit or the format
+ *         contains a conversion which cannot be deferred (e.g. %n or %Lf).
+ */
+DAPI u64 log_binary_encode(u8* dest, u64 capacity, log_level level, f64 timestamp, const char* format, va_list args);
+
+/**
+ * @brief Formats a record produced by log_binary_encode. No level prefix or newline is added.
+ *
+ * @param record A pointer to the start of the record.
+ * @param out_message The buffer to format the message into. Always null-terminated.
+ * @param out_size The size of out_message in bytes.
+ * @return The size of the record in bytes, used to advance to the next record.
+ */
+DAPI u64 log_binary_decode(const u8* record, char* out_message, u64 out_size);
@@ -21,7 +21,7 @@ typedef int b32;
 typedef _Bool b8;
 
 // Properly define static assertions.
-#if defined(__clang__) || defined(__gcc__)
+#if defined(__clang__) || defined(__GNUC__)
 #define STATIC_ASSERT _Static_assert 
 #else 
 #define STATIC_ASSERT static_assert
@@ -109,5 +109,12 @@ STATIC_ASSERT(sizeof(b8)==1, "Expected b8 to be 1 bytes.");
 #define DNOINLINE __declspec(noinline)
 #else 
 #define DINLINE static inline
-#define DNOINLINE
+#define DNOINLINE __attribute__((noinline))
+#endif
+
+// Thread-local storage
+#ifdef _MSC_VER
+#define DTHREAD_LOCAL __declspec(thread)
+#else
+#define DTHREAD_LOCAL _Thread_local
 #endif
\ No newline at end of file
@@ -20,8 +20,9 @@ int main(void)
         return -1;
     }
 
-    //Ensure the function pointer exist
-    if(!app_instance.initialize || !app_instance.update || !app_instance.render || !app_instance.on_resize)
+    //Ensure the function pointer exist, unless they come from a game library
+    if(!app_instance.app_config.game_library_path &&
+       (!app_instance.initialize || !app_instance.update || !app_instance.render || !app_instance.on_resize))
     {
         DFATAL("The app's function pointers must be assigned!");
         return -2;
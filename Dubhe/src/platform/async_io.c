@@ -0,0 +1,787 @@
+// For syscall and pread.
+#define _GNU_SOURCE
+#include "platform/async_io.h"
+
+#include "core/logger.h"
+#include "core/dmemory.h"
+#include "containers/mpsc_queue.h"
+#include "platform/thread.h"
+#include "platform/atomic.h"
+
+#if DPLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+#endif
+
+#if DPLATFORM_LINUX
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+// Reads in flight or waiting for their callback. Submitting more blocks until one is done.
+#define ASYNC_IO_MAX_REQUESTS 1024
+// Submission queue entries of the io_uring. The kernel makes the completion queue twice this,
+// enough for every request at once, so completions can't overflow on kernels that drop them.
+#define ASYNC_IO_RING_ENTRIES (ASYNC_IO_MAX_REQUESTS / 2)
+// Threads doing blocking reads when io_uring isn't used.
+#define ASYNC_IO_POOL_THREADS 4
+// user_data of the no-op which stops the io_uring completion thread.
+#define ASYNC_IO_STOP_USER_DATA 0xFFFFFFFFFFFFFFFFull
+#define ASYNC_IO_NO_REQUEST 0xFFFFFFFFu
+
+typedef struct async_io_request
+{
+    async_read read;
+    // Bytes read so far; reads may complete in several parts.
+    u64 bytes_read;
+#if DPLATFORM_LINUX
+    // Must stay valid until the kernel has read it, so it lives with the request.
+    struct iovec iov;
+    // Handed to the io_uring and not finished yet.
+    b8 in_ring;
+#endif
+    u32 next_free;
+} async_io_request;
+
+typedef struct async_io_completion
+{
+    u32 request;
+    b8 succeeded;
+} async_io_completion;
+
+#if DPLATFORM_LINUX
+typedef struct io_uring_queue
+{
+    i32 fd;
+    u32* sq_head;
+    u32* sq_tail;
+    u32 sq_mask;
+    u32 sq_entries;
+    u32* sq_array;
+    struct io_uring_sqe* sqes;
+    u32* cq_head;
+    u32* cq_tail;
+    u32 cq_mask;
+    struct io_uring_cqe* cqes;
+
+    void* sq_ring;
+    u64 sq_ring_size;
+    void* cq_ring;
+    u64 cq_ring_size;
+    u64 sqes_size;
+} io_uring_queue;
+#endif
+
+typedef struct async_io_state
+{
+    u64 main_thread_id;
+    b8 use_io_uring;
+    b8 stopping;
+
+    // Guards everything below, and the submission queue.
+    platform_mutex lock;
+    // Broadcast when a request finishes or is freed.
+    platform_condition request_done;
+    // Signalled when pending gains a request, for the thread pool.
+    platform_condition work_available;
+
+    async_io_request requests[ASYNC_IO_MAX_REQUESTS];
+    u32 first_free;
+    // Submitted and not yet finished.
+    u32 in_flight;
+
+    // Requests waiting for a pool thread; a ring of request indices.
+    u32 pending[ASYNC_IO_MAX_REQUESTS];
+    u32 pending_head;
+    u32 pending_count;
+
+    u32 thread_count;
+    platform_thread threads[ASYNC_IO_POOL_THREADS];
+
+    // Finished reads with a callback, for the main thread. Their requests stay allocated until
+    // the callback has run, which bounds the queue to ASYNC_IO_MAX_REQUESTS entries.
+    mpsc_queue completions;
+
+#if DPLATFORM_LINUX
+    io_uring_queue ring;
+    // Set once the completion thread can no longer wait on the ring. Reads submitted afterwards
+    // fail at once.
+    b8 ring_failed;
+#endif
+} async_io_state;
+
+static async_io_state* state_ptr;
+
+static void free_request(u32 index)
+{
+    state_ptr->requests[index].next_free = state_ptr->first_free;
+    state_ptr->first_free = index;
+    platform_condition_broadcast(&state_ptr->request_done);
+}
+
+// Called with the lock not held, once per request, by whichever thread saw it finish.
+static void finish_request(u32 index, b8 succeeded)
+{
+    async_io_request* request = &state_ptr->requests[index];
+    pfn_async_read_complete on_complete = request->read.on_complete;
+    job_counter* counter = request->read.counter;
+
+    if(on_complete)
+    {
+        async_io_completion completion;
+        completion.request = index;
+        completion.succeeded = succeeded;
+        // Can't be full; see completions.
+        mpsc_queue_push(&state_ptr->completions, &completion);
+    }
+    if(counter)
+    {
+        datomic_fetch_sub_u32(&counter->value, 1, DATOMIC_RELEASE);
+    }
+
+    platform_mutex_lock(&state_ptr->lock);
+#if DPLATFORM_LINUX
+    state_ptr->requests[index].in_ring = false;
+#endif
+    state_ptr->in_flight--;
+    if(!on_complete)
+    {
+        free_request(index);
+    }
+    else
+    {
+        platform_condition_broadcast(&state_ptr->request_done);
+    }
+    platform_mutex_unlock(&state_ptr->lock);
+}
+
+/**
+ * @brief Reads at an offset without moving a file position, so reads of the same file from
+ * several threads don't interfere.
+ * @returns The number of bytes read, 0 at the end of the file, or -1 on error.
+ */
+static i64 read_at(async_file file, void* buffer, u64 size, u64 offset)
+{
+#if DPLATFORM_WINDOWS
+    OVERLAPPED overlapped;
+    ZeroMemory(&overlapped, sizeof(overlapped));
+    overlapped.Offset = (DWORD)(offset & 0xFFFFFFFF);
+    overlapped.OffsetHigh = (DWORD)(offset >> 32);
+    DWORD to_read = size > 0x40000000 ? 0x40000000 : (DWORD)size;
+    DWORD bytes_read = 0;
+    if(!ReadFile((HANDLE)file.handle, buffer, to_read, &bytes_read, &overlapped))
+    {
+        return GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
+    }
+    return (i64)bytes_read;
+#else
+    ssize_t result;
+    while((result = pread((i32)file.handle, buffer, (size_t)size, (off_t)offset)) < 0 && errno == EINTR)
+    {
+    }
+    return (i64)result;
+#endif
+}
+
+// Thread pool
+
+static u32 pool_thread_run(void* params)
+{
+    platform_thread_set_name("dubhe-io");
+    platform_mutex_lock(&state_ptr->lock);
+    for(;;)
+    {
+        while(state_ptr->pending_count == 0 && !state_ptr->stopping)
+        {
+            platform_condition_wait(&state_ptr->work_available, &state_ptr->lock);
+        }
+        if(state_ptr->pending_count == 0)
+        {
+            break;
+        }
+        u32 index = state_ptr->pending[state_ptr->pending_head];
+        state_ptr->pending_head = (state_ptr->pending_head + 1) % ASYNC_IO_MAX_REQUESTS;
+        state_ptr->pending_count--;
+        platform_mutex_unlock(&state_ptr->lock);
+
+        async_io_request* request = &state_ptr->requests[index];
+        b8 failed = false;
+        while(request->bytes_read < request->read.size)
+        {
+            i64 result = read_at(
+                request->read.file,
+                (u8*)request->read.buffer + request->bytes_read,
+                request->read.size - request->bytes_read,
+                request->read.offset + request->bytes_read);
+            if(result <= 0)
+            {
+                failed = result < 0;
+                break;
+            }
+            request->bytes_read += (u64)result;
+        }
+        finish_request(index, !failed && request->bytes_read == request->read.size);
+
+        platform_mutex_lock(&state_ptr->lock);
+    }
+    platform_mutex_unlock(&state_ptr->lock);
+    return 0;
+}
+
+// io_uring
+
+#if DPLATFORM_LINUX
+
+static i32 io_uring_setup(u32 entries, struct io_uring_params* params)
+{
+    return (i32)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static i32 io_uring_enter(i32 fd, u32 to_submit, u32 min_complete, u32 flags)
+{
+    return (i32)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, 0, 0);
+}
+
+static b8 ring_create(io_uring_queue* ring)
+{
+    struct io_uring_params params;
+    dzero_memory(&params, sizeof(params));
+    ring->fd = io_uring_setup(ASYNC_IO_RING_ENTRIES, &params);
+    if(ring->fd < 0)
+    {
+        DLOG_INFO(LOG_CATEGORY_PLATFORM, "io_uring unavailable (error %i); using the thread pool for async I/O.", errno);
+        return false;
+    }
+
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    // Since 5.4 both rings share one mapping.
+    b8 single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if(single_mmap && ring->cq_ring_size > ring->sq_ring_size)
+    {
+        ring->sq_ring_size = ring->cq_ring_size;
+    }
+    ring->sq_ring = mmap(0, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    ring->cq_ring = single_mmap ? ring->sq_ring : mmap(0, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(0, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if(ring->sq_ring == MAP_FAILED || ring->cq_ring == MAP_FAILED || ring->sqes == MAP_FAILED)
+    {
+        DLOG_WARN(LOG_CATEGORY_PLATFORM, "Failed to map the io_uring queues; using the thread pool for async I/O.");
+        if(ring->sqes != MAP_FAILED)
+        {
+            munmap(ring->sqes, ring->sqes_size);
+        }
+        if(!single_mmap && ring->cq_ring != MAP_FAILED)
+        {
+            munmap(ring->cq_ring, ring->cq_ring_size);
+        }
+        if(ring->sq_ring != MAP_FAILED)
+        {
+            munmap(ring->sq_ring, ring->sq_ring_size);
+        }
+        close(ring->fd);
+        return false;
+    }
+
+    u8* sq = ring->sq_ring;
+    ring->sq_head = (u32*)(sq + params.sq_off.head);
+    ring->sq_tail = (u32*)(sq + params.sq_off.tail);
+    ring->sq_mask = *(u32*)(sq + params.sq_off.ring_mask);
+    ring->sq_entries = params.sq_entries;
+    ring->sq_array = (u32*)(sq + params.sq_off.array);
+    u8* cq = ring->cq_ring;
+    ring->cq_head = (u32*)(cq + params.cq_off.head);
+    ring->cq_tail = (u32*)(cq + params.cq_off.tail);
+    ring->cq_mask = *(u32*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    return true;
+}
+
+static void ring_destroy(io_uring_queue* ring)
+{
+    munmap(ring->sqes, ring->sqes_size);
+    if(ring->cq_ring != ring->sq_ring)
+    {
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+    munmap(ring->sq_ring, ring->sq_ring_size);
+    close(ring->fd);
+}
+
+/**
+ * @brief Queues a read of the rest of a request, or a no-op if request is ASYNC_IO_NO_REQUEST.
+ * Requires the lock. Whoever queues entries submits them with ring_flush before releasing the
+ * lock, so the submission queue is always empty between calls and can't overflow.
+ */
+static void ring_queue(u32 request_index)
+{
+    io_uring_queue* ring = &state_ptr->ring;
+    u32 tail = *ring->sq_tail;
+    u32 slot = tail & ring->sq_mask;
+    struct io_uring_sqe* sqe = &ring->sqes[slot];
+    dzero_memory(sqe, sizeof(struct io_uring_sqe));
+    if(request_index == ASYNC_IO_NO_REQUEST)
+    {
+        sqe->opcode = IORING_OP_NOP;
+        sqe->user_data = ASYNC_IO_STOP_USER_DATA;
+    }
+    else
+    {
+        // READV rather than READ, which needs 5.6.
+        async_io_request* request = &state_ptr->requests[request_index];
+        request->iov.iov_base = (u8*)request->read.buffer + request->bytes_read;
+        request->iov.iov_len = (size_t)(request->read.size - request->bytes_read);
+        sqe->opcode = IORING_OP_READV;
+        sqe->fd = (i32)request->read.file.handle;
+        sqe->addr = (u64)&request->iov;
+        sqe->len = 1;
+        sqe->off = request->read.offset + request->bytes_read;
+        sqe->user_data = request_index;
+        request->in_ring = true;
+    }
+    ring->sq_array[slot] = slot;
+    datomic_store_u32(ring->sq_tail, tail + 1, DATOMIC_RELEASE);
+}
+
+/**
+ * @brief Hands the queued entries to the kernel. Requires the lock. On failure the entries the
+ * kernel didn't consume are taken back off the queue, so a later io_uring_enter can't submit
+ * them, and their requests are written to out_failed.
+ * @returns True if every entry was submitted.
+ */
+static b8 ring_submit(u32* out_failed, u32* out_failed_count)
+{
+    io_uring_queue* ring = &state_ptr->ring;
+    *out_failed_count = 0;
+    u32 tail = *ring->sq_tail;
+    u32 head;
+    while(!state_ptr->ring_failed && (head = datomic_load_u32(ring->sq_head, DATOMIC_ACQUIRE)) != tail)
+    {
+        if(io_uring_enter(ring->fd, tail - head, 0, 0) < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+        {
+            DLOG_ERROR(LOG_CATEGORY_PLATFORM, "io_uring_enter failed with error %i.", errno);
+            break;
+        }
+    }
+
+    head = datomic_load_u32(ring->sq_head, DATOMIC_ACQUIRE);
+    if(head == tail)
+    {
+        return true;
+    }
+    for(u32 i = head; i != tail; ++i)
+    {
+        u64 user_data = ring->sqes[i & ring->sq_mask].user_data;
+        if(user_data != ASYNC_IO_STOP_USER_DATA)
+        {
+            state_ptr->requests[user_data].in_ring = false;
+            out_failed[(*out_failed_count)++] = (u32)user_data;
+        }
+    }
+    datomic_store_u32(ring->sq_tail, head, DATOMIC_RELEASE);
+    return false;
+}
+
+/**
+ * @brief Submits everything queued and finishes whatever the kernel didn't take as failed.
+ * Requires the lock, which is released while the failed requests are finished.
+ * @returns True if every entry was submitted.
+ */
+static b8 ring_flush()
+{
+    // Submitters flush at ASYNC_IO_RING_ENTRIES, so no more are ever queued.
+    u32 failed[ASYNC_IO_RING_ENTRIES];
+    u32 failed_count;
+    b8 submitted = ring_submit(failed, &failed_count);
+    if(failed_count > 0)
+    {
+        platform_mutex_unlock(&state_ptr->lock);
+        for(u32 i = 0; i < failed_count; ++i)
+        {
+            finish_request(failed[i], false);
+        }
+        platform_mutex_lock(&state_ptr->lock);
+    }
+    return submitted;
+}
+
+// The completion thread can't go on; fails every read still in the ring so nothing waits on it.
+static void ring_fail_in_flight()
+{
+    u32 failed[ASYNC_IO_MAX_REQUESTS];
+    u32 failed_count = 0;
+    platform_mutex_lock(&state_ptr->lock);
+    state_ptr->ring_failed = true;
+    for(u32 i = 0; i < ASYNC_IO_MAX_REQUESTS; ++i)
+    {
+        if(state_ptr->requests[i].in_ring)
+        {
+            state_ptr->requests[i].in_ring = false;
+            failed[failed_count++] = i;
+        }
+    }
+    platform_mutex_unlock(&state_ptr->lock);
+
+    DLOG_ERROR(LOG_CATEGORY_PLATFORM, "Async I/O can no longer use io_uring; failing %u reads in flight.", failed_count);
+    for(u32 i = 0; i < failed_count; ++i)
+    {
+        finish_request(failed[i], false);
+    }
+}
+
+static u32 ring_thread_run(void* params)
+{
+    platform_thread_set_name("dubhe-io");
+    io_uring_queue* ring = &state_ptr->ring;
+    b8 stopping = false;
+    b8 failed = false;
+    while(!stopping && !failed)
+    {
+        if(io_uring_enter(ring->fd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+        {
+            // Still take whatever has already completed.
+            DLOG_ERROR(LOG_CATEGORY_PLATFORM, "io_uring_enter failed with error %i.", errno);
+            failed = true;
+        }
+
+        u32 head = *ring->cq_head;
+        u32 tail = datomic_load_u32(ring->cq_tail, DATOMIC_ACQUIRE);
+        for(; head != tail; ++head)
+        {
+            struct io_uring_cqe* cqe = &ring->cqes[head & ring->cq_mask];
+            if(cqe->user_data == ASYNC_IO_STOP_USER_DATA)
+            {
+                stopping = true;
+                continue;
+            }
+
+            u32 index = (u32)cqe->user_data;
+            async_io_request* request = &state_ptr->requests[index];
+            if(cqe->res > 0)
+            {
+                request->bytes_read += (u64)cqe->res;
+                if(request->bytes_read < request->read.size)
+                {
+                    // A short read before the end of the file; read the rest. Finished as failed
+                    // if the kernel won't take it.
+                    platform_mutex_lock(&state_ptr->lock);
+                    ring_queue(index);
+                    ring_flush();
+                    platform_mutex_unlock(&state_ptr->lock);
+                    continue;
+                }
+            }
+            finish_request(index, cqe->res >= 0 && request->bytes_read == request->read.size);
+        }
+        datomic_store_u32(ring->cq_head, head, DATOMIC_RELEASE);
+    }
+    if(failed && !stopping)
+    {
+        ring_fail_in_flight();
+    }
+    return 0;
+}
+
+#endif  // DPLATFORM_LINUX
+
+b8 async_io_initialize(u64* memory_requirement, void* state, b8 allow_io_uring)
+{
+    *memory_requirement = sizeof(async_io_state);
+    if(state == 0)
+    {
+        return true;
+    }
+
+    state_ptr = state;
+    dzero_memory(state_ptr, sizeof(async_io_state));
+    state_ptr->main_thread_id = platform_thread_current_id();
+    for(u32 i = 0; i < ASYNC_IO_MAX_REQUESTS; ++i)
+    {
+        state_ptr->requests[i].next_free = i + 1 < ASYNC_IO_MAX_REQUESTS ? i + 1 : ASYNC_IO_NO_REQUEST;
+    }
+    state_ptr->first_free = 0;
+
+    if(!platform_mutex_create(&state_ptr->lock) ||
+       !platform_condition_create(&state_ptr->request_done) ||
+       !platform_condition_create(&state_ptr->work_available) ||
+       !mpsc_queue_create(ASYNC_IO_MAX_REQUESTS, sizeof(async_io_completion), &state_ptr->completions))
+    {
+        DLOG_ERROR(LOG_CATEGORY_PLATFORM, "Failed to create async I/O queues.");
+        state_ptr = 0;
+        return false;
+    }
+
+#if DPLATFORM_LINUX
+    if(allow_io_uring && ring_create(&state_ptr->ring))
+    {
+        state_ptr->use_io_uring = true;
+        if(!platform_thread_create(ring_thread_run, 0, false, &state_ptr->threads[0]))
+        {
+            DLOG_ERROR(LOG_CATEGORY_PLATFORM, "Failed to start the io_uring completion thread.");
+            ring_destroy(&state_ptr->ring);
+            state_ptr->use_io_uring = false;
+        }
+        else
+        {
+            state_ptr->thread_count = 1;
+        }
+    }
+#endif
+
+    if(!state_ptr->use_io_uring)
+    {
+        for(u32 i = 0; i < ASYNC_IO_POOL_THREADS; ++i)
+        {
+            if(!platform_thread_create(pool_thread_run, 0, false, &state_ptr->threads[i]))
+            {
+                DLOG_ERROR(LOG_CATEGORY_PLATFORM, "Failed to start async I/O thread %u.", i);
+                async_io_shutdown(state_ptr);
+                return false;
+            }
+            state_ptr->thread_count = i + 1;
+        }
+    }
+
+    DLOG_INFO(LOG_CATEGORY_PLATFORM, "Async I/O initialized using %s.", state_ptr->use_io_uring ? "io_uring" : "a thread pool");
+    return true;
+}
+
+void async_io_shutdown(void* state)
+{
+    if(!state_ptr)
+    {
+        return;
+    }
+
+    platform_mutex_lock(&state_ptr->lock);
+    while(state_ptr->in_flight > 0)
+    {
+        platform_condition_wait(&state_ptr->request_done, &state_ptr->lock);
+    }
+    state_ptr->stopping = true;
+#if DPLATFORM_LINUX
+    if(state_ptr->use_io_uring && !state_ptr->ring_failed)
+    {
+        ring_queue(ASYNC_IO_NO_REQUEST);
+        if(!ring_flush())
+        {
+            // Nothing will wake the completion thread, so it can't be joined, and it still
+            // waits on the ring; leave both.
+            DLOG_ERROR(LOG_CATEGORY_PLATFORM, "Failed to stop the io_uring completion thread; leaving it running.");
+            state_ptr->thread_count = 0;
+            state_ptr->use_io_uring = false;
+        }
+    }
+#endif
+    platform_condition_broadcast(&state_ptr->work_available);
+    platform_mutex_unlock(&state_ptr->lock);
+
+    for(u32 i = 0; i < state_ptr->thread_count; ++i)
+    {
+        platform_thread_join(&state_ptr->threads[i], 0);
+    }
+#if DPLATFORM_LINUX
+    if(state_ptr->use_io_uring)
+    {
+        ring_destroy(&state_ptr->ring);
+    }
+#endif
+
+    mpsc_queue_destroy(&state_ptr->completions);
+    platform_condition_destroy(&state_ptr->work_available);
+    platform_condition_destroy(&state_ptr->request_done);
+    platform_mutex_destroy(&state_ptr->lock);
+    state_ptr = 0;
+}
+
+b8 async_io_uses_io_uring()
+{
+    return state_ptr && state_ptr->use_io_uring;
+}
+
+b8 async_io_open(const char* path, async_file* out_file, u64* out_size)
+{
+#if DPLATFORM_WINDOWS
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if(file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    if(out_size)
+    {
+        LARGE_INTEGER size;
+        if(!GetFileSizeEx(file, &size))
+        {
+            CloseHandle(file);
+            return false;
+        }
+        *out_size = (u64)size.QuadPart;
+    }
+    out_file->handle = (u64)file;
+#else
+    i32 fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+    {
+        return false;
+    }
+    if(out_size)
+    {
+        struct stat buffer;
+        if(fstat(fd, &buffer) != 0)
+        {
+            close(fd);
+            return false;
+        }
+        *out_size = (u64)buffer.st_size;
+    }
+    out_file->handle = (u64)fd;
+#endif
+    return true;
+}
+
+void async_io_close(async_file* file)
+{
+#if DPLATFORM_WINDOWS
+    CloseHandle((HANDLE)file->handle);
+#else
+    close((i32)file->handle);
+#endif
+    file->handle = 0;
+}
+
+b8 async_io_submit(const async_read* reads, u32 count)
+{
+    if(!state_ptr)
+    {
+        return false;
+    }
+    for(u32 i = 0; i < count; ++i)
+    {
+        if(!reads[i].buffer && reads[i].size > 0)
+        {
+            DLOG_ERROR(LOG_CATEGORY_PLATFORM, "async_io_submit: read %u has no buffer.", i);
+            return false;
+        }
+    }
+
+    b8 on_main_thread = platform_thread_current_id() == state_ptr->main_thread_id;
+    for(u32 i = 0; i < count; ++i)
+    {
+        if(reads[i].counter)
+        {
+            datomic_fetch_add_u32(&reads[i].counter->value, 1, DATOMIC_RELAXED);
+        }
+    }
+
+    platform_mutex_lock(&state_ptr->lock);
+#if DPLATFORM_LINUX
+    u32 queued = 0;
+#endif
+    for(u32 i = 0; i < count; ++i)
+    {
+        while(state_ptr->first_free == ASYNC_IO_NO_REQUEST)
+        {
+#if DPLATFORM_LINUX
+            // Let the kernel start what's queued before waiting on it.
+            if(state_ptr->use_io_uring && queued > 0)
+            {
+                ring_flush();
+                queued = 0;
+            }
+#endif
+            if(on_main_thread)
+            {
+                // Requests with callbacks are only freed by async_io_update, which is ours to run.
+                platform_mutex_unlock(&state_ptr->lock);
+                async_io_update();
+                platform_mutex_lock(&state_ptr->lock);
+                if(state_ptr->first_free != ASYNC_IO_NO_REQUEST)
+                {
+                    break;
+                }
+                platform_condition_wait_timeout(&state_ptr->request_done, &state_ptr->lock, 1);
+            }
+            else
+            {
+                platform_condition_wait(&state_ptr->request_done, &state_ptr->lock);
+            }
+        }
+
+        u32 index = state_ptr->first_free;
+        async_io_request* request = &state_ptr->requests[index];
+        state_ptr->first_free = request->next_free;
+        request->read = reads[i];
+        request->bytes_read = 0;
+        state_ptr->in_flight++;
+
+        if(request->read.size == 0)
+        {
+            // Nothing to read; finish it here rather than bother the kernel or a thread.
+#if DPLATFORM_LINUX
+            if(state_ptr->use_io_uring && queued > 0)
+            {
+                ring_flush();
+                queued = 0;
+            }
+#endif
+            platform_mutex_unlock(&state_ptr->lock);
+            finish_request(index, true);
+            platform_mutex_lock(&state_ptr->lock);
+            continue;
+        }
+
+#if DPLATFORM_LINUX
+        if(state_ptr->use_io_uring)
+        {
+            ring_queue(index);
+            // The submission queue only holds so many entries; the kernel rounds sq_entries up
+            // from ASYNC_IO_RING_ENTRIES.
+            if(++queued == ASYNC_IO_RING_ENTRIES)
+            {
+                ring_flush();
+                queued = 0;
+            }
+            continue;
+        }
+#endif
+        state_ptr->pending[(state_ptr->pending_head + state_ptr->pending_count) % ASYNC_IO_MAX_REQUESTS] = index;
+        state_ptr->pending_count++;
+        platform_condition_signal(&state_ptr->work_available);
+    }
+#if DPLATFORM_LINUX
+    if(state_ptr->use_io_uring && queued > 0)
+    {
+        ring_flush();
+    }
+#endif
+    platform_mutex_unlock(&state_ptr->lock);
+    return true;
+}
+
+void async_io_update()
+{
+    if(!state_ptr)
+    {
+        return;
+    }
+
+    // Only run what finished before this point; reads finishing meanwhile wait for next frame.
+    u64 count = mpsc_queue_claimed(&state_ptr->completions) - mpsc_queue_consumed(&state_ptr->completions);
+    async_io_completion completion;
+    for(u64 i = 0; i < count && mpsc_queue_pop(&state_ptr->completions, &completion); ++i)
+    {
+        async_io_request* request = &state_ptr->requests[completion.request];
+        request->read.on_complete(request->read.params, completion.succeeded, request->bytes_read);
+
+        platform_mutex_lock(&state_ptr->lock);
+        free_request(completion.request);
+        platform_mutex_unlock(&state_ptr->lock);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "defines.h"
+#include "core/job_system.h"
+
+/*
+ Asynchronous file reads. Reads are submitted in batches from any thread and finish in the
+ background; each can bump a job_counter down when it finishes (wait with job_wait) and queue a
+ callback for the main thread (run by async_io_update).
+
+ On Linux reads go through io_uring, with one thread reaping completions. Where io_uring is
+ missing or blocked (older kernels, some containers) and on Windows, a small pool of threads
+ does blocking positional reads instead.
+*/
+
+typedef struct async_file
+{
+    // Native handle (file descriptor or HANDLE).
+    u64 handle;
+} async_file;
+
+/**
+ * @brief Runs on the main thread, from async_io_update, after a read has finished.
+ * @param params The params the read was submitted with.
+ * @param succeeded True if all of the requested bytes were read.
+ * @param bytes_read The number of bytes read; less than requested at the end of the file.
+ */
+typedef void (*pfn_async_read_complete)(void* params, b8 succeeded, u64 bytes_read);
+
+typedef struct async_read
+{
+    async_file file;
+    u64 offset;
+    u64 size;
+    // Receives the data. Owned by the submitter and must stay valid until the read has finished.
+    void* buffer;
+    // Optional.
+    pfn_async_read_complete on_complete;
+    // Passed to on_complete.
+    void* params;
+    // Optional. Incremented on submit, decremented when the read finishes, before on_complete runs.
+    job_counter* counter;
+} async_read;
+
+/**
+ * @brief Initializes asynchronous I/O. Call twice: once with state 0 to get the memory
+ * requirement, then with a block of that size. Must be called from the main thread.
+ *
+ * @param memory_requirement Receives the size of the state.
+ * @param state A block of memory_requirement bytes, or 0.
+ * @param allow_io_uring False to use the thread pool even where io_uring is available.
+ * @returns True on success; otherwise false.
+ */
+DAPI b8 async_io_initialize(u64* memory_requirement, void* state, b8 allow_io_uring);
+
+/**
+ * @brief Waits for the reads in flight and stops the I/O threads. Callbacks not yet run by
+ * async_io_update are dropped.
+ */
+DAPI void async_io_shutdown(void* state);
+
+/**
+ * @returns True if reads go through io_uring rather than the thread pool.
+ */
+DAPI b8 async_io_uses_io_uring();
+
+/**
+ * @brief Opens a file for asynchronous reads.
+ *
+ * @param path The path of the file.
+ * @param out_file Receives the file.
+ * @param out_size Optional. Receives the size of the file in bytes.
+ * @returns True on success; otherwise false.
+ */
+DAPI b8 async_io_open(const char* path, async_file* out_file, u64* out_size);
+
+/**
+ * @brief Closes a file. No reads of it may be in flight.
+ */
+DAPI void async_io_close(async_file* file);
+
+/**
+ * @brief Starts a batch of reads. Blocks only if too many reads are already in flight or
+ * waiting for their callbacks.
+ *
+ * @param reads The reads. Copied, so the array can be reused straight away.
+ * @param count The number of reads.
+ * @returns False if asynchronous I/O is not initialized or a read is invalid; no reads are
+ *          started then.
+ */
+DAPI b8 async_io_submit(const async_read* reads, u32 count);
+
+/**
+ * @brief Runs the callbacks of reads finished since the last call. Called once a frame by the
+ * application; call it from the main thread only.
+ */
+DAPI void async_io_update();
\ No newline at end of file
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+ Atomic operations on naturally aligned 32 bit, 64 bit and pointer values.
+ Thin inline wrappers over the compiler builtins, so they cost the same as using the
+ builtins directly. Every operation takes an explicit memory order; use
+ DATOMIC_SEQ_CST when in doubt.
+*/
+
+#if !defined(__clang__) && !defined(__GNUC__)
+#error "platform/atomic.h requires the __atomic builtins (clang or gcc)."
+#endif
+
+typedef enum datomic_order
+{
+    // Atomicity only; no ordering with respect to other memory accesses.
+    DATOMIC_RELAXED = __ATOMIC_RELAXED,
+    // Later accesses cannot move before this load. Pairs with a release store.
+    DATOMIC_ACQUIRE = __ATOMIC_ACQUIRE,
+    // Earlier accesses cannot move after this store. Pairs with an acquire load.
+    DATOMIC_RELEASE = __ATOMIC_RELEASE,
+    // Acquire and release, for read-modify-write operations.
+    DATOMIC_ACQ_REL = __ATOMIC_ACQ_REL,
+    // A single total order over all sequentially consistent operations.
+    DATOMIC_SEQ_CST = __ATOMIC_SEQ_CST
+} datomic_order;
+
+// The strongest order a failed compare-exchange (which only loads) may use.
+DINLINE datomic_order datomic_failure_order(datomic_order order)
+{
+    if(order == DATOMIC_RELEASE)
+    {
+        return DATOMIC_RELAXED;
+    }
+    if(order == DATOMIC_ACQ_REL)
+    {
+        return DATOMIC_ACQUIRE;
+    }
+    return order;
+}
+
+// u32
+
+DINLINE u32 datomic_load_u32(const volatile u32* object, datomic_order order)
+{
+    return __atomic_load_n(object, order);
+}
+
+DINLINE void datomic_store_u32(volatile u32* object, u32 value, datomic_order order)
+{
+    __atomic_store_n(object, value, order);
+}
+
+/** @returns The value before the addition. */
+DINLINE u32 datomic_fetch_add_u32(volatile u32* object, u32 value, datomic_order order)
+{
+    return __atomic_fetch_add(object, value, order);
+}
+
+/** @returns The value before the subtraction. */
+DINLINE u32 datomic_fetch_sub_u32(volatile u32* object, u32 value, datomic_order order)
+{
+    return __atomic_fetch_sub(object, value, order);
+}
+
+/** @returns The previous value. */
+DINLINE u32 datomic_exchange_u32(volatile u32* object, u32 value, datomic_order order)
+{
+    return __atomic_exchange_n(object, value, order);
+}
+
+/**
+ * Stores desired if object holds *expected. On failure, *expected is updated to the current value.
+ * The weak form may fail spuriously and is meant for retry loops.
+ * @returns True if desired was stored.
+ */
+DINLINE b8 datomic_compare_exchange_weak_u32(volatile u32* object, u32* expected, u32 desired, datomic_order order)
+{
+    return __atomic_compare_exchange_n(object, expected, desired, true, order, datomic_failure_order(order));
+}
+
+DINLINE b8 datomic_compare_exchange_strong_u32(volatile u32* object, u32* expected, u32 desired, datomic_order order)
+{
+    return __atomic_compare_exchange_n(object, expected, desired, false, order, datomic_failure_order(order));
+}
+
+// u64
+
+DINLINE u64 datomic_load_u64(const volatile u64* object, datomic_order order)
+{
+    return __atomic_load_n(object, order);
+}
+
+DINLINE void datomic_store_u64(volatile u64* object, u64 value, datomic_order order)
+{
+    __atomic_store_n(object, value, order);
+}
+
+DINLINE u64 datomic_fetch_add_u64(volatile u64* object, u64 value, datomic_order order)
+{
+    return __atomic_fetch_add(object, value, order);
+}
+
+DINLINE u64 datomic_fetch_sub_u64(volatile u64* object, u64 value, datomic_order order)
+{
+    return __atomic_fetch_sub(object, value, order);
+}
+
+DINLINE u64 datomic_exchange_u64(volatile u64* object, u64 value, datomic_order order)
+{
+    return __atomic_exchange_n(object, value, order);
+}
+
+DINLINE b8 datomic_compare_exchange_weak_u64(volatile u64* object, u64* expected, u64 desired, datomic_order order)
+{
+    return __atomic_compare_exchange_n(object, expected, desired, true, order, datomic_failure_order(order));
+}
+
+DINLINE b8 datomic_compare_exchange_strong_u64(volatile u64* object, u64* expected, u64 desired, datomic_order order)
+{
+    return __atomic_compare_exchange_n(object, expected, desired, false, order, datomic_failure_order(order));
+}
+
+// Pointers
+
+DINLINE void* datomic_load_ptr(void* const volatile* object, datomic_order order)
+{
+    return __atomic_load_n(object, order);
+}
+
+DINLINE void datomic_store_ptr(void* volatile* object, void* value, datomic_order order)
+{
+    __atomic_store_n(object, value, order);
+}
+
+DINLINE void* datomic_exchange_ptr(void* volatile* object, void* value, datomic_order order)
+{
+    return __atomic_exchange_n(object, value, order);
+}
+
+DINLINE b8 datomic_compare_exchange_strong_ptr(void* volatile* object, void** expected, void* desired, datomic_order order)
+{
+    return __atomic_compare_exchange_n(object, expected, desired, false, order, datomic_failure_order(order));
+}
+
+// Fences and spinning
+
+DINLINE void datomic_thread_fence(datomic_order order)
+{
+    __atomic_thread_fence(order);
+}
+
+/**
+ * Hints to the CPU that the caller is spinning on a value, to save power and give
+ * the sibling hyperthread the core. Call once per iteration of a spin-wait loop.
+ */
+DINLINE void datomic_pause()
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+ Loading shared libraries at runtime: dlopen on Linux (dynamic_library_linux.c) and
+ LoadLibrary on Windows (dynamic_library_win32.c).
+*/
+
+typedef struct dynamic_library
+{
+    // Platform-specific handle.
+    void* internal_data;
+} dynamic_library;
+
+/**
+ * @brief Loads the shared library at path.
+ *
+ * @param path The path of the library, including its extension.
+ * @param out_library Receives the library.
+ * @returns True on success; otherwise false.
+ */
+DAPI b8 platform_dynamic_library_load(const char* path, dynamic_library* out_library);
+
+/**
+ * @brief Unloads the library. Pointers to its functions and data must not be used afterwards.
+ */
+DAPI void platform_dynamic_library_unload(dynamic_library* library);
+
+/**
+ * @brief Looks up an exported function or variable.
+ *
+ * @returns The symbol's address, or 0 if the library doesn't export it.
+ */
+DAPI void* platform_dynamic_library_symbol(dynamic_library* library, const char* name);
\ No newline at end of file
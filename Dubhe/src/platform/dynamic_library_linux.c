@@ -0,0 +1,41 @@
+#include "platform/dynamic_library.h"
+
+// Linux shared libraries.
+#if DPLATFORM_LINUX
+
+#include "core/logger.h"
+
+#include <dlfcn.h>
+
+b8 platform_dynamic_library_load(const char* path, dynamic_library* out_library)
+{
+    // Resolve everything now, so a library with missing symbols fails here rather than mid-frame.
+    void* handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if(!handle)
+    {
+        DLOG_ERROR(LOG_CATEGORY_PLATFORM, "Failed to load library '%s': %s", path, dlerror());
+        return false;
+    }
+    out_library->internal_data = handle;
+    return true;
+}
+
+void platform_dynamic_library_unload(dynamic_library* library)
+{
+    if(library && library->internal_data)
+    {
+        dlclose(library->internal_data);
+        library->internal_data = 0;
+    }
+}
+
+void* platform_dynamic_library_symbol(dynamic_library* library, const char* name)
+{
+    if(!library || !library->internal_data)
+    {
+        return 0;
+    }
+    return dlsym(library->internal_data, name);
+}
+
+#endif  // DPLATFORM_LINUX
\ No newline at end of file
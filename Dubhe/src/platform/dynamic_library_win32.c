@@ -0,0 +1,40 @@
+#include "platform/dynamic_library.h"
+
+// Windows DLLs.
+#if DPLATFORM_WINDOWS
+
+#include "core/logger.h"
+
+#include <windows.h>
+
+b8 platform_dynamic_library_load(const char* path, dynamic_library* out_library)
+{
+    HMODULE module = LoadLibraryA(path);
+    if(!module)
+    {
+        DLOG_ERROR(LOG_CATEGORY_PLATFORM, "Failed to load library '%s': error %u.", path, (u32)GetLastError());
+        return false;
+    }
+    out_library->internal_data = module;
+    return true;
+}
+
+void platform_dynamic_library_unload(dynamic_library* library)
+{
+    if(library && library->internal_data)
+    {
+        FreeLibrary((HMODULE)library->internal_data);
+        library->internal_data = 0;
+    }
+}
+
+void* platform_dynamic_library_symbol(dynamic_library* library, const char* name)
+{
+    if(!library || !library->internal_data)
+    {
+        return 0;
+    }
+    return (void*)GetProcAddress((HMODULE)library->internal_data, name);
+}
+
+#endif  // DPLATFORM_WINDOWS
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+ Fibers: user-mode execution contexts with their own stacks, switched cooperatively.
+ Implemented with Win32 Fibers in fiber_win32.c and with ucontext in fiber_linux.c.
+
+ A thread must be converted into a fiber before it can switch to other fibers. A fiber can
+ be resumed on any thread, but only by one thread at a time.
+*/
+
+/**
+ * @brief A fiber's entry point. It must never return; switch away from the fiber instead.
+ * @param params The params passed to platform_fiber_create.
+ */
+typedef void (*pfn_fiber_start)(void* params);
+
+typedef struct platform_fiber
+{
+    // Platform-specific context.
+    void* internal_data;
+} platform_fiber;
+
+/**
+ * @brief Turns the calling thread into a fiber, so it can switch to other fibers and be
+ * switched back to.
+ *
+ * @param out_fiber Receives the fiber representing the thread.
+ * @returns True on success; otherwise false.
+ */
+DAPI b8 platform_fiber_convert_thread(platform_fiber* out_fiber);
+
+/**
+ * @brief Turns the calling thread back into a plain thread. It must be running its own
+ * fiber, the one from platform_fiber_convert_thread.
+ */
+DAPI void platform_fiber_convert_to_thread(platform_fiber* thread_fiber);
+
+/**
+ * @brief Creates a fiber which will run start_function(params) when first switched to.
+ *
+ * @param stack_size The size of the fiber's stack in bytes.
+ * @param start_function The entry point. Must never return.
+ * @param params Passed to start_function.
+ * @param out_fiber Receives the fiber.
+ * @returns True on success; otherwise false.
+ */
+DAPI b8 platform_fiber_create(u64 stack_size, pfn_fiber_start start_function, void* params, platform_fiber* out_fiber);
+
+/**
+ * @brief Frees a fiber and its stack. It must not be running on any thread.
+ */
+DAPI void platform_fiber_destroy(platform_fiber* fiber);
+
+/**
+ * @brief Saves the calling fiber's context into from and continues running to.
+ * Returns when another thread or fiber switches back to from.
+ *
+ * @param from The fiber currently running on the calling thread.
+ * @param to The fiber to run.
+ */
+DAPI void platform_fiber_switch(platform_fiber* from, platform_fiber* to);
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include "platform/fiber.h"
+
+// Linux fibers.
+#if DPLATFORM_LINUX
+
+#include "core/logger.h"
+#include "platform/platform.h"
+
+#include <ucontext.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+typedef struct linux_fiber
+{
+    ucontext_t context;
+    // 0 for a converted thread, which keeps running on its own stack. Otherwise the mapping,
+    // whose lowest page is the guard page.
+    void* stack;
+    u64 stack_mapping_size;
+    pfn_fiber_start start_function;
+    void* params;
+} linux_fiber;
+
+// makecontext only passes int arguments, so the pointer is split in two.
+static void fiber_entry(u32 low, u32 high)
+{
+    linux_fiber* fiber = (linux_fiber*)(((u64)high << 32) | (u64)low);
+    fiber->start_function(fiber->params);
+
+    DLOG_ERROR(LOG_CATEGORY_PLATFORM, "A fiber returned from its start function.");
+}
+
+b8 platform_fiber_convert_thread(platform_fiber* out_fiber)
+{
+    linux_fiber* fiber = platform_allocate(sizeof(linux_fiber), false);
+    platform_zero_memory(fiber, sizeof(linux_fiber));
+    // The context is filled in by the first switch away from this thread.
+    out_fiber->internal_data = fiber;
+    return true;
+}
+
+void platform_fiber_convert_to_thread(platform_fiber* thread_fiber)
+{
+    if(thread_fiber && thread_fiber->internal_data)
+    {
+        platform_free(thread_fiber->internal_data, false);
+        thread_fiber->internal_data = 0;
+    }
+}
+
+b8 platform_fiber_create(u64 stack_size, pfn_fiber_start start_function, void* params, platform_fiber* out_fiber)
+{
+    linux_fiber* fiber = platform_allocate(sizeof(linux_fiber), false);
+    platform_zero_memory(fiber, sizeof(linux_fiber));
+    fiber->start_function = start_function;
+    fiber->params = params;
+
+    // Stacks grow down, so an inaccessible page below the stack turns an overflow into a fault
+    // instead of silently corrupting whatever was allocated next to it.
+    u64 page_size = (u64)sysconf(_SC_PAGESIZE);
+    stack_size = (stack_size + page_size - 1) & ~(page_size - 1);
+    fiber->stack_mapping_size = page_size + stack_size;
+    fiber->stack = mmap(0, fiber->stack_mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if(fiber->stack == MAP_FAILED)
+    {
+        fiber->stack = 0;
+    }
+
+    if(!fiber->stack || mprotect(fiber->stack, page_size, PROT_NONE) != 0 || getcontext(&fiber->context) != 0)
+    {
+        DLOG_ERROR(LOG_CATEGORY_PLATFORM, "Failed to create fiber context.");
+        if(fiber->stack)
+        {
+            munmap(fiber->stack, fiber->stack_mapping_size);
+        }
+        platform_free(fiber, false);
+        return false;
+    }
+    fiber->context.uc_stack.ss_sp = (u8*)fiber->stack + page_size;
+    fiber->context.uc_stack.ss_size = stack_size;
+    // Returning would end the thread; fiber_entry never does.
+    fiber->context.uc_link = 0;
+    u64 address = (u64)fiber;
+    makecontext(&fiber->context, (void (*)(void))fiber_entry, 2, (u32)(address & 0xFFFFFFFF), (u32)(address >> 32));
+
+    out_fiber->internal_data = fiber;
+    return true;
+}
+
+void platform_fiber_destroy(platform_fiber* fiber)
+{
+    if(fiber && fiber->internal_data)
+    {
+        linux_fiber* internal = fiber->internal_data;
+        if(internal->stack)
+        {
+            munmap(internal->stack, internal->stack_mapping_size);
+        }
+        platform_free(internal, false);
+        fiber->internal_data = 0;
+    }
+}
+
+void platform_fiber_switch(platform_fiber* from, platform_fiber* to)
+{
+    // NOTE: swapcontext also saves and restores the signal mask, which costs a syscall per
+    // switch. Fine at task granularity; a hand-written switch would avoid it.
+    linux_fiber* from_fiber = from->internal_data;
+    linux_fiber* to_fiber = to->internal_data;
+    swapcontext(&from_fiber->context, &to_fiber->context);
+}
+
+#endif  // DPLATFORM_LINUX
\ No newline at end of file
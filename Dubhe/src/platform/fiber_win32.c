@@ -0,0 +1,94 @@
+#include "platform/fiber.h"
+
+// Windows fibers.
+#if DPLATFORM_WINDOWS
+
+#include "core/logger.h"
+#include "platform/platform.h"
+
+#include <windows.h>
+
+typedef struct win32_fiber
+{
+    // Fiber address from CreateFiberEx or ConvertThreadToFiberEx.
+    void* handle;
+    b8 is_thread;
+    pfn_fiber_start start_function;
+    void* params;
+} win32_fiber;
+
+static VOID CALLBACK fiber_entry(LPVOID params)
+{
+    win32_fiber* fiber = params;
+    fiber->start_function(fiber->params);
+
+    DLOG_ERROR(LOG_CATEGORY_PLATFORM, "A fiber returned from its start function.");
+}
+
+b8 platform_fiber_convert_thread(platform_fiber* out_fiber)
+{
+    win32_fiber* fiber = platform_allocate(sizeof(win32_fiber), false);
+    platform_zero_memory(fiber, sizeof(win32_fiber));
+    // Don't save floating point state on switches; it's the same throughout the engine.
+    fiber->handle = ConvertThreadToFiberEx(fiber, 0);
+    if(!fiber->handle)
+    {
+        DLOG_ERROR(LOG_CATEGORY_PLATFORM, "ConvertThreadToFiberEx failed with error %u.", (u32)GetLastError());
+        platform_free(fiber, false);
+        return false;
+    }
+    fiber->is_thread = true;
+    out_fiber->internal_data = fiber;
+    return true;
+}
+
+void platform_fiber_convert_to_thread(platform_fiber* thread_fiber)
+{
+    if(thread_fiber && thread_fiber->internal_data)
+    {
+        ConvertFiberToThread();
+        platform_free(thread_fiber->internal_data, false);
+        thread_fiber->internal_data = 0;
+    }
+}
+
+b8 platform_fiber_create(u64 stack_size, pfn_fiber_start start_function, void* params, platform_fiber* out_fiber)
+{
+    win32_fiber* fiber = platform_allocate(sizeof(win32_fiber), false);
+    platform_zero_memory(fiber, sizeof(win32_fiber));
+    fiber->start_function = start_function;
+    fiber->params = params;
+    // Commit the whole stack up front so a deep call never faults in the middle of a task.
+    fiber->handle = CreateFiberEx((SIZE_T)stack_size, (SIZE_T)stack_size, 0, fiber_entry, fiber);
+    if(!fiber->handle)
+    {
+        DLOG_ERROR(LOG_CATEGORY_PLATFORM, "CreateFiberEx failed with error %u.", (u32)GetLastError());
+        platform_free(fiber, false);
+        return false;
+    }
+    out_fiber->internal_data = fiber;
+    return true;
+}
+
+void platform_fiber_destroy(platform_fiber* fiber)
+{
+    if(fiber && fiber->internal_data)
+    {
+        win32_fiber* internal = fiber->internal_data;
+        if(!internal->is_thread)
+        {
+            DeleteFiber(internal->handle);
+        }
+        platform_free(internal, false);
+        fiber->internal_data = 0;
+    }
+}
+
+void platform_fiber_switch(platform_fiber* from, platform_fiber* to)
+{
+    // Windows saves the current context itself.
+    win32_fiber* to_fiber = to->internal_data;
+    SwitchToFiber(to_fiber->handle);
+}
+
+#endif  // DPLATFORM_WINDOWS
\ No newline at end of file
@@ -2,22 +2,236 @@
 
 #include "core/dmemory.h"
 #include "core/logger.h"
+#include "platform/platform.h"
+#include "platform/atomic.h"
 
 #include <stdio.h>
 #include <string.h>
+#include <signal.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 
+#if DPLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+typedef struct file_write_buffer
+{
+    u8* data;
+    u64 size;
+    u64 used;
+    u32 flush_policy;
+    f64 flush_interval;
+    f64 last_flush_time;
+} file_write_buffer;
+
+// Buffered handles which should be flushed if the process crashes. Atomic, since files are
+// opened and closed from several threads and the slots are read from the signal handler.
+#define MAX_CRASH_FLUSH_HANDLES 16
+static void* crash_flush_handles[MAX_CRASH_FLUSH_HANDLES];
+// Atomic. Set by the first registration, which installs the handlers.
+static u32 crash_handlers_installed = 0;
+
+#define CRASH_SIGNAL_COUNT 4
+static const i32 crash_signals[CRASH_SIGNAL_COUNT] = {SIGSEGV, SIGABRT, SIGFPE, SIGILL};
+
+// The handlers that were in place before ours, which a crash is passed on to.
+#if DPLATFORM_WINDOWS
+typedef void (*crash_handler)(i32);
+static crash_handler previous_crash_handlers[CRASH_SIGNAL_COUNT];
+#else
+static struct sigaction previous_crash_actions[CRASH_SIGNAL_COUNT];
+#endif
+
+static b8 write_buffer_drain(file_handle* handle, b8 flush_os)
+{
+    file_write_buffer* buffer = handle->write_buffer;
+    b8 result = true;
+    if(buffer->used > 0)
+    {
+        result = fwrite(buffer->data, 1, buffer->used, (FILE*)handle->handle) == buffer->used;
+        buffer->used = 0;
+    }
+    if(flush_os)
+    {
+        fflush((FILE*)handle->handle);
+        buffer->last_flush_time = platform_get_absolute_time();
+    }
+    return result;
+}
+
+static void crash_signal_handler(i32 sig)
+{
+    // Best effort: stdio is not async-signal-safe, but the process is going down anyway.
+    for(u32 i = 0; i < MAX_CRASH_FLUSH_HANDLES; i++)
+    {
+        file_handle* handle = datomic_load_ptr(&crash_flush_handles[i], DATOMIC_ACQUIRE);
+        if(handle && handle->handle && handle->write_buffer)
+        {
+            file_write_buffer* buffer = handle->write_buffer;
+            fwrite(buffer->data, 1, buffer->used, (FILE*)handle->handle);
+            buffer->used = 0;
+            fflush((FILE*)handle->handle);
+        }
+    }
+
+    // Hand the signal to whoever had it before: a crash reporter, a sanitizer, or the default.
+    for(u32 i = 0; i < CRASH_SIGNAL_COUNT; i++)
+    {
+        if(crash_signals[i] == sig)
+        {
+#if DPLATFORM_WINDOWS
+            signal(sig, previous_crash_handlers[i] == SIG_ERR ? SIG_DFL : previous_crash_handlers[i]);
+#else
+            sigaction(sig, &previous_crash_actions[i], 0);
+#endif
+            break;
+        }
+    }
+    raise(sig);
+}
+
+static void crash_handlers_install()
+{
+    for(u32 i = 0; i < CRASH_SIGNAL_COUNT; i++)
+    {
+#if DPLATFORM_WINDOWS
+        previous_crash_handlers[i] = signal(crash_signals[i], crash_signal_handler);
+#else
+        struct sigaction action;
+        dzero_memory(&action, sizeof(action));
+        action.sa_handler = crash_signal_handler;
+        sigemptyset(&action.sa_mask);
+        sigaction(crash_signals[i], &action, &previous_crash_actions[i]);
+#endif
+    }
+}
+
+static void crash_flush_register(file_handle* handle)
+{
+    u32 not_installed = 0;
+    if(datomic_compare_exchange_strong_u32(&crash_handlers_installed, &not_installed, 1, DATOMIC_ACQ_REL))
+    {
+        crash_handlers_install();
+    }
+
+    for(u32 i = 0; i < MAX_CRASH_FLUSH_HANDLES; i++)
+    {
+        void* empty = 0;
+        if(datomic_compare_exchange_strong_ptr(&crash_flush_handles[i], &empty, handle, DATOMIC_ACQ_REL))
+        {
+            return;
+        }
+    }
+    DWARN("Too many files registered to flush on crash. '%p' will not be flushed.", handle);
+}
+
+static void crash_flush_unregister(file_handle* handle)
+{
+    for(u32 i = 0; i < MAX_CRASH_FLUSH_HANDLES; i++)
+    {
+        void* expected = handle;
+        datomic_compare_exchange_strong_ptr(&crash_flush_handles[i], &expected, 0, DATOMIC_ACQ_REL);
+    }
+}
+
 b8 filesystem_exists(const char* path)
 {
+#if DPLATFORM_WINDOWS
     struct _stat buffer;
     return _stat(path, &buffer) == 0;
+#else
+    struct stat buffer;
+    return stat(path, &buffer) == 0;
+#endif
+}
+
+b8 filesystem_delete(const char* path)
+{
+    return remove(path) == 0;
+}
+
+b8 filesystem_rename(const char* old_path, const char* new_path)
+{
+    // rename() does not replace existing files on every platform.
+    if(filesystem_exists(new_path))
+    {
+        remove(new_path);
+    }
+    return rename(old_path, new_path) == 0;
+}
+
+b8 filesystem_copy(const char* source_path, const char* dest_path)
+{
+    FILE* source = fopen(source_path, "rb");
+    if(!source)
+    {
+        return false;
+    }
+    FILE* dest = fopen(dest_path, "wb");
+    if(!dest)
+    {
+        fclose(source);
+        return false;
+    }
+
+    u8 chunk[64 * 1024];
+    b8 result = true;
+    u64 read;
+    while((read = fread(chunk, 1, sizeof(chunk), source)) > 0)
+    {
+        if(fwrite(chunk, 1, read, dest) != read)
+        {
+            result = false;
+            break;
+        }
+    }
+    if(ferror(source))
+    {
+        result = false;
+    }
+    fclose(source);
+    if(fclose(dest) != 0)
+    {
+        result = false;
+    }
+    return result;
+}
+
+b8 filesystem_last_write_time(const char* path, u64* out_time)
+{
+#if DPLATFORM_WINDOWS
+    // st_mtime only has whole seconds; the FILETIME has 100ns steps.
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if(!GetFileAttributesExA(path, GetFileExInfoStandard, &attributes))
+    {
+        return false;
+    }
+    ULARGE_INTEGER write_time;
+    write_time.LowPart = attributes.ftLastWriteTime.dwLowDateTime;
+    write_time.HighPart = attributes.ftLastWriteTime.dwHighDateTime;
+    *out_time = write_time.QuadPart * 100ull;
+#else
+    struct stat buffer;
+    if(stat(path, &buffer) != 0)
+    {
+        return false;
+    }
+    *out_time = (u64)buffer.st_mtim.tv_sec * 1000000000ull + (u64)buffer.st_mtim.tv_nsec;
+#endif
+    return true;
 }
 
 b8 filesystem_open(const char* path, file_modes mode, b8 binary, file_handle* out_handle)
 {
     out_handle->is_valid = false;
     out_handle->handle = 0;
+    out_handle->write_buffer = 0;
     const char* mode_str;
 
     if((mode & FILE_MODE_READ) != 0 && (mode & FILE_MODE_WRITE) != 0)
@@ -56,6 +270,15 @@ void filesystem_close(file_handle* handle)
 {
     if(handle->handle)
     {
+        if(handle->write_buffer)
+        {
+            file_write_buffer* buffer = handle->write_buffer;
+            write_buffer_drain(handle, true);
+            crash_flush_unregister(handle);
+            dfree(buffer->data, buffer->size, MEMORY_TAG_FILE);
+            dfree(buffer, sizeof(file_write_buffer), MEMORY_TAG_FILE);
+            handle->write_buffer = 0;
+        }
         fclose((FILE*)handle->handle);
         handle->handle = 0;
         handle->is_valid = false;
@@ -71,16 +294,121 @@ b8 filesystem_read_line(file_handle* handle, char** line_buf)
         if(fgets(buffer, 32000, (FILE*)handle->handle) != 0)
         {
             u64 length = strlen(buffer);
-            *line_buf = dallocate(length, MEMORY_TAG_STRING);
-            strcpy(*line_buf, buffer);
+            *line_buf = dallocate(length + 1, MEMORY_TAG_STRING);
+            dcopy_memory(*line_buf, buffer, length + 1);
             return true;
         }
     }
     return false;
 }
 
+b8 filesystem_line_reader_create(file_handle* handle, u64 chunk_size, file_line_reader* out_reader)
+{
+    dzero_memory(out_reader, sizeof(file_line_reader));
+    if(!handle->handle)
+    {
+        return false;
+    }
+    out_reader->file = handle;
+    out_reader->capacity = chunk_size ? chunk_size : 64 * 1024;
+    out_reader->buffer = dallocate(out_reader->capacity + 1, MEMORY_TAG_STRING);
+    return true;
+}
+
+void filesystem_line_reader_destroy(file_line_reader* reader)
+{
+    if(reader->buffer)
+    {
+        dfree(reader->buffer, reader->capacity + 1, MEMORY_TAG_STRING);
+    }
+    dzero_memory(reader, sizeof(file_line_reader));
+}
+
+b8 filesystem_line_reader_next(file_line_reader* reader, file_line* out_line)
+{
+    if(!reader->buffer)
+    {
+        return false;
+    }
+
+    // Resume the newline search where the last one left off, so a long line isn't rescanned
+    // every time more of it is read.
+    u64 scanned = reader->start;
+    char* newline = 0;
+    for(;;)
+    {
+        // memchr is vectorized by the C runtime, so this scans many bytes per instruction.
+        newline = memchr(reader->buffer + scanned, '\n', reader->end - scanned);
+        if(newline || reader->end_of_file)
+        {
+            break;
+        }
+
+        // The rest of the chunk is a partial line. Move it to the front and read more after it.
+        u64 remaining = reader->end - reader->start;
+        if(reader->start > 0)
+        {
+            memmove(reader->buffer, reader->buffer + reader->start, remaining);
+            reader->start = 0;
+            reader->end = remaining;
+        }
+        else if(remaining == reader->capacity)
+        {
+            // A line longer than the buffer.
+            u64 capacity = reader->capacity * 2;
+            char* buffer = dallocate(capacity + 1, MEMORY_TAG_STRING);
+            dcopy_memory(buffer, reader->buffer, remaining);
+            dfree(reader->buffer, reader->capacity + 1, MEMORY_TAG_STRING);
+            reader->buffer = buffer;
+            reader->capacity = capacity;
+        }
+        scanned = reader->end;
+
+        u64 read = fread(reader->buffer + reader->end, 1, reader->capacity - reader->end, (FILE*)reader->file->handle);
+        reader->end += read;
+        if(read == 0)
+        {
+            reader->end_of_file = true;
+        }
+    }
+
+    char* line = reader->buffer + reader->start;
+    u64 length;
+    if(newline)
+    {
+        length = (u64)(newline - line);
+        reader->start += length + 1;
+    }
+    else if(reader->start < reader->end)
+    {
+        // The last line has no newline.
+        length = reader->end - reader->start;
+        reader->start = reader->end;
+    }
+    else
+    {
+        return false;
+    }
+
+    if(length > 0 && line[length - 1] == '\r')
+    {
+        length--;
+    }
+    // Either the newline or the spare byte past the end of the buffer.
+    line[length] = 0;
+    out_line->data = line;
+    out_line->length = length;
+    return true;
+}
+
 b8 filesystem_write_line(file_handle* handle, const char* text)
 {
+    if(handle->write_buffer)
+    {
+        u64 written = 0;
+        return filesystem_write(handle, strlen(text), text, &written) && filesystem_write(handle, 1, "\n", &written);
+    }
+
     if(handle->handle)
     {
         i32 result = fputs(text, (FILE*)handle->handle);
@@ -134,6 +462,32 @@ b8 filesystem_read_all_bytes(file_handle* handle, u8** out_bytes, u64* out_bytes
 
 b8 filesystem_write(file_handle* handle, u64 data_size, const void* data, u64* out_bytes_written)
 {
+    if(handle->handle && handle->write_buffer)
+    {
+        file_write_buffer* buffer = handle->write_buffer;
+        b8 result = true;
+        if(buffer->used + data_size > buffer->size)
+        {
+            result = write_buffer_drain(handle, (buffer->flush_policy & FILE_FLUSH_ON_SIZE) != 0);
+        }
+
+        if(data_size >= buffer->size)
+        {
+            // Too big to be worth buffering.
+            *out_bytes_written = fwrite(data, 1, data_size, (FILE*)handle->handle);
+            result = result && *out_bytes_written == data_size;
+        }
+        else
+        {
+            dcopy_memory(buffer->data + buffer->used, data, data_size);
+            buffer->used += data_size;
+            *out_bytes_written = data_size;
+        }
+
+        filesystem_flush_on(handle, FILE_FLUSH_ON_INTERVAL);
+        return result;
+    }
+
     if (handle->handle) 
     {
         *out_bytes_written = fwrite(data, 1, data_size, (FILE*)handle->handle);
@@ -146,3 +500,175 @@ b8 filesystem_write(file_handle* handle, u64 data_size, const void* data, u64* o
     }
     return false;
 }
+
+b8 filesystem_enable_write_buffer(file_handle* handle, const file_write_buffer_config* config)
+{
+    if(!handle->handle || handle->write_buffer || config->buffer_size == 0)
+    {
+        return false;
+    }
+
+    file_write_buffer* buffer = dallocate(sizeof(file_write_buffer), MEMORY_TAG_FILE);
+    buffer->data = dallocate(config->buffer_size, MEMORY_TAG_FILE);
+    buffer->size = config->buffer_size;
+    buffer->used = 0;
+    buffer->flush_policy = config->flush_policy;
+    buffer->flush_interval = config->flush_interval;
+    buffer->last_flush_time = platform_get_absolute_time();
+    handle->write_buffer = buffer;
+
+    if(config->flush_policy & FILE_FLUSH_ON_CRASH)
+    {
+        crash_flush_register(handle);
+    }
+    return true;
+}
+
+b8 filesystem_flush(file_handle* handle)
+{
+    if(!handle->handle)
+    {
+        return false;
+    }
+    if(handle->write_buffer)
+    {
+        return write_buffer_drain(handle, true);
+    }
+    return fflush((FILE*)handle->handle) == 0;
+}
+
+void filesystem_flush_on(file_handle* handle, file_flush_policy reason)
+{
+    file_write_buffer* buffer = handle->write_buffer;
+    if(!handle->handle || !buffer || (buffer->flush_policy & reason) == 0)
+    {
+        return;
+    }
+
+    if(reason == FILE_FLUSH_ON_INTERVAL && platform_get_absolute_time() - buffer->last_flush_time < buffer->flush_interval)
+    {
+        return;
+    }
+
+    write_buffer_drain(handle, true);
+}
+
+b8 filesystem_map(const char* path, file_access_pattern pattern, file_mapping* out_mapping)
+{
+    out_mapping->data = 0;
+    out_mapping->size = 0;
+
+#if DPLATFORM_WINDOWS
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+    if(pattern == FILE_ACCESS_SEQUENTIAL)
+    {
+        flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+    }
+    else if(pattern == FILE_ACCESS_RANDOM)
+    {
+        flags |= FILE_FLAG_RANDOM_ACCESS;
+    }
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, flags, 0);
+    if(file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+        return false;
+    }
+    if(size.QuadPart == 0)
+    {
+        // Empty files can't be mapped.
+        CloseHandle(file);
+        return true;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : 0;
+    // The view keeps the file and mapping objects alive by itself.
+    if(mapping)
+    {
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+    if(!view)
+    {
+        DLOG_ERROR(LOG_CATEGORY_PLATFORM, "Failed to map file '%s': error %u.", path, (u32)GetLastError());
+        return false;
+    }
+
+#if _WIN32_WINNT >= 0x0602
+    if(pattern == FILE_ACCESS_SEQUENTIAL)
+    {
+        // It will all be read; start reading it in now, in large I/Os.
+        WIN32_MEMORY_RANGE_ENTRY range;
+        range.VirtualAddress = view;
+        range.NumberOfBytes = (SIZE_T)size.QuadPart;
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+#endif
+
+    out_mapping->data = view;
+    out_mapping->size = (u64)size.QuadPart;
+    return true;
+#else
+    i32 fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+    {
+        return false;
+    }
+    struct stat buffer;
+    if(fstat(fd, &buffer) != 0)
+    {
+        close(fd);
+        return false;
+    }
+    if(buffer.st_size == 0)
+    {
+        // Empty files can't be mapped.
+        close(fd);
+        return true;
+    }
+
+    void* view = mmap(0, (size_t)buffer.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file open by itself.
+    close(fd);
+    if(view == MAP_FAILED)
+    {
+        DLOG_ERROR(LOG_CATEGORY_PLATFORM, "Failed to map file '%s': error %i.", path, errno);
+        return false;
+    }
+
+    if(pattern == FILE_ACCESS_SEQUENTIAL)
+    {
+        // It will all be read; start reading it in now, and read ahead aggressively.
+        madvise(view, (size_t)buffer.st_size, MADV_SEQUENTIAL);
+        madvise(view, (size_t)buffer.st_size, MADV_WILLNEED);
+    }
+    else if(pattern == FILE_ACCESS_RANDOM)
+    {
+        madvise(view, (size_t)buffer.st_size, MADV_RANDOM);
+    }
+
+    out_mapping->data = view;
+    out_mapping->size = (u64)buffer.st_size;
+    return true;
+#endif
+}
+
+void filesystem_unmap(file_mapping* mapping)
+{
+    if(mapping->data)
+    {
+#if DPLATFORM_WINDOWS
+        UnmapViewOfFile(mapping->data);
+#else
+        munmap((void*)mapping->data, (size_t)mapping->size);
+#endif
+    }
+    mapping->data = 0;
+    mapping->size = 0;
+}
\ No newline at end of file
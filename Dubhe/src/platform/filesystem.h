@@ -6,6 +6,8 @@ typedef struct file_handle
 {
     // Opaque handle to internal file handle
     void* handle;
+    // Internal write buffer. 0 unless enabled via filesystem_enable_write_buffer.
+    void* write_buffer;
     b8 is_valid;
 } file_handle;
 
@@ -15,6 +17,68 @@ typedef enum file_modes
     FILE_MODE_WRITE = 0x02
 } file_modes;
 
+typedef enum file_flush_policy
+{
+    // Flush to the OS whenever the write buffer fills. Otherwise a full buffer is only
+    // handed to the C runtime stream, which flushes at its own discretion.
+    FILE_FLUSH_ON_SIZE = 0x01,
+    // Flush when flush_interval seconds have passed since the last flush.
+    FILE_FLUSH_ON_INTERVAL = 0x02,
+    // Flush when filesystem_flush_on is called with FILE_FLUSH_ON_ERROR, i.e. after error-level messages.
+    FILE_FLUSH_ON_ERROR = 0x04,
+    // Flush from a handler for fatal signals (SIGSEGV, SIGABRT, SIGFPE, SIGILL) before the process dies.
+    FILE_FLUSH_ON_CRASH = 0x08
+} file_flush_policy;
+
+typedef enum file_access_pattern
+{
+    // No hint; the OS reads ahead a little.
+    FILE_ACCESS_NORMAL,
+    // Read front to back, about once: read ahead aggressively and drop pages behind.
+    FILE_ACCESS_SEQUENTIAL,
+    // Read in no particular order: don't read ahead.
+    FILE_ACCESS_RANDOM
+} file_access_pattern;
+
+typedef struct file_mapping
+{
+    // Start of the read-only view of the file; 0 if the file is empty.
+    const void* data;
+    // Size of the file in bytes.
+    u64 size;
+} file_mapping;
+
+typedef struct file_line
+{
+    // Start of the line, without its '\n' or "\r\n". Null-terminated.
+    const char* data;
+    // Length of the line in bytes, not counting the terminator.
+    u64 length;
+} file_line;
+
+typedef struct file_line_reader
+{
+    file_handle* file;
+    char* buffer;
+    // Size of buffer, less one byte kept for a terminator.
+    u64 capacity;
+    // Offset of the first byte not yet handed out as part of a line.
+    u64 start;
+    // Offset one past the last byte read from the file.
+    u64 end;
+    b8 end_of_file;
+} file_line_reader;
+
+typedef struct file_write_buffer_config
+{
+    // Size of the write buffer in bytes.
+    u64 buffer_size;
+    // A combination of file_flush_policy flags.
+    u32 flush_policy;
+    // Used with FILE_FLUSH_ON_INTERVAL, in seconds.
+    f64 flush_interval;
+} file_write_buffer_config;
+
 /**
  * @brief check the file with given path exists.
  * 
@@ -23,6 +87,42 @@ typedef enum file_modes
  */
 DAPI b8 filesystem_exists(const char* path);
 
+/**
+ * @brief Deletes the file with the given path.
+ * 
+ * @param path The path of the file to be deleted.
+ * @return True if successful; otherwise false.
+ */
+DAPI b8 filesystem_delete(const char* path);
+
+/**
+ * @brief Renames (moves) a file. Any existing file at new_path is replaced.
+ * 
+ * @param old_path The current path of the file.
+ * @param new_path The new path of the file.
+ * @return True if successful; otherwise false.
+ */
+DAPI b8 filesystem_rename(const char* old_path, const char* new_path);
+
+/**
+ * @brief Copies a file. Any existing file at dest_path is replaced.
+ * 
+ * @param source_path The path of the file to copy.
+ * @param dest_path The path of the copy.
+ * @return True if successful; otherwise false.
+ */
+DAPI b8 filesystem_copy(const char* source_path, const char* dest_path);
+
+/**
+ * @brief Gets the time the file was last written, for detecting changes. Only comparisons
+ * between values for the same file are meaningful.
+ * 
+ * @param path The path of the file.
+ * @param out_time A pointer to hold the time.
+ * @return True if successful; false if the file does not exist.
+ */
+DAPI b8 filesystem_last_write_time(const char* path, u64* out_time);
+
 /**
  * @brief Attempt to open file located at path.
  * 
@@ -43,6 +143,7 @@ DAPI void filesystem_close(file_handle* handle);
 
 /**
  * @brief Reads up to a newline or EOF. Allocates *line_buf, which must be freed by the caller.
+ * Allocates a string per line; to read many lines, use a file_line_reader instead.
  * 
  * @param handle A pointer to a file_handle structure.
  * @param line_buf A pointer to a character array which will be allocated and populated by this method.
@@ -50,6 +151,34 @@ DAPI void filesystem_close(file_handle* handle);
  */
 DAPI b8 filesystem_read_line(file_handle* handle, char** line_buf);
 
+/**
+ * @brief Prepares to read the lines of a file in large chunks, without an allocation per line.
+ * The reader takes over reading from the file until it is destroyed.
+ * 
+ * @param handle A pointer to a file_handle structure opened for reading.
+ * @param chunk_size The number of bytes to read at a time; 0 for 64KB. Grows to fit longer lines.
+ * @param out_reader A pointer to the reader to be initialized.
+ * @return True if successful; otherwise false.
+ */
+DAPI b8 filesystem_line_reader_create(file_handle* handle, u64 chunk_size, file_line_reader* out_reader);
+
+/**
+ * @brief Frees the reader's buffer. The file is left open.
+ * 
+ * @param reader A pointer to the reader.
+ */
+DAPI void filesystem_line_reader_destroy(file_line_reader* reader);
+
+/**
+ * @brief Gets the next line. out_line views the reader's buffer, so it is only valid until the
+ * next call or until the reader is destroyed; copy it to keep it.
+ * 
+ * @param reader A pointer to the reader.
+ * @param out_line A pointer to hold the line.
+ * @return True if a line was read; false at the end of the file or on error.
+ */
+DAPI b8 filesystem_line_reader_next(file_line_reader* reader, file_line* out_line);
+
 /**
  * @brief Writes text to the provided file, appending a '\n' afterward.
  * 
@@ -89,4 +218,52 @@ DAPI b8 filesystem_read_all_bytes(file_handle* handle, u8** out_bytes, u64* out_
  * @param out_bytes_written A pointer to a number which will be populated with the number of bytes actually written to the file.
  * @return True if successful; otherwise false. 
  */
-DAPI b8 filesystem_write(file_handle* handle, u64 data_size, const void* data, u64* out_bytes_written);
\ No newline at end of file
+DAPI b8 filesystem_write(file_handle* handle, u64 data_size, const void* data, u64* out_bytes_written);
+
+/**
+ * @brief Buffers writes to the provided file in memory instead of flushing after every write.
+ * The buffer is flushed according to config->flush_policy, by filesystem_flush and on close.
+ * With FILE_FLUSH_ON_CRASH the handle must stay at the same address until it is closed.
+ * Like the handle itself, the buffer is not thread-safe; threads sharing it must serialize writes.
+ * 
+ * @param handle A pointer to a file_handle structure opened for writing.
+ * @param config The buffer size and flush policy.
+ * @return True if successful; otherwise false. 
+ */
+DAPI b8 filesystem_enable_write_buffer(file_handle* handle, const file_write_buffer_config* config);
+
+/**
+ * @brief Writes any buffered data and flushes the file to the OS.
+ * 
+ * @param handle A pointer to a file_handle structure.
+ * @return True if successful; otherwise false. 
+ */
+DAPI b8 filesystem_flush(file_handle* handle);
+
+/**
+ * @brief Flushes the file if its write buffer policy includes the given reason.
+ * For FILE_FLUSH_ON_INTERVAL, only flushes once the interval has elapsed, so this can be called every frame.
+ * 
+ * @param handle A pointer to a file_handle structure.
+ * @param reason The event which occured. FILE_FLUSH_ON_ERROR or FILE_FLUSH_ON_INTERVAL.
+ */
+DAPI void filesystem_flush_on(file_handle* handle, file_flush_policy reason);
+
+/**
+ * @brief Maps a whole file into memory as a read-only view, so it can be used in place
+ * without copying it into a heap buffer. Pages are read from the OS page cache on first access.
+ * The view starts on a page boundary, so its data is suitably aligned for any type.
+ * 
+ * @param path The path of the file.
+ * @param pattern How the view will be read, passed on to the OS as a hint.
+ * @param out_mapping A pointer to hold the view. Zeroed on failure.
+ * @return True if successful; otherwise false.
+ */
+DAPI b8 filesystem_map(const char* path, file_access_pattern pattern, file_mapping* out_mapping);
+
+/**
+ * @brief Releases a view from filesystem_map. Its data must not be used afterwards.
+ * 
+ * @param mapping A pointer to the view. Zeroed afterwards.
+ */
+DAPI void filesystem_unmap(file_mapping* mapping);
\ No newline at end of file
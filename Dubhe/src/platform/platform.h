@@ -3,6 +3,11 @@
 #include "defines.h"
 
 
+/**
+ * Starts the platform layer and, unless headless, creates the application window.
+ * A headless platform has no window and needs no windowing system; it posts a single
+ * EVENT_CODE_RESIZED with width and height, and the renderer draws to offscreen images.
+ */
 b8 platform_system_startup(
     u64* memory_requirement,
     void* new_state,
@@ -11,22 +16,58 @@ b8 platform_system_startup(
     i32 x,
     i32 y,
     i32 width,
-    i32 height);
+    i32 height,
+    b8 headless);
 
 void platform_system_shutdown(void* new_state);
 
 b8 platform_pump_message();
 
+/**
+ * Returns true if the platform was started headless.
+ */
+b8 platform_is_headless();
+
 void* platform_allocate(u64 size, b8 aligned);
 void platform_free(void* block, b8 aligned);
 void* platform_zero_memory(void* block, u64 size);
 void* platform_copy_memory(void* dest, const void* src, u64 size);
+// As platform_copy_memory, but dest and src may overlap.
+void* platform_move_memory(void* dest, const void* src, u64 size);
 void* platform_set_memory(void* dest, i32 value, u64 size);
 
 void platform_console_write(const char* message, u8 color);
 void platform_console_write_error(const char* message, u8 color);
 
-f64 platform_get_absolute_time();
+DAPI f64 platform_get_absolute_time();
+
+/**
+ * A monotonic timestamp for timing short scopes: the calibrated TSC where the CPU has an
+ * invariant one, otherwise the OS high resolution clock. Costs a few nanoseconds, against
+ * tens for platform_get_absolute_time. Only differences between ticks are meaningful.
+ */
+DAPI u64 platform_get_ticks();
+
+/**
+ * @returns The number of ticks per second.
+ */
+DAPI u64 platform_get_tick_frequency();
+
+/**
+ * Converts a tick count, typically the difference of two platform_get_ticks calls, to nanoseconds.
+ */
+DAPI u64 platform_ticks_to_ns(u64 ticks);
+
+/**
+ * Sleeps the calling thread for at least ms milliseconds. The actual resolution depends on
+ * the OS scheduler (about 1ms on both supported platforms), so callers needing a precise
+ * wake-up should sleep short and spin the remainder on platform_get_absolute_time.
+ */
+DAPI void platform_sleep(u64 ms);
 
-// TODO: 
-void platform_sleep(u64 ms);
\ No newline at end of file
+/**
+ * Blocks the calling thread until the OS has input or window messages for the application,
+ * or until timeout_ms elapses. Messages are not handled; call platform_pump_message afterwards.
+ * A headless platform has no messages and just sleeps.
+ */
+void platform_wait_for_events(u64 timeout_ms);
\ No newline at end of file
@@ -0,0 +1,794 @@
+#include "platform/platform.h"
+
+// Linux platform layer.
+#if DPLATFORM_LINUX
+
+#include <core/logger.h>
+#include "core/input.h"
+#include "core/event.h"
+
+#include "containers/darray.h"
+
+#include <xcb/xcb.h>
+#include <X11/keysym.h>
+#include <X11/XKBlib.h>     // sudo apt-get install libx11-dev
+#include <X11/Xlib.h>
+#include <X11/Xlib-xcb.h>   // sudo apt-get install libx11-xcb-dev
+#include <time.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// For surface creation
+#define VK_USE_PLATFORM_XCB_KHR
+#include <vulkan/vulkan.h>
+#include "renderer/vulkan/vulkan_types.inl"
+#include "platform/tsc.inl"
+
+// How long the TSC is counted against CLOCK_MONOTONIC_RAW to find its frequency.
+#define TICKS_CALIBRATION_NS (5 * 1000 * 1000)
+
+typedef struct platform_state
+{
+    Display* display;               // Xlib display, only used for keysym translation
+    xcb_connection_t* connection;   // XCB connection owned by the display
+    xcb_window_t window;
+    xcb_screen_t* screen;
+    xcb_atom_t wm_protocols;
+    xcb_atom_t wm_delete_win;
+    VkSurfaceKHR surface;
+    b8 headless;
+}platform_state;
+
+static platform_state* state_ptr;
+
+// Ticks. Outside platform_state so that they work before startup, like the clock.
+typedef struct tick_source
+{
+    b8 use_tsc;
+    u64 frequency;
+    f64 ns_per_tick;
+    // Set last. Threads racing the first call just calibrate twice.
+    b8 initialized;
+} tick_source;
+
+static tick_source ticks;
+
+// Key translation
+static key_code translate_keycode(u32 x_keycode);
+
+static void ticks_setup();
+
+b8 platform_system_startup(
+    u64* memory_requirement,
+    void* new_state,
+    const char* application_name,
+    i32 x,
+    i32 y,
+    i32 width,
+    i32 height,
+    b8 headless)
+{
+    *memory_requirement = sizeof(platform_state);
+    if (new_state == 0) {
+        return true;
+    }
+    state_ptr = new_state;
+    memset(state_ptr, 0, sizeof(platform_state));
+    state_ptr->headless = headless;
+    ticks_setup();
+
+    if(headless)
+    {
+        // No display connection at all: report the configured size, as ConfigureNotify would.
+        event_context data = {};
+        data.data.u16[0] = (u16)width;
+        data.data.u16[1] = (u16)height;
+        event_post(EVENT_CODE_RESIZED, 0, data);
+        return true;
+    }
+
+    // Connect to X
+    state_ptr->display = XOpenDisplay(NULL);
+    if(!state_ptr->display)
+    {
+        DFATAL("Failed to open X display. Is DISPLAY set?");
+        return false;
+    }
+
+    // Key repeats only send presses, instead of release/press pairs.
+    XkbSetDetectableAutoRepeat(state_ptr->display, True, NULL);
+
+    // Retrieve the connection from the display.
+    state_ptr->connection = XGetXCBConnection(state_ptr->display);
+    if(xcb_connection_has_error(state_ptr->connection))
+    {
+        DFATAL("Failed to connect to X server via XCB.");
+        return false;
+    }
+
+    // Use the default screen.
+    const struct xcb_setup_t* setup = xcb_get_setup(state_ptr->connection);
+    xcb_screen_iterator_t it = xcb_setup_roots_iterator(setup);
+    i32 screen_p = XDefaultScreen(state_ptr->display);
+    for(i32 s = screen_p; s > 0; s--)
+    {
+        xcb_screen_next(&it);
+    }
+    state_ptr->screen = it.data;
+
+    // Create window
+    state_ptr->window = xcb_generate_id(state_ptr->connection);
+
+    // Register event types.
+    // XCB_CW_BACK_PIXEL = filling then window bg with a single colour
+    // XCB_CW_EVENT_MASK is required.
+    u32 event_mask = XCB_CW_BACK_PIXEL | XCB_CW_EVENT_MASK;
+
+    // Listen for keyboard and mouse buttons, motion, exposure and resizes.
+    u32 event_values = XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE |
+                       XCB_EVENT_MASK_KEY_PRESS | XCB_EVENT_MASK_KEY_RELEASE |
+                       XCB_EVENT_MASK_EXPOSURE | XCB_EVENT_MASK_POINTER_MOTION |
+                       XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+
+    // Values to be sent over XCB (bg colour, events)
+    u32 value_list[] = {state_ptr->screen->black_pixel, event_values};
+
+    xcb_create_window(
+        state_ptr->connection,
+        XCB_COPY_FROM_PARENT,   // depth
+        state_ptr->window,
+        state_ptr->screen->root,    // parent
+        x,
+        y,
+        width,
+        height,
+        0,                              // No border
+        XCB_WINDOW_CLASS_INPUT_OUTPUT,  // class
+        state_ptr->screen->root_visual,
+        event_mask,
+        value_list);
+
+    // Change the title
+    xcb_change_property(
+        state_ptr->connection,
+        XCB_PROP_MODE_REPLACE,
+        state_ptr->window,
+        XCB_ATOM_WM_NAME,
+        XCB_ATOM_STRING,
+        8,  // data should be viewed 8 bits at a time
+        strlen(application_name),
+        application_name);
+
+    // Tell the server to notify when the window manager attempts to destroy the window.
+    xcb_intern_atom_cookie_t wm_delete_cookie = xcb_intern_atom(
+        state_ptr->connection,
+        0,
+        strlen("WM_DELETE_WINDOW"),
+        "WM_DELETE_WINDOW");
+    xcb_intern_atom_cookie_t wm_protocols_cookie = xcb_intern_atom(
+        state_ptr->connection,
+        0,
+        strlen("WM_PROTOCOLS"),
+        "WM_PROTOCOLS");
+    xcb_intern_atom_reply_t* wm_delete_reply = xcb_intern_atom_reply(
+        state_ptr->connection,
+        wm_delete_cookie,
+        NULL);
+    xcb_intern_atom_reply_t* wm_protocols_reply = xcb_intern_atom_reply(
+        state_ptr->connection,
+        wm_protocols_cookie,
+        NULL);
+    state_ptr->wm_delete_win = wm_delete_reply->atom;
+    state_ptr->wm_protocols = wm_protocols_reply->atom;
+    free(wm_delete_reply);
+    free(wm_protocols_reply);
+
+    xcb_change_property(
+        state_ptr->connection,
+        XCB_PROP_MODE_REPLACE,
+        state_ptr->window,
+        state_ptr->wm_protocols,
+        XCB_ATOM_ATOM,
+        32,
+        1,
+        &state_ptr->wm_delete_win);
+
+    // Map the window to the screen
+    xcb_map_window(state_ptr->connection, state_ptr->window);
+
+    // Flush the stream
+    i32 stream_result = xcb_flush(state_ptr->connection);
+    if (stream_result <= 0) {
+        DFATAL("An error occurred when flusing the stream: %d", stream_result);
+        return false;
+    }
+
+    return true;
+}
+
+void platform_system_shutdown(void* new_state)
+{
+    if (state_ptr && state_ptr->display) {
+        xcb_destroy_window(state_ptr->connection, state_ptr->window);
+        // Also disconnects the XCB connection.
+        XCloseDisplay(state_ptr->display);
+        state_ptr->display = 0;
+        state_ptr->connection = 0;
+        state_ptr->window = 0;
+    }
+}
+
+b8 platform_is_headless()
+{
+    return state_ptr && state_ptr->headless;
+}
+
+b8 platform_pump_message()
+{
+    if (state_ptr && !state_ptr->headless)
+    {
+        xcb_generic_event_t* event;
+        xcb_client_message_event_t* cm;
+
+        // Poll for events until null is returned.
+        while ((event = xcb_poll_for_event(state_ptr->connection)))
+        {
+            // Input events
+            switch (event->response_type & ~0x80)
+            {
+                case XCB_KEY_PRESS:
+                case XCB_KEY_RELEASE:
+                {
+                    // Key press event - xcb_key_press_event_t and xcb_key_release_event_t are the same
+                    xcb_key_press_event_t* kb_event = (xcb_key_press_event_t*)event;
+                    b8 pressed = (event->response_type & ~0x80) == XCB_KEY_PRESS;
+                    xcb_keycode_t code = kb_event->detail;
+                    // Group 0, level 0: the unshifted keysym, so keys map the same regardless of modifiers.
+                    KeySym key_sym = XkbKeycodeToKeysym(state_ptr->display, (KeyCode)code, 0, 0);
+
+                    key_code key = translate_keycode(key_sym);
+
+                    // Pass to the input subsystem for processing.
+                    input_process_key(key, pressed);
+                    break;
+                }
+                case XCB_BUTTON_PRESS:
+                case XCB_BUTTON_RELEASE:
+                {
+                    xcb_button_press_event_t* mouse_event = (xcb_button_press_event_t*)event;
+                    b8 pressed = (event->response_type & ~0x80) == XCB_BUTTON_PRESS;
+                    mouse_button button = MOUSEBUTTONS_COUNT;
+                    switch (mouse_event->detail)
+                    {
+                        case XCB_BUTTON_INDEX_1:
+                            button = MOUSEBUTTON_LEFT;
+                            break;
+                        case XCB_BUTTON_INDEX_2:
+                            button = MOUSEBUTTON_MIDDLE;
+                            break;
+                        case XCB_BUTTON_INDEX_3:
+                            button = MOUSEBUTTON_RIGHT;
+                            break;
+                        case XCB_BUTTON_INDEX_4:
+                        case XCB_BUTTON_INDEX_5:
+                            // X reports the wheel as buttons 4 (up) and 5 (down); only presses carry a step.
+                            if(pressed)
+                            {
+                                input_process_mouse_wheel(mouse_event->detail == XCB_BUTTON_INDEX_4 ? 1 : -1);
+                            }
+                            break;
+                    }
+
+                    // Pass over to the input subsystem.
+                    if (button != MOUSEBUTTONS_COUNT)
+                    {
+                        input_process_button(button, pressed);
+                    }
+                    break;
+                }
+                case XCB_MOTION_NOTIFY:
+                {
+                    // Mouse move
+                    xcb_motion_notify_event_t* move_event = (xcb_motion_notify_event_t*)event;
+
+                    // Pass over to the input subsystem.
+                    input_process_mouse_move(move_event->event_x, move_event->event_y);
+                    break;
+                }
+                case XCB_CONFIGURE_NOTIFY:
+                {
+                    // Resizing - note that this is also triggered by moving the window, but should be
+                    // passed anyway since a change in the x/y could mean an upper-left resize.
+                    // The application layer can decide what to do with this.
+                    xcb_configure_notify_event_t* configure_event = (xcb_configure_notify_event_t*)event;
+
+                    event_context data = {};
+                    data.data.u16[0] = configure_event->width;
+                    data.data.u16[1] = configure_event->height;
+                    // Posted: only the latest size of the frame is dispatched.
+                    event_post(EVENT_CODE_RESIZED, 0, data);
+                    break;
+                }
+                case XCB_CLIENT_MESSAGE:
+                {
+                    cm = (xcb_client_message_event_t*)event;
+
+                    // Window close
+                    if (cm->data.data32[0] == state_ptr->wm_delete_win)
+                    {
+                        // Post an event for the application to quit.
+                        event_context data = {};
+                        event_post(EVENT_CODE_APPLICATION_QUIT, 0, data);
+                    }
+                    break;
+                }
+                default:
+                    // Something else
+                    break;
+            }
+
+            free(event);
+        }
+    }
+
+    return true;
+}
+
+void* platform_allocate(u64 size, b8 aligned)
+{
+    // TODO: very temporary
+    return malloc(size);
+}
+
+void platform_free(void* block, b8 aligned)
+{
+    // TODO: very temporary
+    free(block);
+}
+
+void* platform_zero_memory(void* block, u64 size)
+{
+    return memset(block, 0, size);
+}
+
+void* platform_copy_memory(void* dest, const void* src, u64 size)
+{
+    return memcpy(dest, src, size);
+}
+
+void* platform_move_memory(void* dest, const void* src, u64 size)
+{
+    return memmove(dest, src, size);
+}
+
+void* platform_set_memory(void* dest, i32 value, u64 size)
+{
+    return memset(dest, value, size);
+}
+
+void platform_console_write(const char* message, u8 color)
+{
+    // ANSI colour codes.
+    // FATAL, ERROR, WARN, INFO, DEBUG, TRACE
+    const char* colour_strings[] = {"0;41", "1;31", "1;33", "1;32", "1;34", "1;30"};
+    printf("\033[%sm%s\033[0m", colour_strings[color], message);
+}
+
+void platform_console_write_error(const char* message, u8 color)
+{
+    // ANSI colour codes.
+    // FATAL, ERROR, WARN, INFO, DEBUG, TRACE
+    const char* colour_strings[] = {"0;41", "1;31", "1;33", "1;32", "1;34", "1;30"};
+    fprintf(stderr, "\033[%sm%s\033[0m", colour_strings[color], message);
+}
+
+f64 platform_get_absolute_time()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    // time in seconds
+    return now.tv_sec + now.tv_nsec * 0.000000001;
+}
+
+static u64 monotonic_raw_ns()
+{
+    // Unlike CLOCK_MONOTONIC, not slewed by NTP, so it's the better reference for the TSC.
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+    return (u64)now.tv_sec * 1000000000ull + (u64)now.tv_nsec;
+}
+
+static void ticks_setup()
+{
+    if(ticks.initialized)
+    {
+        return;
+    }
+
+    ticks.use_tsc = false;
+    ticks.frequency = 1000000000ull;
+#if DTSC_SUPPORTED
+    if(tsc_is_invariant())
+    {
+        u64 start_ns = monotonic_raw_ns();
+        u64 start_tsc = tsc_read();
+        u64 end_ns;
+        do
+        {
+            end_ns = monotonic_raw_ns();
+        } while(end_ns - start_ns < TICKS_CALIBRATION_NS);
+        u64 end_tsc = tsc_read();
+
+        u64 frequency = (u64)((f64)(end_tsc - start_tsc) * 1e9 / (f64)(end_ns - start_ns));
+        if(frequency > 0)
+        {
+            ticks.use_tsc = true;
+            ticks.frequency = frequency;
+        }
+    }
+#endif
+    ticks.ns_per_tick = 1e9 / (f64)ticks.frequency;
+    ticks.initialized = true;
+}
+
+u64 platform_get_ticks()
+{
+    if(!ticks.initialized)
+    {
+        ticks_setup();
+    }
+#if DTSC_SUPPORTED
+    if(ticks.use_tsc)
+    {
+        return tsc_read();
+    }
+#endif
+    return monotonic_raw_ns();
+}
+
+u64 platform_get_tick_frequency()
+{
+    if(!ticks.initialized)
+    {
+        ticks_setup();
+    }
+    return ticks.frequency;
+}
+
+u64 platform_ticks_to_ns(u64 tick_count)
+{
+    if(!ticks.initialized)
+    {
+        ticks_setup();
+    }
+    return (u64)((f64)tick_count * ticks.ns_per_tick + 0.5);
+}
+
+void platform_sleep(u64 ms)
+{
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (ms % 1000) * 1000 * 1000;
+    // Resume with the remaining time if a signal interrupts the sleep.
+    while(nanosleep(&ts, &ts) == -1 && errno == EINTR)
+    {
+    }
+}
+
+void platform_wait_for_events(u64 timeout_ms)
+{
+    if(!state_ptr || state_ptr->headless)
+    {
+        platform_sleep(timeout_ms);
+        return;
+    }
+
+    // platform_pump_message drained everything XCB had read, so wait on the socket itself.
+    xcb_flush(state_ptr->connection);
+    struct pollfd fd;
+    fd.fd = xcb_get_file_descriptor(state_ptr->connection);
+    fd.events = POLLIN;
+    fd.revents = 0;
+    poll(&fd, 1, (int)timeout_ms);
+}
+
+void platform_get_required_extension_names(const char*** names_darray)
+{
+    darray_push(*names_darray, &"VK_KHR_xcb_surface");
+}
+
+b8 platform_create_vulkan_surface(struct vulkan_context* context)
+{
+    if(!state_ptr)
+    {
+        return false;
+    }
+
+    VkXcbSurfaceCreateInfoKHR create_info = {VK_STRUCTURE_TYPE_XCB_SURFACE_CREATE_INFO_KHR};
+    create_info.connection = state_ptr->connection;
+    create_info.window = state_ptr->window;
+
+    VkResult result = vkCreateXcbSurfaceKHR(context->instance,
+    &create_info,
+    context->allocator,
+    &state_ptr->surface);
+
+    if(result != VK_SUCCESS)
+    {
+        DFATAL("Vulkan surface creation failed.");
+        return false;
+    }
+
+    context->surface = state_ptr->surface;
+    return true;
+}
+
+// Maps X keysyms to key codes. Unmapped keys become 0.
+static key_code translate_keycode(u32 x_keycode)
+{
+    // Digits have no named key code; like on Windows they use their ASCII value.
+    if(x_keycode >= XK_0 && x_keycode <= XK_9)
+    {
+        return (key_code)('0' + (x_keycode - XK_0));
+    }
+
+    switch (x_keycode)
+    {
+        case XK_BackSpace:
+            return KEY_BACKSPACE;
+        case XK_Return:
+            return KEY_ENTER;
+        case XK_Tab:
+            return KEY_TAB;
+        case XK_Pause:
+            return KEY_PAUSE;
+        case XK_Caps_Lock:
+            return KEY_CAPITAL;
+        case XK_Escape:
+            return KEY_ESCAPE;
+        case XK_Mode_switch:
+            return KEY_MODECHANGE;
+        case XK_space:
+            return KEY_SPACE;
+        case XK_Prior:
+            return KEY_PRIOR;
+        case XK_Next:
+            return KEY_NEXT;
+        case XK_End:
+            return KEY_END;
+        case XK_Home:
+            return KEY_HOME;
+        case XK_Left:
+            return KEY_LEFT;
+        case XK_Up:
+            return KEY_UP;
+        case XK_Right:
+            return KEY_RIGHT;
+        case XK_Down:
+            return KEY_DOWN;
+        case XK_Select:
+            return KEY_SELECT;
+        case XK_Print:
+            return KEY_PRINT;
+        case XK_Execute:
+            return KEY_EXECUTE;
+        case XK_Insert:
+            return KEY_INSERT;
+        case XK_Delete:
+            return KEY_DELETE;
+        case XK_Help:
+            return KEY_HELP;
+
+        case XK_Super_L:
+            return KEY_LWIN;
+        case XK_Super_R:
+            return KEY_RWIN;
+        case XK_Menu:
+            return KEY_APPS;
+
+        case XK_KP_0:
+            return KEY_NUMPAD0;
+        case XK_KP_1:
+            return KEY_NUMPAD1;
+        case XK_KP_2:
+            return KEY_NUMPAD2;
+        case XK_KP_3:
+            return KEY_NUMPAD3;
+        case XK_KP_4:
+            return KEY_NUMPAD4;
+        case XK_KP_5:
+            return KEY_NUMPAD5;
+        case XK_KP_6:
+            return KEY_NUMPAD6;
+        case XK_KP_7:
+            return KEY_NUMPAD7;
+        case XK_KP_8:
+            return KEY_NUMPAD8;
+        case XK_KP_9:
+            return KEY_NUMPAD9;
+        case XK_KP_Multiply:
+            return KEY_MULTIPLY;
+        case XK_KP_Add:
+            return KEY_ADD;
+        case XK_KP_Separator:
+            return KEY_SEPARATOR;
+        case XK_KP_Subtract:
+            return KEY_SUBTRACT;
+        case XK_KP_Decimal:
+            return KEY_DECIMAL;
+        case XK_KP_Divide:
+            return KEY_DIVIDE;
+        case XK_KP_Equal:
+            return KEY_NUMPAD_EQUAL;
+
+        case XK_F1:
+            return KEY_F1;
+        case XK_F2:
+            return KEY_F2;
+        case XK_F3:
+            return KEY_F3;
+        case XK_F4:
+            return KEY_F4;
+        case XK_F5:
+            return KEY_F5;
+        case XK_F6:
+            return KEY_F6;
+        case XK_F7:
+            return KEY_F7;
+        case XK_F8:
+            return KEY_F8;
+        case XK_F9:
+            return KEY_F9;
+        case XK_F10:
+            return KEY_F10;
+        case XK_F11:
+            return KEY_F11;
+        case XK_F12:
+            return KEY_F12;
+        case XK_F13:
+            return KEY_F13;
+        case XK_F14:
+            return KEY_F14;
+        case XK_F15:
+            return KEY_F15;
+        case XK_F16:
+            return KEY_F16;
+        case XK_F17:
+            return KEY_F17;
+        case XK_F18:
+            return KEY_F18;
+        case XK_F19:
+            return KEY_F19;
+        case XK_F20:
+            return KEY_F20;
+        case XK_F21:
+            return KEY_F21;
+        case XK_F22:
+            return KEY_F22;
+        case XK_F23:
+            return KEY_F23;
+        case XK_F24:
+            return KEY_F24;
+
+        case XK_Num_Lock:
+            return KEY_NUMLOCK;
+        case XK_Scroll_Lock:
+            return KEY_SCROLL;
+
+        case XK_Shift_L:
+            return KEY_LSHIFT;
+        case XK_Shift_R:
+            return KEY_RSHIFT;
+        case XK_Control_L:
+            return KEY_LCONTROL;
+        case XK_Control_R:
+            return KEY_RCONTROL;
+        case XK_Alt_L:
+            return KEY_LALT;
+        case XK_Alt_R:
+            return KEY_RALT;
+
+        case XK_semicolon:
+            return KEY_SEMICOLON;
+        case XK_plus:
+        case XK_equal:
+            return KEY_PLUS;
+        case XK_comma:
+            return KEY_COMMA;
+        case XK_minus:
+            return KEY_MINUS;
+        case XK_period:
+            return KEY_PERIOD;
+        case XK_slash:
+            return KEY_SLASH;
+        case XK_grave:
+            return KEY_GRAVE;
+
+        case XK_a:
+        case XK_A:
+            return KEY_A;
+        case XK_b:
+        case XK_B:
+            return KEY_B;
+        case XK_c:
+        case XK_C:
+            return KEY_C;
+        case XK_d:
+        case XK_D:
+            return KEY_D;
+        case XK_e:
+        case XK_E:
+            return KEY_E;
+        case XK_f:
+        case XK_F:
+            return KEY_F;
+        case XK_g:
+        case XK_G:
+            return KEY_G;
+        case XK_h:
+        case XK_H:
+            return KEY_H;
+        case XK_i:
+        case XK_I:
+            return KEY_I;
+        case XK_j:
+        case XK_J:
+            return KEY_J;
+        case XK_k:
+        case XK_K:
+            return KEY_K;
+        case XK_l:
+        case XK_L:
+            return KEY_L;
+        case XK_m:
+        case XK_M:
+            return KEY_M;
+        case XK_n:
+        case XK_N:
+            return KEY_N;
+        case XK_o:
+        case XK_O:
+            return KEY_O;
+        case XK_p:
+        case XK_P:
+            return KEY_P;
+        case XK_q:
+        case XK_Q:
+            return KEY_Q;
+        case XK_r:
+        case XK_R:
+            return KEY_R;
+        case XK_s:
+        case XK_S:
+            return KEY_S;
+        case XK_t:
+        case XK_T:
+            return KEY_T;
+        case XK_u:
+        case XK_U:
+            return KEY_U;
+        case XK_v:
+        case XK_V:
+            return KEY_V;
+        case XK_w:
+        case XK_W:
+            return KEY_W;
+        case XK_x:
+        case XK_X:
+            return KEY_X;
+        case XK_y:
+        case XK_Y:
+            return KEY_Y;
+        case XK_z:
+        case XK_Z:
+            return KEY_Z;
+
+        default:
+            return 0;
+    }
+}
+
+#endif  // DPLATFORM_LINUX
\ No newline at end of file
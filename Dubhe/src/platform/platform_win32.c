@@ -17,6 +17,10 @@
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan_win32.h>
 #include "renderer/vulkan/vulkan_types.inl"
+#include "platform/tsc.inl"
+
+// How long the TSC is counted against the performance counter to find its frequency, in seconds.
+#define TICKS_CALIBRATION_SECONDS 0.005
 
 typedef struct platform_state
 {
@@ -25,16 +29,32 @@ typedef struct platform_state
     VkSurfaceKHR surface;
     f64 clock_frequency;
     LARGE_INTEGER start_time;
+    b8 headless;
+    b8 timer_period_set;
 }platform_state;
 
 // Clock
 static f64 clock_frequency;
 static LARGE_INTEGER start_time;
 
+// Ticks. Outside platform_state so that they work before startup, like the clock.
+typedef struct tick_source
+{
+    b8 use_tsc;
+    u64 frequency;
+    f64 ns_per_tick;
+    // Set last. Threads racing the first call just calibrate twice.
+    b8 initialized;
+} tick_source;
+
+static tick_source ticks;
+
 static platform_state* state_ptr;
 
 LRESULT CALLBACK win32_process_message(HWND hwnd, u32 msg, WPARAM w_param, LPARAM l_param);
 
+static void ticks_setup();
+
 void clock_setup() 
 {
     LARGE_INTEGER frequency;
@@ -50,7 +70,8 @@ b8 platform_system_startup(
     i32 x,
     i32 y,
     i32 width,
-    i32 height)
+    i32 height,
+    b8 headless)
 {
     //new state
     *memory_requirement = sizeof(platform_state);
@@ -58,7 +79,32 @@ b8 platform_system_startup(
         return true;
     }
     state_ptr = new_state;
+    memset(state_ptr, 0, sizeof(platform_state));
     state_ptr->h_instance = GetModuleHandleA(0);
+    state_ptr->headless = headless;
+
+    // Clock setup
+    // get clock frequency and setup the starttime
+    // new state
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    state_ptr->clock_frequency = 1.0 / (f64)frequency.QuadPart;
+    QueryPerformanceCounter(&state_ptr->start_time);
+    clock_setup();
+    ticks_setup();
+
+    // Raise the scheduler resolution so Sleep(1) sleeps ~1ms instead of a 15.6ms tick.
+    state_ptr->timer_period_set = timeBeginPeriod(1) == TIMERR_NOERROR;
+
+    if(headless)
+    {
+        // No window: report the configured size, as WM_SIZE would.
+        event_context data = {};
+        data.data.u16[0] = (u16)width;
+        data.data.u16[1] = (u16)height;
+        event_post(EVENT_CODE_RESIZED, 0, data);
+        return true;
+    }
 
     // Setup and register window class
     HICON icon = LoadIcon(state_ptr->h_instance, IDI_APPLICATION);
@@ -141,15 +187,6 @@ b8 platform_system_startup(
     i32 show_window_command_flags = should_activate ? SW_SHOW/* SW_MINMIZE/SW_SHOWMAXIMIZED */ : SW_SHOWNOACTIVATE; 
     ShowWindow(state_ptr->hwnd, show_window_command_flags);
 
-    // Clock setup
-    // get clock frequency and setup the starttime
-    // new state
-    LARGE_INTEGER frequency;
-    QueryPerformanceFrequency(&frequency);
-    state_ptr->clock_frequency = 1.0 / (f64)frequency.QuadPart;
-    QueryPerformanceCounter(&state_ptr->start_time);
-    clock_setup();
-
     return true;
 }
 
@@ -160,6 +197,15 @@ void platform_system_shutdown(void* new_state)
         DestroyWindow(state_ptr->hwnd);
         state_ptr->hwnd = 0;
     }
+    if (state_ptr && state_ptr->timer_period_set) {
+        timeEndPeriod(1);
+        state_ptr->timer_period_set = false;
+    }
+}
+
+b8 platform_is_headless()
+{
+    return state_ptr && state_ptr->headless;
 }
 
 b8 platform_pump_message()
@@ -199,6 +245,11 @@ void* platform_copy_memory(void* dest, const void* src, u64 size)
     return memcpy(dest, src, size);
 }
 
+void* platform_move_memory(void* dest, const void* src, u64 size)
+{
+    return memmove(dest, src, size);
+}
+
 void* platform_set_memory(void* dest, i32 value, u64 size)
 {
     return memset(dest, value, size);
@@ -251,11 +302,95 @@ f64 platform_get_absolute_time()
     }
 }
 
+static void ticks_setup()
+{
+    if(ticks.initialized)
+    {
+        return;
+    }
+
+    LARGE_INTEGER qpc_frequency;
+    QueryPerformanceFrequency(&qpc_frequency);
+    ticks.use_tsc = false;
+    ticks.frequency = (u64)qpc_frequency.QuadPart;
+#if DTSC_SUPPORTED
+    if(tsc_is_invariant())
+    {
+        u64 calibration_counts = (u64)((f64)qpc_frequency.QuadPart * TICKS_CALIBRATION_SECONDS);
+        LARGE_INTEGER start_qpc, end_qpc;
+        QueryPerformanceCounter(&start_qpc);
+        u64 start_tsc = tsc_read();
+        do
+        {
+            QueryPerformanceCounter(&end_qpc);
+        } while((u64)(end_qpc.QuadPart - start_qpc.QuadPart) < calibration_counts);
+        u64 end_tsc = tsc_read();
+
+        f64 seconds = (f64)(end_qpc.QuadPart - start_qpc.QuadPart) / (f64)qpc_frequency.QuadPart;
+        u64 frequency = (u64)((f64)(end_tsc - start_tsc) / seconds);
+        if(frequency > 0)
+        {
+            ticks.use_tsc = true;
+            ticks.frequency = frequency;
+        }
+    }
+#endif
+    ticks.ns_per_tick = 1e9 / (f64)ticks.frequency;
+    ticks.initialized = true;
+}
+
+u64 platform_get_ticks()
+{
+    if(!ticks.initialized)
+    {
+        ticks_setup();
+    }
+#if DTSC_SUPPORTED
+    if(ticks.use_tsc)
+    {
+        return tsc_read();
+    }
+#endif
+    LARGE_INTEGER now_time;
+    QueryPerformanceCounter(&now_time);
+    return (u64)now_time.QuadPart;
+}
+
+u64 platform_get_tick_frequency()
+{
+    if(!ticks.initialized)
+    {
+        ticks_setup();
+    }
+    return ticks.frequency;
+}
+
+u64 platform_ticks_to_ns(u64 tick_count)
+{
+    if(!ticks.initialized)
+    {
+        ticks_setup();
+    }
+    return (u64)((f64)tick_count * ticks.ns_per_tick + 0.5);
+}
+
 void platform_sleep(u64 ms)
 {
     Sleep(ms);
 }
 
+void platform_wait_for_events(u64 timeout_ms)
+{
+    if(!state_ptr || state_ptr->headless)
+    {
+        platform_sleep(timeout_ms);
+        return;
+    }
+
+    // Wakes as soon as any message is queued, including ones already seen by PeekMessage.
+    MsgWaitForMultipleObjectsEx(0, 0, (DWORD)timeout_ms, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+}
+
 void platform_get_required_extension_names(const char*** names_darray)
 {
     darray_push(*names_darray, &"VK_KHR_win32_surface");
@@ -302,9 +437,9 @@ LRESULT CALLBACK win32_process_message(HWND hwnd, u32 msg, WPARAM w_param, LPARA
         }
         case WM_CLOSE:
         {
-            // Fire an event for the application to quit.
+            // Post an event for the application to quit.
             event_context data = {};
-            event_fire(EVENT_CODE_APPLICATION_QUIT, 0, data);
+            event_post(EVENT_CODE_APPLICATION_QUIT, 0, data);
             return true;
         }
         case WM_DESTROY:
@@ -322,7 +457,8 @@ LRESULT CALLBACK win32_process_message(HWND hwnd, u32 msg, WPARAM w_param, LPARA
             event_context data = {};
             data.data.u16[0] = (u16)width;
             data.data.u16[1] = (u16)height;
-            event_fire(EVENT_CODE_RESIZED, 0, data);
+            // Posted: a drag-resize sends a storm of WM_SIZE, only the latest is dispatched.
+            event_post(EVENT_CODE_RESIZED, 0, data);
             break;
         }
         case WM_KEYDOWN:
@@ -359,21 +495,23 @@ LRESULT CALLBACK win32_process_message(HWND hwnd, u32 msg, WPARAM w_param, LPARA
         }
         case WM_MOUSEMOVE:
         {
-            // // Mouse move
-            // i32 x_position = GET_X_LPARAM(l_param);
-            // i32 y_position = GET_Y_LPARAM(l_param);
-            // // TODO: input processing
+            // Mouse move
+            i32 x_position = GET_X_LPARAM(l_param);
+            i32 y_position = GET_Y_LPARAM(l_param);
+
+            // Pass over to the input subsystem.
+            input_process_mouse_move(x_position, y_position);
             break;
         }
         case WM_MOUSEWHEEL:
         {
-            // i32 z_delta = GET_WHEEL_DELTA_WPARAM(w_param);
-            // if(z_delta != 0)
-            // {
-            //     // Flatten the input to an OS-indenpent (-1, 1)
-            //     z_delta = (z_delta < 0) ? -1 : 1;
-            //     // TODO: input processing
-            // }
+            i32 z_delta = GET_WHEEL_DELTA_WPARAM(w_param);
+            if(z_delta != 0)
+            {
+                // Flatten the input to an OS-indenpent (-1, 1)
+                z_delta = (z_delta < 0) ? -1 : 1;
+                input_process_mouse_wheel(z_delta);
+            }
             break;
         }
         case WM_LBUTTONDOWN:
@@ -383,8 +521,29 @@ LRESULT CALLBACK win32_process_message(HWND hwnd, u32 msg, WPARAM w_param, LPARA
         case WM_MBUTTONUP:
         case WM_RBUTTONUP:
         {
-            // b8 pressed = (msg == WM_LBUTTONDOWN) || (msg == WM_MBUTTONDOWN) || (msg == WM_RBUTTONDOWN);
-            // // TODO: input processing
+            b8 pressed = (msg == WM_LBUTTONDOWN) || (msg == WM_MBUTTONDOWN) || (msg == WM_RBUTTONDOWN);
+            mouse_button button = MOUSEBUTTONS_COUNT;
+            switch(msg)
+            {
+                case WM_LBUTTONDOWN:
+                case WM_LBUTTONUP:
+                    button = MOUSEBUTTON_LEFT;
+                    break;
+                case WM_MBUTTONDOWN:
+                case WM_MBUTTONUP:
+                    button = MOUSEBUTTON_MIDDLE;
+                    break;
+                case WM_RBUTTONDOWN:
+                case WM_RBUTTONUP:
+                    button = MOUSEBUTTON_RIGHT;
+                    break;
+            }
+
+            // Pass over to the input subsystem.
+            if(button != MOUSEBUTTONS_COUNT)
+            {
+                input_process_button(button, pressed);
+            }
             break;
         }
     }
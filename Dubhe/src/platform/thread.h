@@ -0,0 +1,221 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+ Threads and blocking synchronization primitives, implemented per platform in
+ thread_win32.c (Win32 threads, SRW locks, condition variables, semaphores) and
+ thread_linux.c (pthreads and POSIX semaphores).
+
+ Mutexes, condition variables and semaphores are stored inline with no heap allocation,
+ so they can be embedded in other structures. None of them may be copied once created.
+ The mutex is not recursive.
+*/
+
+// Large enough for the native object on every supported platform; checked in the implementations.
+#define PLATFORM_SYNC_STORAGE_SIZE 64
+
+/**
+ * @brief A thread entry point.
+ * @param params The params passed to platform_thread_create.
+ * @returns The thread's exit code.
+ */
+typedef u32 (*pfn_thread_start)(void* params);
+
+typedef struct platform_thread
+{
+    // Native handle (HANDLE or pthread_t).
+    u64 handle;
+    // The same id platform_thread_current_id returns on the thread itself.
+    u64 thread_id;
+} platform_thread;
+
+typedef enum platform_thread_priority
+{
+    PLATFORM_THREAD_PRIORITY_LOWEST,
+    PLATFORM_THREAD_PRIORITY_LOW,
+    PLATFORM_THREAD_PRIORITY_NORMAL,
+    PLATFORM_THREAD_PRIORITY_HIGH,
+    PLATFORM_THREAD_PRIORITY_HIGHEST
+} platform_thread_priority;
+
+// The most logical processors platform_get_cpu_topology reports; any beyond are left out.
+#define PLATFORM_MAX_LOGICAL_PROCESSORS 256
+
+typedef struct platform_logical_processor
+{
+    // The number platform_thread_set_affinity takes and platform_thread_current_processor returns.
+    u32 id;
+    // Index of the physical core, from 0 to physical_core_count - 1.
+    u32 core;
+    // NUMA node the processor belongs to, from 0 to numa_node_count - 1.
+    u32 numa_node;
+    // 0 for the core's first hardware thread, 1 and up for its SMT siblings.
+    u32 smt_index;
+} platform_logical_processor;
+
+typedef struct platform_cpu_topology
+{
+    u32 logical_processor_count;
+    u32 physical_core_count;
+    u32 numa_node_count;
+    u32 cache_line_size;
+    // Sizes in bytes of one cache of each level, 0 if unknown. L1 and L2 are usually per core,
+    // L3 shared by a whole package or core complex.
+    u64 l1_data_cache_size;
+    u64 l2_cache_size;
+    u64 l3_cache_size;
+    platform_logical_processor processors[PLATFORM_MAX_LOGICAL_PROCESSORS];
+} platform_cpu_topology;
+
+typedef struct platform_mutex
+{
+    _Alignas(8) u8 storage[PLATFORM_SYNC_STORAGE_SIZE];
+} platform_mutex;
+
+typedef struct platform_condition
+{
+    _Alignas(8) u8 storage[PLATFORM_SYNC_STORAGE_SIZE];
+} platform_condition;
+
+typedef struct platform_semaphore
+{
+    _Alignas(8) u8 storage[PLATFORM_SYNC_STORAGE_SIZE];
+} platform_semaphore;
+
+// Threads
+
+/**
+ * @brief Starts a new thread running start_function(params).
+ *
+ * @param start_function The function the thread runs.
+ * @param params Passed to start_function. Must outlive the thread's use of it.
+ * @param auto_detach If true the thread is detached immediately and must not be joined.
+ * @param out_thread Receives the thread. Not touched on failure.
+ * @returns True on success; otherwise false.
+ */
+DAPI b8 platform_thread_create(pfn_thread_start start_function, void* params, b8 auto_detach, platform_thread* out_thread);
+
+/**
+ * @brief Waits for the thread to exit and releases it.
+ *
+ * @param thread The thread to join. Zeroed afterwards.
+ * @param out_exit_code Optional. Receives the value start_function returned.
+ * @returns True on success; otherwise false.
+ */
+DAPI b8 platform_thread_join(platform_thread* thread, u32* out_exit_code);
+
+/**
+ * @brief Releases the thread without waiting; it keeps running and cleans up after itself.
+ */
+DAPI void platform_thread_detach(platform_thread* thread);
+
+/**
+ * @brief Names the calling thread for debuggers and profilers. Long names may be truncated
+ * (15 characters on Linux).
+ */
+DAPI void platform_thread_set_name(const char* name);
+
+/**
+ * @brief The OS id of the calling thread, as shown by debuggers and profilers.
+ */
+DAPI u64 platform_thread_current_id();
+
+/**
+ * @brief Gives up the rest of the calling thread's time slice.
+ */
+DAPI void platform_thread_yield();
+
+/**
+ * @brief Restricts the calling thread to the given logical processors.
+ *
+ * @param processor_ids Ids from platform_cpu_topology. On Windows all of them must be in the
+ *        same processor group as the first; others are ignored.
+ * @param count The number of ids. Must be at least 1.
+ * @returns True on success; otherwise false.
+ */
+DAPI b8 platform_thread_set_affinity(const u32* processor_ids, u32 count);
+
+/**
+ * @brief Sets the calling thread's scheduling priority. On Linux this is the thread's nice
+ * value; raising it above normal needs CAP_SYS_NICE and fails otherwise.
+ *
+ * @returns True on success; otherwise false.
+ */
+DAPI b8 platform_thread_set_priority(platform_thread_priority priority);
+
+/**
+ * @brief The id of the logical processor the calling thread is running on. Only a hint unless
+ * the thread is pinned to a single processor.
+ */
+DAPI u32 platform_thread_current_processor();
+
+// Processors
+
+/**
+ * @brief The number of logical processors available to the process.
+ */
+DAPI u32 platform_get_processor_count();
+
+/**
+ * @brief Describes the processors' cores, SMT siblings, NUMA nodes and caches. Read from
+ * sysfs on Linux and GetLogicalProcessorInformationEx on Windows; slow enough that it should
+ * be called once at startup.
+ *
+ * @param out_topology Receives the topology. On failure it still describes every processor
+ *        as its own core on node 0.
+ * @returns True if the full topology was read; otherwise false.
+ */
+DAPI b8 platform_get_cpu_topology(platform_cpu_topology* out_topology);
+
+// Mutexes
+
+DAPI b8 platform_mutex_create(platform_mutex* out_mutex);
+DAPI void platform_mutex_destroy(platform_mutex* mutex);
+DAPI void platform_mutex_lock(platform_mutex* mutex);
+/** @returns True if the lock was taken; false if another thread holds it. */
+DAPI b8 platform_mutex_try_lock(platform_mutex* mutex);
+DAPI void platform_mutex_unlock(platform_mutex* mutex);
+
+// Condition variables
+
+DAPI b8 platform_condition_create(platform_condition* out_condition);
+DAPI void platform_condition_destroy(platform_condition* condition);
+
+/**
+ * @brief Atomically unlocks mutex and waits for a signal, then relocks mutex before returning.
+ * May wake spuriously, so always wait in a loop that re-checks the predicate.
+ */
+DAPI void platform_condition_wait(platform_condition* condition, platform_mutex* mutex);
+
+/**
+ * @brief As platform_condition_wait, but gives up after timeout_ms.
+ * @returns False if the wait timed out.
+ */
+DAPI b8 platform_condition_wait_timeout(platform_condition* condition, platform_mutex* mutex, u64 timeout_ms);
+
+/** @brief Wakes one waiting thread, if any. */
+DAPI void platform_condition_signal(platform_condition* condition);
+/** @brief Wakes all waiting threads. */
+DAPI void platform_condition_broadcast(platform_condition* condition);
+
+// Semaphores
+
+/**
+ * @brief Creates a counting semaphore.
+ *
+ * @param initial_count The starting count.
+ * @param max_count The largest count the semaphore can reach. A signal that would go past it
+ *        raises the count to max_count and the rest is dropped. Must be at least initial_count.
+ */
+DAPI b8 platform_semaphore_create(u32 initial_count, u32 max_count, platform_semaphore* out_semaphore);
+DAPI void platform_semaphore_destroy(platform_semaphore* semaphore);
+
+/** @brief Adds count to the semaphore, waking up to count waiting threads. */
+DAPI void platform_semaphore_signal(platform_semaphore* semaphore, u32 count);
+
+/** @brief Waits until the count is above zero, then decrements it. */
+DAPI void platform_semaphore_wait(platform_semaphore* semaphore);
+
+/** @returns False if the count stayed at zero for timeout_ms. 0 only polls. */
+DAPI b8 platform_semaphore_wait_timeout(platform_semaphore* semaphore, u64 timeout_ms);
\ No newline at end of file
@@ -0,0 +1,579 @@
+// For pthread_setname_np.
+#define _GNU_SOURCE
+#include "platform/thread.h"
+
+// Linux threading.
+#if DPLATFORM_LINUX
+
+#include "core/logger.h"
+#include "platform/atomic.h"
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>
+#include <time.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+STATIC_ASSERT(sizeof(pthread_mutex_t) <= PLATFORM_SYNC_STORAGE_SIZE, "platform_mutex storage is too small.");
+STATIC_ASSERT(sizeof(pthread_cond_t) <= PLATFORM_SYNC_STORAGE_SIZE, "platform_condition storage is too small.");
+// POSIX semaphores have no maximum, so the count is mirrored to enforce one.
+typedef struct linux_semaphore
+{
+    sem_t handle;
+    u32 max_count;
+    // Atomic. Raised before posting and lowered after a wait succeeds, so it never reads
+    // below the semaphore's own value.
+    u32 count;
+} linux_semaphore;
+
+STATIC_ASSERT(sizeof(linux_semaphore) <= PLATFORM_SYNC_STORAGE_SIZE, "platform_semaphore storage is too small.");
+
+#define AS_MUTEX(m) ((pthread_mutex_t*)(m)->storage)
+#define AS_COND(c) ((pthread_cond_t*)(c)->storage)
+#define AS_SEM(s) ((linux_semaphore*)(s)->storage)
+
+#define SYSFS_CPU_PATH "/sys/devices/system/cpu"
+#define SYSFS_NODE_PATH "/sys/devices/system/node"
+// Caches listed per processor in sysfs (cache/index0 and up). Real CPUs have four or five.
+#define SYSFS_MAX_CACHE_INDEX 8
+
+// Lives on the creating thread's stack until the new thread has published its id.
+typedef struct thread_start_info
+{
+    pfn_thread_start start_function;
+    void* params;
+    // Atomic. Set by the new thread once it no longer needs this struct.
+    u64 thread_id;
+} thread_start_info;
+
+static DTHREAD_LOCAL u64 current_thread_id = 0;
+
+static void* thread_entry(void* arg)
+{
+    thread_start_info* info = arg;
+    pfn_thread_start start_function = info->start_function;
+    void* params = info->params;
+    datomic_store_u64(&info->thread_id, platform_thread_current_id(), DATOMIC_RELEASE);
+
+    u32 exit_code = start_function(params);
+    log_thread_exit();
+    return (void*)(u64)exit_code;
+}
+
+static void absolute_time_after(clockid_t clock, u64 timeout_ms, struct timespec* out_time)
+{
+    clock_gettime(clock, out_time);
+    out_time->tv_sec += timeout_ms / 1000;
+    out_time->tv_nsec += (timeout_ms % 1000) * 1000 * 1000;
+    if(out_time->tv_nsec >= 1000 * 1000 * 1000)
+    {
+        out_time->tv_sec++;
+        out_time->tv_nsec -= 1000 * 1000 * 1000;
+    }
+}
+
+b8 platform_thread_create(pfn_thread_start start_function, void* params, b8 auto_detach, platform_thread* out_thread)
+{
+    if(!start_function || !out_thread)
+    {
+        return false;
+    }
+
+    thread_start_info info;
+    info.start_function = start_function;
+    info.params = params;
+    info.thread_id = 0;
+
+    pthread_t handle;
+    i32 result = pthread_create(&handle, 0, thread_entry, &info);
+    if(result != 0)
+    {
+        DLOG_ERROR(LOG_CATEGORY_PLATFORM, "pthread_create failed with error %i.", result);
+        return false;
+    }
+
+    // The new thread is about to run anyway; this is a handful of yields at most.
+    while(datomic_load_u64(&info.thread_id, DATOMIC_ACQUIRE) == 0)
+    {
+        sched_yield();
+    }
+
+    out_thread->handle = (u64)handle;
+    out_thread->thread_id = info.thread_id;
+    if(auto_detach)
+    {
+        platform_thread_detach(out_thread);
+    }
+    return true;
+}
+
+b8 platform_thread_join(platform_thread* thread, u32* out_exit_code)
+{
+    if(!thread || !thread->handle)
+    {
+        return false;
+    }
+
+    void* exit_code = 0;
+    i32 result = pthread_join((pthread_t)thread->handle, &exit_code);
+    if(result != 0)
+    {
+        DLOG_ERROR(LOG_CATEGORY_PLATFORM, "pthread_join failed with error %i.", result);
+        return false;
+    }
+    if(out_exit_code)
+    {
+        *out_exit_code = (u32)(u64)exit_code;
+    }
+    thread->handle = 0;
+    thread->thread_id = 0;
+    return true;
+}
+
+void platform_thread_detach(platform_thread* thread)
+{
+    if(thread && thread->handle)
+    {
+        pthread_detach((pthread_t)thread->handle);
+        thread->handle = 0;
+    }
+}
+
+void platform_thread_set_name(const char* name)
+{
+    // The kernel limits names to 16 bytes including the terminator.
+    char truncated[16];
+    strncpy(truncated, name, sizeof(truncated) - 1);
+    truncated[sizeof(truncated) - 1] = 0;
+    pthread_setname_np(pthread_self(), truncated);
+}
+
+u64 platform_thread_current_id()
+{
+    // gettid is a syscall; cache it.
+    if(current_thread_id == 0)
+    {
+        current_thread_id = (u64)syscall(SYS_gettid);
+    }
+    return current_thread_id;
+}
+
+void platform_thread_yield()
+{
+    sched_yield();
+}
+
+b8 platform_thread_set_affinity(const u32* processor_ids, u32 count)
+{
+    if(!processor_ids || count == 0)
+    {
+        return false;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(u32 i = 0; i < count; ++i)
+    {
+        if(processor_ids[i] < CPU_SETSIZE)
+        {
+            CPU_SET(processor_ids[i], &set);
+        }
+    }
+    i32 result = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if(result != 0)
+    {
+        DLOG_ERROR(LOG_CATEGORY_PLATFORM, "pthread_setaffinity_np failed with error %i.", result);
+        return false;
+    }
+    return true;
+}
+
+b8 platform_thread_set_priority(platform_thread_priority priority)
+{
+    // Threads have their own nice value on Linux, addressed by thread id.
+    static const i32 nice_values[] = {10, 5, 0, -5, -10};
+    if(setpriority(PRIO_PROCESS, (id_t)platform_thread_current_id(), nice_values[priority]) != 0)
+    {
+        DLOG_WARN(LOG_CATEGORY_PLATFORM, "setpriority failed with error %i.", errno);
+        return false;
+    }
+    return true;
+}
+
+u32 platform_thread_current_processor()
+{
+    i32 processor = sched_getcpu();
+    return processor >= 0 ? (u32)processor : 0;
+}
+
+u32 platform_get_processor_count()
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (u32)count : 1;
+}
+
+// Reads a small sysfs file into buffer, without the trailing newline.
+static b8 read_sysfs_text(const char* path, char* buffer, u32 size)
+{
+    FILE* file = fopen(path, "r");
+    if(!file)
+    {
+        return false;
+    }
+    b8 result = fgets(buffer, (i32)size, file) != 0;
+    fclose(file);
+    if(result)
+    {
+        buffer[strcspn(buffer, "\n")] = 0;
+    }
+    return result;
+}
+
+static b8 read_sysfs_u64(const char* path, u64* out_value)
+{
+    char text[32];
+    if(!read_sysfs_text(path, text, sizeof(text)))
+    {
+        return false;
+    }
+    *out_value = strtoull(text, 0, 10);
+    return true;
+}
+
+// Parses a cpu list like "0-3,8-11", setting in_list[id] for each id below
+// PLATFORM_MAX_LOGICAL_PROCESSORS. Returns false if the file can't be read.
+static b8 read_sysfs_cpu_list(const char* path, b8* in_list)
+{
+    char text[1024];
+    if(!read_sysfs_text(path, text, sizeof(text)))
+    {
+        return false;
+    }
+
+    char* cursor = text;
+    while(*cursor)
+    {
+        char* end;
+        u64 first = strtoull(cursor, &end, 10);
+        if(end == cursor)
+        {
+            break;
+        }
+        u64 last = first;
+        cursor = end;
+        if(*cursor == '-')
+        {
+            last = strtoull(cursor + 1, &cursor, 10);
+        }
+        for(u64 id = first; id <= last && id < PLATFORM_MAX_LOGICAL_PROCESSORS; ++id)
+        {
+            in_list[id] = true;
+        }
+        if(*cursor == ',')
+        {
+            cursor++;
+        }
+    }
+    return true;
+}
+
+static void read_cache_sizes(u32 processor_id, platform_cpu_topology* topology)
+{
+    char path[128];
+    for(u32 index = 0; index < SYSFS_MAX_CACHE_INDEX; ++index)
+    {
+        u64 level = 0;
+        snprintf(path, sizeof(path), SYSFS_CPU_PATH "/cpu%u/cache/index%u/level", processor_id, index);
+        if(!read_sysfs_u64(path, &level))
+        {
+            break;
+        }
+
+        char type[32];
+        snprintf(path, sizeof(path), SYSFS_CPU_PATH "/cpu%u/cache/index%u/type", processor_id, index);
+        if(!read_sysfs_text(path, type, sizeof(type)) || strcmp(type, "Instruction") == 0)
+        {
+            continue;
+        }
+
+        // Given in kilobytes, as "32K".
+        u64 size = 0;
+        snprintf(path, sizeof(path), SYSFS_CPU_PATH "/cpu%u/cache/index%u/size", processor_id, index);
+        if(read_sysfs_u64(path, &size))
+        {
+            size *= 1024;
+        }
+        if(level == 1)
+        {
+            topology->l1_data_cache_size = size;
+            u64 line_size = 0;
+            snprintf(path, sizeof(path), SYSFS_CPU_PATH "/cpu%u/cache/index%u/coherency_line_size", processor_id, index);
+            if(read_sysfs_u64(path, &line_size) && line_size > 0)
+            {
+                topology->cache_line_size = (u32)line_size;
+            }
+        }
+        else if(level == 2)
+        {
+            topology->l2_cache_size = size;
+        }
+        else if(level == 3)
+        {
+            topology->l3_cache_size = size;
+        }
+    }
+}
+
+b8 platform_get_cpu_topology(platform_cpu_topology* out_topology)
+{
+    memset(out_topology, 0, sizeof(platform_cpu_topology));
+    out_topology->cache_line_size = 64;
+    out_topology->numa_node_count = 1;
+
+    b8 online[PLATFORM_MAX_LOGICAL_PROCESSORS] = {0};
+    b8 complete = read_sysfs_cpu_list(SYSFS_CPU_PATH "/online", online);
+    if(!complete)
+    {
+        u32 count = platform_get_processor_count();
+        for(u32 id = 0; id < count && id < PLATFORM_MAX_LOGICAL_PROCESSORS; ++id)
+        {
+            online[id] = true;
+        }
+    }
+
+    // Cores are identified by package and core id; the latter is only unique within a package.
+    u64 core_keys[PLATFORM_MAX_LOGICAL_PROCESSORS];
+    char path[128];
+    for(u32 id = 0; id < PLATFORM_MAX_LOGICAL_PROCESSORS; ++id)
+    {
+        if(!online[id])
+        {
+            continue;
+        }
+
+        u64 package = 0;
+        u64 core_id = id;
+        snprintf(path, sizeof(path), SYSFS_CPU_PATH "/cpu%u/topology/physical_package_id", id);
+        b8 has_package = read_sysfs_u64(path, &package);
+        snprintf(path, sizeof(path), SYSFS_CPU_PATH "/cpu%u/topology/core_id", id);
+        if(!has_package || !read_sysfs_u64(path, &core_id))
+        {
+            complete = false;
+            package = 0;
+            core_id = id;
+        }
+        u64 key = (package << 32) | core_id;
+
+        platform_logical_processor* processor = &out_topology->processors[out_topology->logical_processor_count++];
+        processor->id = id;
+        processor->core = out_topology->physical_core_count;
+        for(u32 core = 0; core < out_topology->physical_core_count; ++core)
+        {
+            if(core_keys[core] == key)
+            {
+                processor->core = core;
+                break;
+            }
+        }
+        if(processor->core == out_topology->physical_core_count)
+        {
+            core_keys[out_topology->physical_core_count++] = key;
+        }
+        for(u32 i = 0; i + 1 < out_topology->logical_processor_count; ++i)
+        {
+            if(out_topology->processors[i].core == processor->core)
+            {
+                processor->smt_index++;
+            }
+        }
+    }
+
+    // Kernels without NUMA support have no node directory; everything is on node 0 then.
+    b8 nodes[PLATFORM_MAX_LOGICAL_PROCESSORS] = {0};
+    if(read_sysfs_cpu_list(SYSFS_NODE_PATH "/online", nodes))
+    {
+        // Node ids can have gaps; number the nodes densely.
+        u32 node_count = 0;
+        for(u32 node = 0; node < PLATFORM_MAX_LOGICAL_PROCESSORS; ++node)
+        {
+            if(!nodes[node])
+            {
+                continue;
+            }
+            b8 node_processors[PLATFORM_MAX_LOGICAL_PROCESSORS] = {0};
+            snprintf(path, sizeof(path), SYSFS_NODE_PATH "/node%u/cpulist", node);
+            if(!read_sysfs_cpu_list(path, node_processors))
+            {
+                continue;
+            }
+            for(u32 i = 0; i < out_topology->logical_processor_count; ++i)
+            {
+                if(node_processors[out_topology->processors[i].id])
+                {
+                    out_topology->processors[i].numa_node = node_count;
+                }
+            }
+            node_count++;
+        }
+        if(node_count > 0)
+        {
+            out_topology->numa_node_count = node_count;
+        }
+    }
+
+    if(out_topology->logical_processor_count > 0)
+    {
+        read_cache_sizes(out_topology->processors[0].id, out_topology);
+    }
+    return complete;
+}
+
+b8 platform_mutex_create(platform_mutex* out_mutex)
+{
+    if(pthread_mutex_init(AS_MUTEX(out_mutex), 0) != 0)
+    {
+        DLOG_ERROR(LOG_CATEGORY_PLATFORM, "Failed to create mutex.");
+        return false;
+    }
+    return true;
+}
+
+void platform_mutex_destroy(platform_mutex* mutex)
+{
+    pthread_mutex_destroy(AS_MUTEX(mutex));
+}
+
+void platform_mutex_lock(platform_mutex* mutex)
+{
+    pthread_mutex_lock(AS_MUTEX(mutex));
+}
+
+b8 platform_mutex_try_lock(platform_mutex* mutex)
+{
+    return pthread_mutex_trylock(AS_MUTEX(mutex)) == 0;
+}
+
+void platform_mutex_unlock(platform_mutex* mutex)
+{
+    pthread_mutex_unlock(AS_MUTEX(mutex));
+}
+
+b8 platform_condition_create(platform_condition* out_condition)
+{
+    // Time out against the monotonic clock so wall clock changes don't stretch waits.
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    i32 result = pthread_cond_init(AS_COND(out_condition), &attributes);
+    pthread_condattr_destroy(&attributes);
+    if(result != 0)
+    {
+        DLOG_ERROR(LOG_CATEGORY_PLATFORM, "Failed to create condition variable.");
+        return false;
+    }
+    return true;
+}
+
+void platform_condition_destroy(platform_condition* condition)
+{
+    pthread_cond_destroy(AS_COND(condition));
+}
+
+void platform_condition_wait(platform_condition* condition, platform_mutex* mutex)
+{
+    pthread_cond_wait(AS_COND(condition), AS_MUTEX(mutex));
+}
+
+b8 platform_condition_wait_timeout(platform_condition* condition, platform_mutex* mutex, u64 timeout_ms)
+{
+    struct timespec deadline;
+    absolute_time_after(CLOCK_MONOTONIC, timeout_ms, &deadline);
+    return pthread_cond_timedwait(AS_COND(condition), AS_MUTEX(mutex), &deadline) != ETIMEDOUT;
+}
+
+void platform_condition_signal(platform_condition* condition)
+{
+    pthread_cond_signal(AS_COND(condition));
+}
+
+void platform_condition_broadcast(platform_condition* condition)
+{
+    pthread_cond_broadcast(AS_COND(condition));
+}
+
+b8 platform_semaphore_create(u32 initial_count, u32 max_count, platform_semaphore* out_semaphore)
+{
+    if(initial_count > max_count || sem_init(&AS_SEM(out_semaphore)->handle, 0, initial_count) != 0)
+    {
+        DLOG_ERROR(LOG_CATEGORY_PLATFORM, "Failed to create semaphore.");
+        return false;
+    }
+    AS_SEM(out_semaphore)->max_count = max_count;
+    AS_SEM(out_semaphore)->count = initial_count;
+    return true;
+}
+
+void platform_semaphore_destroy(platform_semaphore* semaphore)
+{
+    sem_destroy(&AS_SEM(semaphore)->handle);
+}
+
+void platform_semaphore_signal(platform_semaphore* semaphore, u32 count)
+{
+    // Take only what fits below the maximum, as Win32 does.
+    linux_semaphore* internal = AS_SEM(semaphore);
+    u32 current = datomic_load_u32(&internal->count, DATOMIC_RELAXED);
+    u32 added;
+    do
+    {
+        u32 room = internal->max_count - current;
+        added = count < room ? count : room;
+    } while(added > 0 && !datomic_compare_exchange_weak_u32(&internal->count, &current, current + added, DATOMIC_RELAXED));
+
+    for(u32 i = 0; i < added; i++)
+    {
+        sem_post(&internal->handle);
+    }
+}
+
+void platform_semaphore_wait(platform_semaphore* semaphore)
+{
+    // Retry if a signal handler interrupts the wait.
+    while(sem_wait(&AS_SEM(semaphore)->handle) != 0 && errno == EINTR)
+    {
+    }
+    datomic_fetch_sub_u32(&AS_SEM(semaphore)->count, 1, DATOMIC_RELAXED);
+}
+
+b8 platform_semaphore_wait_timeout(platform_semaphore* semaphore, u64 timeout_ms)
+{
+    i32 result;
+    if(timeout_ms == 0)
+    {
+        result = sem_trywait(&AS_SEM(semaphore)->handle);
+    }
+    else
+    {
+        // sem_timedwait only accepts CLOCK_REALTIME deadlines.
+        struct timespec deadline;
+        absolute_time_after(CLOCK_REALTIME, timeout_ms, &deadline);
+        while((result = sem_timedwait(&AS_SEM(semaphore)->handle, &deadline)) != 0 && errno == EINTR)
+        {
+        }
+    }
+
+    if(result != 0)
+    {
+        return false;
+    }
+    datomic_fetch_sub_u32(&AS_SEM(semaphore)->count, 1, DATOMIC_RELAXED);
+    return true;
+}
+
+#endif  // DPLATFORM_LINUX
\ No newline at end of file
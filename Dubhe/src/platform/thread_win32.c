@@ -0,0 +1,453 @@
+#include "platform/thread.h"
+
+// Windows threading.
+#if DPLATFORM_WINDOWS
+
+#include "core/logger.h"
+#include "platform/atomic.h"
+
+#include <windows.h>
+
+STATIC_ASSERT(sizeof(SRWLOCK) <= PLATFORM_SYNC_STORAGE_SIZE, "platform_mutex storage is too small.");
+STATIC_ASSERT(sizeof(CONDITION_VARIABLE) <= PLATFORM_SYNC_STORAGE_SIZE, "platform_condition storage is too small.");
+STATIC_ASSERT(sizeof(HANDLE) <= PLATFORM_SYNC_STORAGE_SIZE, "platform_semaphore storage is too small.");
+
+// SRW locks are a single pointer and never enter the kernel when uncontended,
+// which makes them cheaper than critical sections.
+#define AS_LOCK(m) ((SRWLOCK*)(m)->storage)
+#define AS_COND(c) ((CONDITION_VARIABLE*)(c)->storage)
+#define AS_HANDLE(s) (*(HANDLE*)(s)->storage)
+
+// Lives on the creating thread's stack until the new thread has started.
+typedef struct thread_start_info
+{
+    pfn_thread_start start_function;
+    void* params;
+    // Atomic. Set by the new thread once it no longer needs this struct.
+    u32 started;
+} thread_start_info;
+
+// SetThreadDescription is only available from Windows 10 1607; look it up at runtime.
+typedef HRESULT (WINAPI *PFN_SetThreadDescription)(HANDLE thread, PCWSTR description);
+
+static DWORD WINAPI thread_entry(LPVOID arg)
+{
+    thread_start_info* info = arg;
+    pfn_thread_start start_function = info->start_function;
+    void* params = info->params;
+    datomic_store_u32(&info->started, 1, DATOMIC_RELEASE);
+
+    u32 exit_code = start_function(params);
+    log_thread_exit();
+    return (DWORD)exit_code;
+}
+
+b8 platform_thread_create(pfn_thread_start start_function, void* params, b8 auto_detach, platform_thread* out_thread)
+{
+    if(!start_function || !out_thread)
+    {
+        return false;
+    }
+
+    thread_start_info info;
+    info.start_function = start_function;
+    info.params = params;
+    info.started = 0;
+
+    DWORD thread_id = 0;
+    HANDLE handle = CreateThread(0, 0, thread_entry, &info, 0, &thread_id);
+    if(!handle)
+    {
+        DLOG_ERROR(LOG_CATEGORY_PLATFORM, "CreateThread failed with error %u.", (u32)GetLastError());
+        return false;
+    }
+
+    // The new thread is about to run anyway; this is a handful of yields at most.
+    while(datomic_load_u32(&info.started, DATOMIC_ACQUIRE) == 0)
+    {
+        SwitchToThread();
+    }
+
+    out_thread->handle = (u64)handle;
+    out_thread->thread_id = (u64)thread_id;
+    if(auto_detach)
+    {
+        platform_thread_detach(out_thread);
+    }
+    return true;
+}
+
+b8 platform_thread_join(platform_thread* thread, u32* out_exit_code)
+{
+    if(!thread || !thread->handle)
+    {
+        return false;
+    }
+
+    HANDLE handle = (HANDLE)thread->handle;
+    if(WaitForSingleObject(handle, INFINITE) != WAIT_OBJECT_0)
+    {
+        DLOG_ERROR(LOG_CATEGORY_PLATFORM, "Failed to join thread %llu.", thread->thread_id);
+        return false;
+    }
+    if(out_exit_code)
+    {
+        DWORD exit_code = 0;
+        GetExitCodeThread(handle, &exit_code);
+        *out_exit_code = (u32)exit_code;
+    }
+    CloseHandle(handle);
+    thread->handle = 0;
+    thread->thread_id = 0;
+    return true;
+}
+
+void platform_thread_detach(platform_thread* thread)
+{
+    if(thread && thread->handle)
+    {
+        CloseHandle((HANDLE)thread->handle);
+        thread->handle = 0;
+    }
+}
+
+void platform_thread_set_name(const char* name)
+{
+    static PFN_SetThreadDescription set_thread_description = 0;
+    static b8 looked_up = false;
+    if(!looked_up)
+    {
+        set_thread_description = (PFN_SetThreadDescription)(void*)GetProcAddress(GetModuleHandleA("kernel32.dll"), "SetThreadDescription");
+        looked_up = true;
+    }
+    if(!set_thread_description)
+    {
+        return;
+    }
+
+    WCHAR wide_name[64];
+    if(MultiByteToWideChar(CP_UTF8, 0, name, -1, wide_name, 64) == 0)
+    {
+        // Too long or invalid UTF-8: keep the prefix that fits.
+        MultiByteToWideChar(CP_UTF8, 0, name, 63, wide_name, 63);
+        wide_name[63] = 0;
+    }
+    set_thread_description(GetCurrentThread(), wide_name);
+}
+
+u64 platform_thread_current_id()
+{
+    return (u64)GetCurrentThreadId();
+}
+
+void platform_thread_yield()
+{
+    SwitchToThread();
+}
+
+// Logical processors are numbered across processor groups: group 0's processors first,
+// then group 1's and so on.
+static u32 processor_group_offset(WORD group)
+{
+    u32 offset = 0;
+    for(WORD i = 0; i < group; ++i)
+    {
+        offset += GetActiveProcessorCount(i);
+    }
+    return offset;
+}
+
+static void processor_id_to_group(u32 id, WORD* out_group, u8* out_number)
+{
+    WORD group_count = GetActiveProcessorGroupCount();
+    for(WORD group = 0; group < group_count; ++group)
+    {
+        u32 count = GetActiveProcessorCount(group);
+        if(id < count)
+        {
+            *out_group = group;
+            *out_number = (u8)id;
+            return;
+        }
+        id -= count;
+    }
+    *out_group = 0;
+    *out_number = 0;
+}
+
+b8 platform_thread_set_affinity(const u32* processor_ids, u32 count)
+{
+    if(!processor_ids || count == 0)
+    {
+        return false;
+    }
+
+    // A thread runs in one processor group at a time.
+    GROUP_AFFINITY affinity;
+    ZeroMemory(&affinity, sizeof(affinity));
+    u8 number;
+    processor_id_to_group(processor_ids[0], &affinity.Group, &number);
+    for(u32 i = 0; i < count; ++i)
+    {
+        WORD group;
+        processor_id_to_group(processor_ids[i], &group, &number);
+        if(group == affinity.Group)
+        {
+            affinity.Mask |= (KAFFINITY)1 << number;
+        }
+    }
+    if(!SetThreadGroupAffinity(GetCurrentThread(), &affinity, 0))
+    {
+        DLOG_ERROR(LOG_CATEGORY_PLATFORM, "SetThreadGroupAffinity failed with error %u.", (u32)GetLastError());
+        return false;
+    }
+    return true;
+}
+
+b8 platform_thread_set_priority(platform_thread_priority priority)
+{
+    static const i32 priorities[] = {
+        THREAD_PRIORITY_LOWEST,
+        THREAD_PRIORITY_BELOW_NORMAL,
+        THREAD_PRIORITY_NORMAL,
+        THREAD_PRIORITY_ABOVE_NORMAL,
+        THREAD_PRIORITY_HIGHEST};
+    if(!SetThreadPriority(GetCurrentThread(), priorities[priority]))
+    {
+        DLOG_WARN(LOG_CATEGORY_PLATFORM, "SetThreadPriority failed with error %u.", (u32)GetLastError());
+        return false;
+    }
+    return true;
+}
+
+u32 platform_thread_current_processor()
+{
+    PROCESSOR_NUMBER number;
+    GetCurrentProcessorNumberEx(&number);
+    return processor_group_offset(number.Group) + number.Number;
+}
+
+u32 platform_get_processor_count()
+{
+    // Counts every processor group, unlike GetSystemInfo which stops at 64.
+    DWORD count = GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+    return count > 0 ? (u32)count : 1;
+}
+
+static platform_logical_processor* find_processor(platform_cpu_topology* topology, u32 id)
+{
+    for(u32 i = 0; i < topology->logical_processor_count; ++i)
+    {
+        if(topology->processors[i].id == id)
+        {
+            return &topology->processors[i];
+        }
+    }
+    return 0;
+}
+
+b8 platform_get_cpu_topology(platform_cpu_topology* out_topology)
+{
+    ZeroMemory(out_topology, sizeof(platform_cpu_topology));
+    out_topology->cache_line_size = 64;
+    out_topology->numa_node_count = 1;
+
+    // Two calls: the first fails with ERROR_INSUFFICIENT_BUFFER and reports the size.
+    DWORD length = 0;
+    GetLogicalProcessorInformationEx(RelationAll, 0, &length);
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* buffer = length ? HeapAlloc(GetProcessHeap(), 0, length) : 0;
+    if(!buffer || !GetLogicalProcessorInformationEx(RelationAll, buffer, &length))
+    {
+        DLOG_ERROR(LOG_CATEGORY_PLATFORM, "GetLogicalProcessorInformationEx failed with error %u.", (u32)GetLastError());
+        if(buffer)
+        {
+            HeapFree(GetProcessHeap(), 0, buffer);
+        }
+        u32 count = platform_get_processor_count();
+        for(u32 id = 0; id < count && id < PLATFORM_MAX_LOGICAL_PROCESSORS; ++id)
+        {
+            platform_logical_processor* processor = &out_topology->processors[out_topology->logical_processor_count++];
+            processor->id = id;
+            processor->core = out_topology->physical_core_count++;
+        }
+        return false;
+    }
+
+    // Records are variable-sized. Cores come first in practice, but NUMA nodes are matched in
+    // a second pass so the order doesn't matter.
+    u8* end = (u8*)buffer + length;
+    for(u8* cursor = (u8*)buffer; cursor < end; cursor += ((SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)cursor)->Size)
+    {
+        SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* info = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)cursor;
+        if(info->Relationship == RelationProcessorCore)
+        {
+            u32 core = out_topology->physical_core_count++;
+            u32 smt_index = 0;
+            // A core is always within a single group.
+            GROUP_AFFINITY* mask = &info->Processor.GroupMask[0];
+            u32 offset = processor_group_offset(mask->Group);
+            for(u32 bit = 0; bit < sizeof(KAFFINITY) * 8; ++bit)
+            {
+                if((mask->Mask & ((KAFFINITY)1 << bit)) && out_topology->logical_processor_count < PLATFORM_MAX_LOGICAL_PROCESSORS)
+                {
+                    platform_logical_processor* processor = &out_topology->processors[out_topology->logical_processor_count++];
+                    processor->id = offset + bit;
+                    processor->core = core;
+                    processor->smt_index = smt_index++;
+                }
+            }
+        }
+        else if(info->Relationship == RelationCache)
+        {
+            CACHE_RELATIONSHIP* cache = &info->Cache;
+            if(cache->Type == CacheInstruction || cache->Type == CacheTrace)
+            {
+                continue;
+            }
+            if(cache->Level == 1)
+            {
+                out_topology->l1_data_cache_size = cache->CacheSize;
+                out_topology->cache_line_size = cache->LineSize;
+            }
+            else if(cache->Level == 2)
+            {
+                out_topology->l2_cache_size = cache->CacheSize;
+            }
+            else if(cache->Level == 3)
+            {
+                out_topology->l3_cache_size = cache->CacheSize;
+            }
+        }
+    }
+
+    // Node numbers can have gaps; number the nodes densely.
+    u32 node_count = 0;
+    for(u8* cursor = (u8*)buffer; cursor < end; cursor += ((SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)cursor)->Size)
+    {
+        SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* info = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)cursor;
+        if(info->Relationship != RelationNumaNode)
+        {
+            continue;
+        }
+        GROUP_AFFINITY* mask = &info->NumaNode.GroupMask;
+        u32 offset = processor_group_offset(mask->Group);
+        for(u32 bit = 0; bit < sizeof(KAFFINITY) * 8; ++bit)
+        {
+            platform_logical_processor* processor = 0;
+            if((mask->Mask & ((KAFFINITY)1 << bit)) && (processor = find_processor(out_topology, offset + bit)))
+            {
+                processor->numa_node = node_count;
+            }
+        }
+        node_count++;
+    }
+    if(node_count > 0)
+    {
+        out_topology->numa_node_count = node_count;
+    }
+
+    HeapFree(GetProcessHeap(), 0, buffer);
+    return true;
+}
+
+b8 platform_mutex_create(platform_mutex* out_mutex)
+{
+    InitializeSRWLock(AS_LOCK(out_mutex));
+    return true;
+}
+
+void platform_mutex_destroy(platform_mutex* mutex)
+{
+    // SRW locks own no resources.
+}
+
+void platform_mutex_lock(platform_mutex* mutex)
+{
+    AcquireSRWLockExclusive(AS_LOCK(mutex));
+}
+
+b8 platform_mutex_try_lock(platform_mutex* mutex)
+{
+    return TryAcquireSRWLockExclusive(AS_LOCK(mutex)) != 0;
+}
+
+void platform_mutex_unlock(platform_mutex* mutex)
+{
+    ReleaseSRWLockExclusive(AS_LOCK(mutex));
+}
+
+b8 platform_condition_create(platform_condition* out_condition)
+{
+    InitializeConditionVariable(AS_COND(out_condition));
+    return true;
+}
+
+void platform_condition_destroy(platform_condition* condition)
+{
+    // Condition variables own no resources.
+}
+
+void platform_condition_wait(platform_condition* condition, platform_mutex* mutex)
+{
+    SleepConditionVariableSRW(AS_COND(condition), AS_LOCK(mutex), INFINITE, 0);
+}
+
+b8 platform_condition_wait_timeout(platform_condition* condition, platform_mutex* mutex, u64 timeout_ms)
+{
+    return SleepConditionVariableSRW(AS_COND(condition), AS_LOCK(mutex), (DWORD)timeout_ms, 0) != 0;
+}
+
+void platform_condition_signal(platform_condition* condition)
+{
+    WakeConditionVariable(AS_COND(condition));
+}
+
+void platform_condition_broadcast(platform_condition* condition)
+{
+    WakeAllConditionVariable(AS_COND(condition));
+}
+
+b8 platform_semaphore_create(u32 initial_count, u32 max_count, platform_semaphore* out_semaphore)
+{
+    HANDLE handle = CreateSemaphoreA(0, (LONG)initial_count, (LONG)max_count, 0);
+    if(!handle)
+    {
+        DLOG_ERROR(LOG_CATEGORY_PLATFORM, "Failed to create semaphore.");
+        return false;
+    }
+    AS_HANDLE(out_semaphore) = handle;
+    return true;
+}
+
+void platform_semaphore_destroy(platform_semaphore* semaphore)
+{
+    if(AS_HANDLE(semaphore))
+    {
+        CloseHandle(AS_HANDLE(semaphore));
+        AS_HANDLE(semaphore) = 0;
+    }
+}
+
+void platform_semaphore_signal(platform_semaphore* semaphore, u32 count)
+{
+    // Fails without changing the count if it would exceed max_count. Then add what still fits,
+    // one at a time, so the count stops at the maximum as it does on Linux.
+    if(!ReleaseSemaphore(AS_HANDLE(semaphore), (LONG)count, 0))
+    {
+        for(u32 i = 1; i < count && ReleaseSemaphore(AS_HANDLE(semaphore), 1, 0); i++)
+        {
+        }
+    }
+}
+
+void platform_semaphore_wait(platform_semaphore* semaphore)
+{
+    WaitForSingleObject(AS_HANDLE(semaphore), INFINITE);
+}
+
+b8 platform_semaphore_wait_timeout(platform_semaphore* semaphore, u64 timeout_ms)
+{
+    return WaitForSingleObject(AS_HANDLE(semaphore), (DWORD)timeout_ms) == WAIT_OBJECT_0;
+}
+
+#endif  // DPLATFORM_WINDOWS
\ No newline at end of file
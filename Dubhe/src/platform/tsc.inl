@@ -0,0 +1,39 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+ Time stamp counter helpers shared by the platform layers' tick sources. The TSC is read in
+ user mode with a single instruction, an order of magnitude cheaper than clock_gettime or
+ QueryPerformanceCounter, but its rate has to be calibrated against an OS clock.
+*/
+
+#if defined(__x86_64__) || defined(__i386__)
+#define DTSC_SUPPORTED 1
+
+#include <cpuid.h>
+#include <x86intrin.h>
+
+/**
+ * @brief Checks for an invariant TSC: one that ticks at a constant rate in every power state
+ * and is kept in sync across cores. Without it the TSC can't stand in for a clock.
+ */
+static b8 tsc_is_invariant()
+{
+    u32 eax, ebx, ecx, edx;
+    if(!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007)
+    {
+        return false;
+    }
+    __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+    return (edx & (1u << 8)) != 0;
+}
+
+DINLINE u64 tsc_read()
+{
+    return __rdtsc();
+}
+
+#else
+#define DTSC_SUPPORTED 0
+#endif
\ No newline at end of file
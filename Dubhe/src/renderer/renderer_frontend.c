@@ -5,7 +5,6 @@
 #include "core/logger.h"
 #include "core/dmemory.h"
 
-static renderer_backend* backend = 0;
 typedef struct renderer_system_state {
     renderer_backend backend;
 } renderer_system_state;
@@ -56,11 +55,11 @@ void renderer_on_resize(u16 width, u16 height)
 {
     if(state_ptr)
     {
-        state_ptr->backend.resized(backend, width, height);
+        state_ptr->backend.resized(&state_ptr->backend, width, height);
     }
     else
     {
-        DWARN("renderer backend does not exists to accept resize: %i %i", width, height);
+        DLOG_WARN(LOG_CATEGORY_RENDERER, "renderer backend does not exists to accept resize: %i %i", width, height);
     }
 }
 
@@ -19,6 +19,9 @@
 #include "shaders/vulkan_object_shader.h"
 #include "math/math_types.h"
 
+// Number of identical validation messages logged per second before they are summarized.
+#define VULKAN_DEBUG_MESSAGE_BUDGET 5
+
 static vulkan_context context;
 static u32 cached_framebuffer_width = 0;
 static u32 cached_framebuffer_height = 0;
@@ -29,6 +32,8 @@ VKAPI_ATTR VkBool32 VKAPI_CALL vk_debug_callback(
     const VkDebugUtilsMessengerCallbackDataEXT*      pCallbackData,
     void*                                            pUserData);
 
+static b8 create_headless_surface(vulkan_context* context);
+
 // TODO: temporary codes
 void upload_data_range(vulkan_context* context, VkCommandPool pool, VkFence fence, VkQueue queue, vulkan_buffer* buffer, u64 offset, u64 size, void* data) 
 {
@@ -72,14 +77,22 @@ b8 vulkan_renderer_backend_initialize(renderer_backend* backend, const char* app
     // Obtain a list of requried extensions
     const char** required_extensions = darray_create(const char*);
     darray_push(required_extensions, &VK_KHR_SURFACE_EXTENSION_NAME);   // Generic surface extension
-    platform_get_required_extension_names(&required_extensions); 
+    if(platform_is_headless())
+    {
+        // Surface without a window; its swapchain images are never displayed.
+        darray_push(required_extensions, &VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME);
+    }
+    else
+    {
+        platform_get_required_extension_names(&required_extensions);
+    }
 #if defined(_DEBUG)
     darray_push(required_extensions, &VK_EXT_DEBUG_UTILS_EXTENSION_NAME); // Debug utilities
-    DDEBUG("Required extensions:");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Required extensions:");
     u32 length = darray_length(required_extensions);
     for(u32 i = 0; i < length; i++)
     {
-        DDEBUG("    %s", required_extensions[i]);
+        DLOG_DEBUG(LOG_CATEGORY_VULKAN, "    %s", required_extensions[i]);
     }
 #endif   
     create_info.enabledExtensionCount = darray_length(required_extensions);
@@ -89,7 +102,7 @@ b8 vulkan_renderer_backend_initialize(renderer_backend* backend, const char* app
     const char** required_validation_layer_names  = 0;
     u32 required_validation_layer_count = 0;
 #if defined(_DEBUG)
-    DINFO("Validation layers enabled. Enumerating...");
+    DLOG_INFO(LOG_CATEGORY_VULKAN, "Validation layers enabled. Enumerating...");
 
     // The list of validation layers required.
     required_validation_layer_names = darray_create(const char*);
@@ -106,14 +119,14 @@ b8 vulkan_renderer_backend_initialize(renderer_backend* backend, const char* app
     // Verify all layers are available
     for(u32 i = 0; i < required_validation_layer_count; i++)
     {
-        DINFO("Serach for layer: %s......", required_validation_layer_names[i]);
+        DLOG_INFO(LOG_CATEGORY_VULKAN, "Serach for layer: %s......", required_validation_layer_names[i]);
         b8 found = false;
         for(u32 j = 0; j < available_layer_count; j++)
         {
             if(strings_equal(available_layer_properties[j].layerName, required_validation_layer_names[i]))
             {
                 found = true;
-                DINFO("Found.");
+                DLOG_INFO(LOG_CATEGORY_VULKAN, "Found.");
                 break;
             }
         }
@@ -124,7 +137,7 @@ b8 vulkan_renderer_backend_initialize(renderer_backend* backend, const char* app
             return false;
         }
     }
-    DINFO("All required layers are ready.");
+    DLOG_INFO(LOG_CATEGORY_VULKAN, "All required layers are ready.");
 #endif
     create_info.enabledLayerCount = required_validation_layer_count;
     create_info.ppEnabledLayerNames = required_validation_layer_names;
@@ -133,7 +146,7 @@ b8 vulkan_renderer_backend_initialize(renderer_backend* backend, const char* app
     VK_CHECK(vkCreateInstance(&create_info, context.allocator, &context.instance));
 
 #if defined(_DEBUG)
-    DDEBUG("Creating vulkan debugger...");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Creating vulkan debugger...");
     u32 log_severity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT |
                        VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT |
                        VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT;
@@ -147,54 +160,62 @@ b8 vulkan_renderer_backend_initialize(renderer_backend* backend, const char* app
     PFN_vkCreateDebugUtilsMessengerEXT func = (PFN_vkCreateDebugUtilsMessengerEXT)vkGetInstanceProcAddr(context.instance, "vkCreateDebugUtilsMessengerEXT");
     // NOTE: (2)Create vulkan debugger if in debugg mode
     VK_CHECK(func(context.instance, &debug_create_info, context.allocator, &context.debug_messenger));
-    DDEBUG("Vulkan debugger created.");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Vulkan debugger created.");
 #endif
 
     // NOTE: (3)Create surface
     // FIXME: destroy surface after vulkan_device_destroy
-    DDEBUG("Creating vulkan surface...");
-    if (!platform_create_vulkan_surface(&context)) {
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Creating vulkan surface...");
+    if(platform_is_headless())
+    {
+        if(!create_headless_surface(&context))
+        {
+            DERROR("Failed to create headless surface!");
+            return false;
+        }
+    }
+    else if (!platform_create_vulkan_surface(&context)) {
         DERROR("Failed to create platform surface!");
         return false;
     }
-    DDEBUG("Vulkan surface created.");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Vulkan surface created.");
 
 
     // NOTE: (4)Create device
-    DDEBUG("Creating vulkan device...");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Creating vulkan device...");
     if (!vulkan_device_create(&context)) {
         DERROR("Failed to create device!");
         return false;
     }
-    DDEBUG("Vulkan device created...");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Vulkan device created...");
 
     // NOTE: (5)Create swapchain
-    DDEBUG("Creating vulkan swapchain...");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Creating vulkan swapchain...");
     vulkan_swapchain_create(&context, context.framebuffer_width, context.framebuffer_height, &context.swapchain);
-    DDEBUG("Vulkan swapchain created...");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Vulkan swapchain created...");
 
     // NOTE: (6)Create Renderpass
-    DDEBUG("Creating vulan renderpass...");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Creating vulan renderpass...");
     vulkan_renderpass_create(&context, &context.main_renderpass,
     0,0,context.framebuffer_width,context.framebuffer_height,
     0.0f, 0.0f, 0.2f, 1.0f,
     1.0f,0);
-    DDEBUG("Vulkan renderpass created...");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Vulkan renderpass created...");
 
     // NOTE:(7)Create framebuffers
     // TODO: destroy these framebuffer in somewhere.
-    DDEBUG("Creating vulkan framebuffer...");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Creating vulkan framebuffer...");
     context.swapchain.framebuffers = darray_reserve(vulkan_framebuffer, context.swapchain.image_count);
     regenerate_framebuffers(backend, &context.swapchain, &context.main_renderpass);
-    DDEBUG("Vulkan framebuffer created...");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Vulkan framebuffer created...");
 
     // NOTE: (8)Create Command Buffers
-    DDEBUG("Creating vulkan command buffers...");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Creating vulkan command buffers...");
     create_command_buffers(backend);
-    DDEBUG("Vulkan command buffers created...");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Vulkan command buffers created...");
 
     // NOTE: (9)Create sync objects
-    DDEBUG("Creating vulkan sync objects...");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Creating vulkan sync objects...");
     context.image_available_semaphores = darray_reserve(VkSemaphore, context.swapchain.max_frames_in_flight);
     context.queue_complete_semaphores = darray_reserve(VkSemaphore, context.swapchain.max_frames_in_flight);
     context.in_flight_fences = darray_reserve(vulkan_fence, context.swapchain.max_frames_in_flight);
@@ -217,7 +238,7 @@ b8 vulkan_renderer_backend_initialize(renderer_backend* backend, const char* app
     {
         context.images_in_flight[i] = 0;
     }
-    DDEBUG("Vulkan sync objects created...");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Vulkan sync objects created...");
 
     // NOTE: (10) create vulkan object shader
     if(!vulkan_object_shader_create(&context, &context.object_shader))
@@ -225,11 +246,11 @@ b8 vulkan_renderer_backend_initialize(renderer_backend* backend, const char* app
         DERROR("Error loading built-in basic_lighting shader.");
         return false;
     }
-    DDEBUG("Vulkan object shader created(temporary)...");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Vulkan object shader created(temporary)...");
 
     // NOTE: (11) create buffer
     create_buffers(&context);
-    DDEBUG("Vulkan builtin object buffer created...");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Vulkan builtin object buffer created...");
 
     // TODO: temporary test code
     const u32 vert_count = 4;
@@ -255,7 +276,7 @@ b8 vulkan_renderer_backend_initialize(renderer_backend* backend, const char* app
     upload_data_range(&context, context.device.graphics_command_pool, 0, context.device.graphics_queue, &context.object_index_buffer, 0, sizeof(u32) * index_count, indices);
     // TODO: end temp code
 
-    DINFO("Vulkan renderer backend initialized successfully.");
+    DLOG_INFO(LOG_CATEGORY_VULKAN, "Vulkan renderer backend initialized successfully.");
     return true;
 }
 
@@ -264,16 +285,16 @@ void vulkan_renderer_backend_shutdown(renderer_backend* backend)
     vkDeviceWaitIdle(context.device.logical_device);
 
     // NOTE: (11)Destroy vulkan buffer
-    DDEBUG("Destroying builtin object buffer...");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Destroying builtin object buffer...");
     vulkan_buffer_destroy(&context, &context.object_vertex_buffer);
     vulkan_buffer_destroy(&context, &context.object_index_buffer);
 
     // NOTE: (10)Destroy vulkan object shader
-    DDEBUG("Destroying builtin object shader...");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Destroying builtin object shader...");
     vulkan_object_shader_destroy(&context, &context.object_shader);
 
     // NOTE: (9)Destroy Sync objects
-    DDEBUG("Destroying vulkan sync objects");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Destroying vulkan sync objects");
     for (u8 i = 0; i < context.swapchain.max_frames_in_flight; ++i) {
         if (context.image_available_semaphores[i]) {
             vkDestroySemaphore(
@@ -301,7 +322,7 @@ void vulkan_renderer_backend_shutdown(renderer_backend* backend)
     context.images_in_flight = 0;
 
     // NOTE: (8)Destroy Command Buffers
-    DDEBUG("Destroying command buffers...");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Destroying command buffers...");
     for(u32 i = 0; i < context.swapchain.image_count; i++)
     {
         if(context.graphics_command_buffers[i].handle)
@@ -314,7 +335,7 @@ void vulkan_renderer_backend_shutdown(renderer_backend* backend)
     context.graphics_command_buffers = 0;
 
     // NOTE: (7)Destroy the framebuffer
-    DDEBUG("Destroying vulkan framebuffer...");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Destroying vulkan framebuffer...");
     for(u32 i = 0; i < context.swapchain.image_count; i++)
     {
         vulkan_framebuffer_destroy(&context,&context.swapchain.framebuffers[i]);
@@ -322,20 +343,20 @@ void vulkan_renderer_backend_shutdown(renderer_backend* backend)
     darray_destroy(context.swapchain.framebuffers);
 
     // NOTE: (6)Destroy renderpass
-    DDEBUG("Destroying vulkan renderpass...");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Destroying vulkan renderpass...");
     vulkan_renderpass_destroy(&context, &context.main_renderpass);
 
     // NOTE: (5)Destroy swapchain and its depth image and view
-    DDEBUG("Destroying vulkan swapchain...");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Destroying vulkan swapchain...");
     vulkan_swapchain_destroy(&context, &context.swapchain);
 
     // Destroy in the opposite order of the creation
     // NOTE: (4)Destroying vulkan device
-    DDEBUG("Destroying vulkan device...");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Destroying vulkan device...");
     vulkan_device_destroy(&context);
 
     // NOTE: (3)Destroying vulkan surface;
-    DDEBUG("Destroying vulkan surface...");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Destroying vulkan surface...");
     if(context.surface)
     {
         vkDestroySurfaceKHR(context.instance, context.surface, context.allocator);
@@ -344,18 +365,18 @@ void vulkan_renderer_backend_shutdown(renderer_backend* backend)
 
 #if defined(_DEBUG)
     // NOTE: (2)Destroying vulkan debugger
-    DINFO("Destroying vulkan debugger...");
+    DLOG_INFO(LOG_CATEGORY_VULKAN, "Destroying vulkan debugger...");
     if(context.debug_messenger)
     {
         PFN_vkDestroyDebugUtilsMessengerEXT func = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(context.instance, "vkDestroyDebugUtilsMessengerEXT");
         func(context.instance, context.debug_messenger, context.allocator);
     }
-    DINFO("Done.");
+    DLOG_INFO(LOG_CATEGORY_VULKAN, "Done.");
 #endif
     // NOTE: (1)Destroying vulkan instance
-    DINFO("Destroying vulkan instance...");
+    DLOG_INFO(LOG_CATEGORY_VULKAN, "Destroying vulkan instance...");
     vkDestroyInstance(context.instance, context.allocator);
-    DINFO("Done.");
+    DLOG_INFO(LOG_CATEGORY_VULKAN, "Done.");
 }
 
 void vulkan_renderer_backend_resized(renderer_backend* backend, u16 width, u16 height)
@@ -364,7 +385,7 @@ void vulkan_renderer_backend_resized(renderer_backend* backend, u16 width, u16 h
     cached_framebuffer_height = height;
     context.framebuffer_size_generation++;
 
-    DINFO("Vulkan render backend resized: [width/height/generation: %i/%i/%llu]", width, height, context.framebuffer_size_generation);
+    DLOG_INFO(LOG_CATEGORY_VULKAN, "Vulkan render backend resized: [width/height/generation: %i/%i/%llu]", width, height, context.framebuffer_size_generation);
 
 }
 
@@ -381,7 +402,7 @@ b8 vulkan_renderer_backend_begin_frame(renderer_backend* backend, f32 delta_time
             DERROR("vulkan_renderer_backend_begin_frame vkDeviceWaitIdle (1) failed: '%s'", vulkan_result_string(result, true));
             return false;
         }
-        DINFO("Recreating swapchain, booting...");
+        DLOG_INFO(LOG_CATEGORY_VULKAN, "Recreating swapchain, booting...");
         return false;
     }
 
@@ -402,7 +423,7 @@ b8 vulkan_renderer_backend_begin_frame(renderer_backend* backend, f32 delta_time
             return false;
         }
 
-        DINFO("Resized, booting...");
+        DLOG_INFO(LOG_CATEGORY_VULKAN, "Resized, booting...");
         return false;
     }
 
@@ -411,7 +432,7 @@ b8 vulkan_renderer_backend_begin_frame(renderer_backend* backend, f32 delta_time
         &context.in_flight_fences[context.current_frame], 
         (uint64_t)0xffffffffffffffff))
     {
-        DWARN("In-flaght fence wait failure.");
+        DLOG_WARN(LOG_CATEGORY_VULKAN, "In-flaght fence wait failure.");
         return false;
     }
 
@@ -525,26 +546,29 @@ VKAPI_ATTR VkBool32 vk_debug_callback(
     const VkDebugUtilsMessengerCallbackDataEXT*      pCallbackData,
     void*                                            pUserData)
 {
+    // A single bad state can repeat the same message thousands of times per frame,
+    // so identical messages are rate limited and summarized. The key is only hashed
+    // once the message's category and level are known to be enabled.
     switch(messageSeverity)
     {
         case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT:
         {
-            DERROR(pCallbackData->pMessage);
+            DLOG_LIMITED_KEY(LOG_CATEGORY_VULKAN, LOG_LEVEL_ERROR, log_hash_string(pCallbackData->pMessage), VULKAN_DEBUG_MESSAGE_BUDGET, "%s", pCallbackData->pMessage);
             break;
         }
         case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT:
         {
-            DWARN(pCallbackData->pMessage);
+            DLOG_LIMITED_KEY(LOG_CATEGORY_VULKAN, LOG_LEVEL_WARN, log_hash_string(pCallbackData->pMessage), VULKAN_DEBUG_MESSAGE_BUDGET, "%s", pCallbackData->pMessage);
             break;
         }
         case VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT:
         {
-            DINFO(pCallbackData->pMessage);
+            DLOG_LIMITED_KEY(LOG_CATEGORY_VULKAN, LOG_LEVEL_INFO, log_hash_string(pCallbackData->pMessage), VULKAN_DEBUG_MESSAGE_BUDGET, "%s", pCallbackData->pMessage);
             break;
         }
         case VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT:
         {
-            DTRACE(pCallbackData->pMessage);
+            DLOG_LIMITED_KEY(LOG_CATEGORY_VULKAN, LOG_LEVEL_TRACE, log_hash_string(pCallbackData->pMessage), VULKAN_DEBUG_MESSAGE_BUDGET, "%s", pCallbackData->pMessage);
             break;
         }
         default:
@@ -570,7 +594,7 @@ i32 find_memory_index(u32 type_filter, u32 property_flags)
         }
     }
 
-    DWARN("Unable to find suitable memory type!");
+    DLOG_WARN(LOG_CATEGORY_VULKAN, "Unable to find suitable memory type!");
     return -1;
 }
 
@@ -620,13 +644,13 @@ b8 recreate_swapchain(renderer_backend* backend)
 {
     if(context.recreating_swapchain)
     {
-        DDEBUG("recreate_swapchain called when already recreating. Booting.");
+        DLOG_DEBUG(LOG_CATEGORY_VULKAN, "recreate_swapchain called when already recreating. Booting.");
         return false;
     }
 
     if(context.framebuffer_width == 0 || context.framebuffer_height == 0)
     {
-        DDEBUG("recreate_swapchain called when window is < 1 in a dimension. Booting.");
+        DLOG_DEBUG(LOG_CATEGORY_VULKAN, "recreate_swapchain called when window is < 1 in a dimension. Booting.");
         return false;
     }
 
@@ -709,5 +733,25 @@ b8 create_buffers(vulkan_context* context)
     }
     context->geometry_index_offset = 0;
 
+    return true;
+}
+
+static b8 create_headless_surface(vulkan_context* context)
+{
+    PFN_vkCreateHeadlessSurfaceEXT func =
+        (PFN_vkCreateHeadlessSurfaceEXT)vkGetInstanceProcAddr(context->instance, "vkCreateHeadlessSurfaceEXT");
+    if(!func)
+    {
+        DLOG_ERROR(LOG_CATEGORY_VULKAN, "VK_EXT_headless_surface is not supported by this driver.");
+        return false;
+    }
+
+    VkHeadlessSurfaceCreateInfoEXT create_info = {VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT};
+    VkResult result = func(context->instance, &create_info, context->allocator, &context->surface);
+    if(result != VK_SUCCESS)
+    {
+        DLOG_ERROR(LOG_CATEGORY_VULKAN, "Headless surface creation failed.");
+        return false;
+    }
     return true;
 }
\ No newline at end of file
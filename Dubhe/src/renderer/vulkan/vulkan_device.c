@@ -72,7 +72,7 @@ b8 physical_device_meets_requirements(VkPhysicalDevice physical_device,
     // Discrete GPU?
     if (requirements->discrete_gpu) {
         if (properties->deviceType != VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) {
-            DINFO("Device is not a discrete GPU, and one is required. Skipping.");
+            DLOG_INFO(LOG_CATEGORY_VULKAN, "Device is not a discrete GPU, and one is required. Skipping.");
             return false;
         }
     }
@@ -83,7 +83,7 @@ b8 physical_device_meets_requirements(VkPhysicalDevice physical_device,
     vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, queue_families);
 
     // Look at each queue and see what queues it supports
-    DINFO("Graphics | Present | Compute | Transfer | Name");
+    DLOG_INFO(LOG_CATEGORY_VULKAN, "Graphics | Present | Compute | Transfer | Name");
     u8 min_transfer_score = 255;
     for(u32 i = 0; i < queue_family_count; i++)
     {
@@ -119,7 +119,7 @@ b8 physical_device_meets_requirements(VkPhysicalDevice physical_device,
         }
     }
 
-    DINFO("       %d |       %d |       %d |        %d | %s", 
+    DLOG_INFO(LOG_CATEGORY_VULKAN, "       %d |       %d |       %d |        %d | %s", 
     out_queue_info->graphics_family_index != -1, 
     out_queue_info->present_family_index != -1, 
     out_queue_info->compute_family_index != -1, 
@@ -132,11 +132,11 @@ b8 physical_device_meets_requirements(VkPhysicalDevice physical_device,
         (!requirements->transfer || (requirements->transfer && out_queue_info->transfer_family_index != -1)) )
     {
         // 如果找到了我们所需要的队列
-        DINFO("Device meets queue requirements.");
-        DTRACE("Graphics Family Index: %i", out_queue_info->graphics_family_index);
-        DTRACE("Present Family Index:  %i", out_queue_info->present_family_index);
-        DTRACE("Transfer Family Index: %i", out_queue_info->transfer_family_index);
-        DTRACE("Compute Family Index:  %i", out_queue_info->compute_family_index);
+        DLOG_INFO(LOG_CATEGORY_VULKAN, "Device meets queue requirements.");
+        DLOG_TRACE(LOG_CATEGORY_VULKAN, "Graphics Family Index: %i", out_queue_info->graphics_family_index);
+        DLOG_TRACE(LOG_CATEGORY_VULKAN, "Present Family Index:  %i", out_queue_info->present_family_index);
+        DLOG_TRACE(LOG_CATEGORY_VULKAN, "Transfer Family Index: %i", out_queue_info->transfer_family_index);
+        DLOG_TRACE(LOG_CATEGORY_VULKAN, "Compute Family Index:  %i", out_queue_info->compute_family_index);
 
         // Query swapchain support.
         vulkan_device_query_swapchain_support(
@@ -154,7 +154,7 @@ b8 physical_device_meets_requirements(VkPhysicalDevice physical_device,
             {
                 dfree(out_swapchain_support->present_modes, sizeof(VkPresentModeKHR) * out_swapchain_support->present_mode_count, MEMORY_TAG_RENDERER);
             }
-            DINFO("Required swapchain support not present, skipping device.");
+            DLOG_INFO(LOG_CATEGORY_VULKAN, "Required swapchain support not present, skipping device.");
             return false;
         }
 
@@ -201,7 +201,7 @@ b8 physical_device_meets_requirements(VkPhysicalDevice physical_device,
         // Check sampler anisotropy
         if(requirements->sampler_anisotropy && !features->samplerAnisotropy)
         {
-            DINFO("Device does not support samplerAnisotropy, skipping.");
+            DLOG_INFO(LOG_CATEGORY_VULKAN, "Device does not support samplerAnisotropy, skipping.");
             return false;
         }
 
@@ -258,43 +258,43 @@ b8 select_physical_device(vulkan_context* context)
         // Only if this deivce meets requirements
         if(result)
         {
-            DINFO("Selected device: %s", properties.deviceName);
+            DLOG_INFO(LOG_CATEGORY_VULKAN, "Selected device: %s", properties.deviceName);
             switch(properties.deviceType)
             {
                 default:
                 case VK_PHYSICAL_DEVICE_TYPE_OTHER:
                 {
-                    DINFO("GPU type is Unknown.");
+                    DLOG_INFO(LOG_CATEGORY_VULKAN, "GPU type is Unknown.");
                     break;
                 }
                 case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
                 {
-                    DINFO("GPU type is Intergrated.");
+                    DLOG_INFO(LOG_CATEGORY_VULKAN, "GPU type is Intergrated.");
                     break;
                 }
                 case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
                 {
-                    DINFO("GPU type is Discrete.");
+                    DLOG_INFO(LOG_CATEGORY_VULKAN, "GPU type is Discrete.");
                     break;
                 }
                 case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
                 {
-                    DINFO("GPU type is Virtual.");
+                    DLOG_INFO(LOG_CATEGORY_VULKAN, "GPU type is Virtual.");
                     break;
                 }
                 case VK_PHYSICAL_DEVICE_TYPE_CPU:
                 {
-                    DINFO("GPU type is CPU.");
+                    DLOG_INFO(LOG_CATEGORY_VULKAN, "GPU type is CPU.");
                     break;
                 }
             }
 
-            DINFO("GPU Driver version: %d.%d.%d",
+            DLOG_INFO(LOG_CATEGORY_VULKAN, "GPU Driver version: %d.%d.%d",
             VK_VERSION_MAJOR(properties.driverVersion),
             VK_VERSION_MINOR(properties.driverVersion),
             VK_VERSION_PATCH(properties.driverVersion));
 
-            DINFO("Vulkan API version: %d.%d.%d",
+            DLOG_INFO(LOG_CATEGORY_VULKAN, "Vulkan API version: %d.%d.%d",
             VK_VERSION_MAJOR(properties.apiVersion),
             VK_VERSION_MINOR(properties.apiVersion),
             VK_VERSION_PATCH(properties.apiVersion));
@@ -305,11 +305,11 @@ b8 select_physical_device(vulkan_context* context)
                 f32 memory_size_gib = (((f32)memory.memoryHeaps[j].size) / 1024.0f / 1024.0f / 1024.0f);
                 if(memory.memoryHeaps[j].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
                 {
-                    DINFO("Local GPU memory: %.2f GiB", memory_size_gib);
+                    DLOG_INFO(LOG_CATEGORY_VULKAN, "Local GPU memory: %.2f GiB", memory_size_gib);
                 }
                 else
                 {
-                    DINFO("Shared GPU memory: %.2f GiB", memory_size_gib);
+                    DLOG_INFO(LOG_CATEGORY_VULKAN, "Shared GPU memory: %.2f GiB", memory_size_gib);
                 }
             }
 
@@ -331,7 +331,7 @@ b8 select_physical_device(vulkan_context* context)
         return false;
     }
 
-    DINFO("Physical device selected.");
+    DLOG_INFO(LOG_CATEGORY_VULKAN, "Physical device selected.");
     return true;
 }
 
@@ -344,7 +344,7 @@ b8 vulkan_device_create(vulkan_context* context)
     }
 
     // Creating logical device
-    DINFO("Creating logical device...");
+    DLOG_INFO(LOG_CATEGORY_VULKAN, "Creating logical device...");
     // NOTE: Do not create additional queues for shared indices.
     b8 present_shared_graphics_queue = context->device.graphics_queue_index == context->device.present_queue_index;
     b8 transfer_shared_graphics_queue = context->device.graphics_queue_index == context->device.transfer_queue_index;
@@ -410,7 +410,7 @@ b8 vulkan_device_create(vulkan_context* context)
         context->allocator,
         &context->device.logical_device
     ));
-    DINFO("Logical device created.");
+    DLOG_INFO(LOG_CATEGORY_VULKAN, "Logical device created.");
 
     // Get queues
     vkGetDeviceQueue(
@@ -431,14 +431,14 @@ b8 vulkan_device_create(vulkan_context* context)
         0,
         &context->device.transfer_queue
     );
-    DINFO("Queues obtained.");
+    DLOG_INFO(LOG_CATEGORY_VULKAN, "Queues obtained.");
 
     // Create the command pool
     VkCommandPoolCreateInfo pool_create_info = {VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
     pool_create_info.queueFamilyIndex = context->device.graphics_queue_index;
     pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
     VK_CHECK( vkCreateCommandPool(context->device.logical_device, &pool_create_info, context->allocator, &context->device.graphics_command_pool) );
-    DINFO("Graphics command pool created.");
+    DLOG_INFO(LOG_CATEGORY_VULKAN, "Graphics command pool created.");
 
     return true;
 }
@@ -446,7 +446,7 @@ b8 vulkan_device_create(vulkan_context* context)
 void vulkan_device_destroy(vulkan_context* context)
 {
     //Destroy command pool
-    DDEBUG("Destroying command pool...");
+    DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Destroying command pool...");
     vkDestroyCommandPool(context->device.logical_device, context->device.graphics_command_pool, context->allocator);
 
     //Unset queues
@@ -455,7 +455,7 @@ void vulkan_device_destroy(vulkan_context* context)
     context->device.transfer_queue = 0;
 
     // Destroy logical device   
-    DINFO("Destroying logical device...");
+    DLOG_INFO(LOG_CATEGORY_VULKAN, "Destroying logical device...");
     if(context->device.logical_device)
     {
         vkDestroyDevice(context->device.logical_device,
@@ -463,7 +463,7 @@ void vulkan_device_destroy(vulkan_context* context)
         context->device.logical_device = 0;
     }
  
-    DINFO("Releasing physical device resources...");
+    DLOG_INFO(LOG_CATEGORY_VULKAN, "Releasing physical device resources...");
     context->device.physical_device = 0;
     if(context->device.swapchain_support.formats)
     {
@@ -39,7 +39,7 @@ b8 vulkan_fence_wait(vulkan_context* context, vulkan_fence* fence, u64 timeout_n
                 fence->is_signaled = true;
                 return true;
             case VK_TIMEOUT:
-                DWARN("vk_fence_wait - Timed out");
+                DLOG_WARN(LOG_CATEGORY_VULKAN, "vk_fence_wait - Timed out");
                 break;
             case VK_ERROR_DEVICE_LOST:
                 DERROR("vk_fence_wait - VK_ERROR_DEVICE_LOST.");
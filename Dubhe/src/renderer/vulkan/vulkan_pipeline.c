@@ -154,7 +154,7 @@ b8 vulkan_graphics_pipeline_create(
     
     if(vulkan_result_is_success(result))
     {
-        DDEBUG("Graphics pipeline created!");
+        DLOG_DEBUG(LOG_CATEGORY_VULKAN, "Graphics pipeline created!");
         return true;
     }
 
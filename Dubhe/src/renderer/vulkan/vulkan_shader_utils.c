@@ -30,27 +30,17 @@ b8 create_shader_module(
     dzero_memory(&shader_stages[stage_index].create_info, sizeof(VkShaderModuleCreateInfo));
     shader_stages[stage_index].create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
 
-    // Obtain file handle.
-    file_handle handle;
-    if(!filesystem_open(file_name, FILE_MODE_READ, true, &handle))
+    // Map the file rather than reading it, so the SPIR-V goes from the page cache to the driver
+    // with no copy of our own. Views are page aligned, as pCode requires.
+    file_mapping mapping;
+    if(!filesystem_map(file_name, FILE_ACCESS_SEQUENTIAL, &mapping) || mapping.size == 0)
     {
         DERROR("Unable to read shader module: %s.", file_name);
+        filesystem_unmap(&mapping);
         return false;
     }
-
-    // Read the entire file as binary.
-    u64 size = 0;
-    u8* file_buffer = 0;
-    if (!filesystem_read_all_bytes(&handle, &file_buffer, &size)) 
-    {
-        DERROR("Unable to binary read shader module: %s.", file_name);
-        return false;
-    }
-    shader_stages[stage_index].create_info.codeSize = size;
-    shader_stages[stage_index].create_info.pCode = (u32*)file_buffer;
-
-    // Close the file
-    filesystem_close(&handle);
+    shader_stages[stage_index].create_info.codeSize = mapping.size;
+    shader_stages[stage_index].create_info.pCode = (const u32*)mapping.data;
 
     VK_CHECK(vkCreateShaderModule(
         context->device.logical_device, 
@@ -58,17 +48,15 @@ b8 create_shader_module(
         context->allocator, 
         &shader_stages[stage_index].handle));
 
+    // The driver has its own copy of the code now.
+    filesystem_unmap(&mapping);
+    shader_stages[stage_index].create_info.pCode = 0;
+
     dzero_memory(&shader_stages[stage_index].shader_stage_create_info, sizeof(VkPipelineShaderStageCreateInfo));
     shader_stages[stage_index].shader_stage_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     shader_stages[stage_index].shader_stage_create_info.stage = shader_stage_flag;
     shader_stages[stage_index].shader_stage_create_info.module = shader_stages[stage_index].handle;
     shader_stages[stage_index].shader_stage_create_info.pName = "main";
 
-    if(file_buffer)
-    {
-        dfree(file_buffer, size, MEMORY_TAG_STRING);
-        file_buffer = 0;
-    }
-
     return true;
 }
\ No newline at end of file
@@ -243,7 +243,7 @@ void internal_create(vulkan_context* context, u32 width, u32 height, vulkan_swap
                         VK_IMAGE_ASPECT_DEPTH_BIT,
                         &out_vulkan_swapchain->depth_attachment);
     
-    DINFO("Swapchain created successfully.");
+    DLOG_INFO(LOG_CATEGORY_VULKAN, "Swapchain created successfully.");
 }
 
 void internal_destroy(vulkan_context* context, vulkan_swapchain* swapchain)
@@ -6,7 +6,7 @@ ASSEMBLY := Dubhe
 EXTENSION := .dll
 COMPILER_FLAGS := -g -Wno-vla -fdeclspec #-fPIC -Werror=vla
 INCLUDE_FLAGS := -IDubhe\src -I$(VULKAN_SDK)\include
-LINKER_FLAGS := -g -shared -luser32 -lvulkan-1 -L$(VULKAN_SDK)\Lib -L$(OBJ_DIR)\Dubhe
+LINKER_FLAGS := -g -shared -luser32 -lwinmm -lvulkan-1 -L$(VULKAN_SDK)\Lib -L$(OBJ_DIR)\Dubhe
 DEFINES := -D_DEBUG -DDEXPORT -D_CRT_SECURE_NO_WARNINGS
 
 # 给定目录和指定文件模式匹配符，递归搜索目录
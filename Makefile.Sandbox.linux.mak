@@ -0,0 +1,41 @@
+BUILD_DIR := output/bin
+OBJ_DIR := output/obj
+
+ASSEMBLY := Sandbox
+EXTENSION := 
+COMPILER_FLAGS := -g -MD -Wno-vla -Wno-missing-braces -fdeclspec -fPIC #-Werror=vla
+INCLUDE_FLAGS := -IDubhe/src -ISandbox/src
+LINKER_FLAGS := -g -lDubhe -L$(BUILD_DIR) -Wl,-rpath,.
+DEFINES := -D_DEBUG -DDIMPORT
+
+SRC_FILES := $(shell find $(ASSEMBLY) -name '*.c') # Get all .c files
+DIRECTORIES := $(shell find $(ASSEMBLY) -type d) # Get all directories under src.
+OBJ_FILES := $(SRC_FILES:%=$(OBJ_DIR)/%.o) # Get all compiled .c.o objects for Sandbox
+
+all: scaffold compile link
+
+.PHONY: scaffold
+scaffold: # create build directory
+	@echo Scaffolding folder structure...
+	@mkdir -p $(addprefix $(OBJ_DIR)/,$(DIRECTORIES))
+	@echo Done.
+
+.PHONY: link
+link: scaffold $(OBJ_FILES) # link
+	@echo Linking $(ASSEMBLY)...
+	@clang $(OBJ_FILES) -o $(BUILD_DIR)/$(ASSEMBLY)$(EXTENSION) $(LINKER_FLAGS)
+
+.PHONY: compile
+compile: #compile .c files
+	@echo Compiling...
+
+.PHONY: clean
+clean: # clean build directory
+	rm -rf $(BUILD_DIR)/$(ASSEMBLY)
+	rm -rf $(OBJ_DIR)/$(ASSEMBLY)
+
+$(OBJ_DIR)/%.c.o: %.c # compile .c to .c.o object
+	@echo   $<...
+	@clang $< $(COMPILER_FLAGS) -c -o $@ $(DEFINES) $(INCLUDE_FLAGS)
+
+-include $(OBJ_FILES:.o=.d)
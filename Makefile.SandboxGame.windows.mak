@@ -0,0 +1,42 @@
+BUILD_DIR := output\bin
+OBJ_DIR := output\obj
+
+# The Sandbox app callbacks as a hot-reloadable library; run Sandbox with
+# DUBHE_GAME_LIBRARY=SandboxGame.dll and rebuild this while it runs.
+ASSEMBLY := SandboxGame
+EXTENSION := .dll
+COMPILER_FLAGS := -g -MD -Wno-vla -Wno-missing-braces -fdeclspec #-fPIC -Werror=vla
+INCLUDE_FLAGS := -IDubhe\src -ISandbox\src
+LINKER_FLAGS := -g -shared -lDubhe -L$(BUILD_DIR)
+DEFINES := -D_DEBUG -DDIMPORT -DSANDBOX_GAME_EXPORT
+
+SRC_FILES := Sandbox/src/app.c
+OBJ_FILES := $(SRC_FILES:%=$(OBJ_DIR)/$(ASSEMBLY)/%.o) # Kept apart from Sandbox's objects of the same files
+
+all: scaffold compile link
+
+.PHONY: scaffold
+scaffold: # create build directory
+	@echo Scaffolding folder structure...
+	-@setlocal enableextensions enabledelayedexpansion && mkdir $(OBJ_DIR)\$(ASSEMBLY)\Sandbox\src 2>NUL || cd .
+	@echo Done.
+
+.PHONY: link
+link: scaffold $(OBJ_FILES) # link
+	@echo Linking $(ASSEMBLY)...
+	@clang $(OBJ_FILES) -o $(BUILD_DIR)/$(ASSEMBLY)$(EXTENSION) $(LINKER_FLAGS)
+
+.PHONY: compile
+compile: #compile .c files
+	@echo Compiling...
+
+.PHONY: clean
+clean: # clean build directory
+	if exist $(BUILD_DIR)\$(ASSEMBLY)$(EXTENSION) del $(BUILD_DIR)\$(ASSEMBLY)$(EXTENSION)
+	rmdir /s /q $(OBJ_DIR)\$(ASSEMBLY)
+
+$(OBJ_DIR)/$(ASSEMBLY)/%.c.o: %.c # compile .c to .c.o object
+	@echo   $<...
+	@clang $< $(COMPILER_FLAGS) -c -o $@ $(DEFINES) $(INCLUDE_FLAGS)
+
+-include $(OBJ_FILES:.o=.d)
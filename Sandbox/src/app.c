@@ -5,18 +5,18 @@
 
 b8 app_initialize(app* app_instance)
 {
-    DDEBUG("app_initialize called");
+    DLOG_DEBUG(LOG_CATEGORY_APP, "app_initialize called");
     return true;
 }
 
 b8 app_update(app* app_instance, f32 delta_time)
 {
-    static u64 alloc_count = 0;
-    u64 prev_alloc_count = alloc_count;
-    alloc_count = get_memory_alloc_count();
+    app_state* state = app_instance->state;
+    u64 prev_alloc_count = state->alloc_count;
+    state->alloc_count = get_memory_alloc_count();
     if (input_is_key_up('M') && input_was_key_down('M')) 
     {
-        DDEBUG("Allocations: %llu (%llu this frame)", alloc_count, alloc_count - prev_alloc_count);
+        DLOG_DEBUG(LOG_CATEGORY_APP, "Allocations: %llu (%llu this frame)", state->alloc_count, state->alloc_count - prev_alloc_count);
     } 
     return true;
 }
@@ -3,15 +3,30 @@
 #include <defines.h>
 #include <app_types.h>
 
+// Built into the SandboxGame library, the callbacks are exported for the engine to look up
+// (see core/game_module.h).
+#ifdef SANDBOX_GAME_EXPORT
+#ifdef _MSC_VER
+#define SANDBOX_API __declspec(dllexport)
+#else
+#define SANDBOX_API __attribute__((visibility("default")))
+#endif
+#else
+#define SANDBOX_API
+#endif
+
+// Allocated by create_app, so it survives reloads of the game library. Keep the layout the
+// same across a reload.
 typedef struct app_state{
     f32 delta_time;
+    u64 alloc_count;
 }app_state;
 
 
-b8 app_initialize(app* app_instance);
+SANDBOX_API b8 app_initialize(app* app_instance);
 
-b8 app_update(app* app_instance, f32 delta_time);
+SANDBOX_API b8 app_update(app* app_instance, f32 delta_time);
 
-b8 app_render(app* app_instance, f32 delta_time);
+SANDBOX_API b8 app_render(app* app_instance, f32 delta_time);
 
-void app_on_resize(app* app_instance, u32 width, u32 height);
\ No newline at end of file
+SANDBOX_API void app_on_resize(app* app_instance, u32 width, u32 height);
\ No newline at end of file
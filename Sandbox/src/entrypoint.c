@@ -6,6 +6,8 @@
 
 #include "app.h"
 
+#include <stdlib.h>
+
 b8 create_app(app* out_app)
 {
     out_app->application_state = 0;
@@ -14,6 +16,22 @@ b8 create_app(app* out_app)
     out_app->app_config.start_pos_y = 100;
     out_app->app_config.start_width = 1280;
     out_app->app_config.start_height = 720;
+    out_app->app_config.target_frame_rate = 60.0f;
+    out_app->app_config.job_thread_count = 0;
+    out_app->app_config.use_fiber_scheduler = false;
+
+    // Input capture and replay for repeatable benchmark runs.
+    out_app->app_config.input_record_path = getenv("DUBHE_INPUT_RECORD");
+    out_app->app_config.input_replay_path = getenv("DUBHE_INPUT_REPLAY");
+    out_app->app_config.replay_delta_time = 1.0f / 60.0f;
+
+    // No window, e.g. for CI perf runs on machines without a display.
+    const char* headless = getenv("DUBHE_HEADLESS");
+    out_app->app_config.headless = headless && headless[0] != '0';
+
+    // Load the callbacks below from the SandboxGame library instead, reloading it whenever it's
+    // rebuilt; e.g. DUBHE_GAME_LIBRARY=./libSandboxGame.so.
+    out_app->app_config.game_library_path = getenv("DUBHE_GAME_LIBRARY");
 
     out_app->initialize = app_initialize;
     out_app->update = app_update;
@@ -21,6 +39,7 @@ b8 create_app(app* out_app)
     out_app->on_resize = app_on_resize;
 
     out_app->state = dallocate(sizeof(app_state), MEMORY_TAG_GAME);
+    dzero_memory(out_app->state, sizeof(app_state));
 
     return true;
 }
\ No newline at end of file
@@ -0,0 +1,40 @@
+#!/bin/bash
+# Build All
+
+set echo on
+
+echo "Building everything..."
+
+# Dubhe
+make -f Makefile.Dubhe.linux.mak all
+ERRORLEVEL=$?
+if [ $ERRORLEVEL -ne 0 ]
+then
+echo "Error:"$ERRORLEVEL && exit
+fi
+
+# Sandbox
+make -f Makefile.Sandbox.linux.mak all
+ERRORLEVEL=$?
+if [ $ERRORLEVEL -ne 0 ]
+then
+echo "Error:"$ERRORLEVEL && exit
+fi
+
+# SandboxGame
+make -f Makefile.SandboxGame.linux.mak all
+ERRORLEVEL=$?
+if [ $ERRORLEVEL -ne 0 ]
+then
+echo "Error:"$ERRORLEVEL && exit
+fi
+
+# Tests
+make -f Makefile.tests.linux.mak all
+ERRORLEVEL=$?
+if [ $ERRORLEVEL -ne 0 ]
+then
+echo "Error:"$ERRORLEVEL && exit
+fi
+
+echo "All assemblies built successfully."
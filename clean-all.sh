@@ -0,0 +1,40 @@
+#!/bin/bash
+# Clean Everything
+
+set echo on
+
+echo "Cleaning everything..."
+
+# Dubhe
+make -f Makefile.Dubhe.linux.mak clean
+ERRORLEVEL=$?
+if [ $ERRORLEVEL -ne 0 ]
+then
+echo "Error:"$ERRORLEVEL && exit
+fi
+
+# Sandbox
+make -f Makefile.Sandbox.linux.mak clean
+ERRORLEVEL=$?
+if [ $ERRORLEVEL -ne 0 ]
+then
+echo "Error:"$ERRORLEVEL && exit
+fi
+
+# SandboxGame
+make -f Makefile.SandboxGame.linux.mak clean
+ERRORLEVEL=$?
+if [ $ERRORLEVEL -ne 0 ]
+then
+echo "Error:"$ERRORLEVEL && exit
+fi
+
+# Tests
+make -f Makefile.tests.linux.mak clean
+ERRORLEVEL=$?
+if [ $ERRORLEVEL -ne 0 ]
+then
+echo "Error:"$ERRORLEVEL && exit
+fi
+
+echo "All assemblies cleaned successfully."
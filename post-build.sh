@@ -0,0 +1,26 @@
+#!/bin/bash
+
+# Run from root directory
+mkdir -p output/bin/assets/shaders
+
+echo "Compiling shaders..."
+
+echo "assets/shaders/Builtin.ObjectShader.vert.glsl -> output/bin/assets/shaders/Builtin.ObjectShader.vert.spv"
+$VULKAN_SDK/bin/glslc -fshader-stage=vert assets/shaders/Builtin.ObjectShader.vert.glsl -o output/bin/assets/shaders/Builtin.ObjectShader.vert.spv
+ERRORLEVEL=$?
+if [ $ERRORLEVEL -ne 0 ]
+then
+echo "Error:"$ERRORLEVEL && exit
+fi
+
+echo "assets/shaders/Builtin.ObjectShader.frag.glsl -> output/bin/assets/shaders/Builtin.ObjectShader.frag.spv"
+$VULKAN_SDK/bin/glslc -fshader-stage=frag assets/shaders/Builtin.ObjectShader.frag.glsl -o output/bin/assets/shaders/Builtin.ObjectShader.frag.spv
+ERRORLEVEL=$?
+if [ $ERRORLEVEL -ne 0 ]
+then
+echo "Error:"$ERRORLEVEL && exit
+fi
+
+echo "Copying assets..."
+echo cp -R "assets" "output/bin"
+cp -R "assets" "output/bin"
@@ -0,0 +1,180 @@
+#include "mpsc_queue_tests.h"
+
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <containers/mpsc_queue.h>
+#include <platform/thread.h>
+
+u8 mpsc_queue_should_create_and_destroy()
+{
+    mpsc_queue queue;
+    expect_to_be_true(mpsc_queue_create(5, sizeof(u64), &queue));
+
+    expect_should_not_be(0, queue.cells);
+    // Capacity is rounded up to a power of 2.
+    expect_should_be(8, queue.capacity);
+    expect_should_be(sizeof(u64), queue.stride);
+
+    mpsc_queue_destroy(&queue);
+
+    expect_should_be(0, queue.cells);
+    expect_should_be(0, queue.capacity);
+
+    return true;
+}
+
+u8 mpsc_queue_push_pop_in_order()
+{
+    u64 count = 8;
+    mpsc_queue queue;
+    mpsc_queue_create(count, sizeof(u64), &queue);
+
+    for(u64 i = 0; i < count; i++)
+    {
+        u64 value = i * 10;
+        expect_to_be_true(mpsc_queue_push(&queue, &value));
+    }
+    expect_should_be(count, mpsc_queue_claimed(&queue));
+
+    for(u64 i = 0; i < count; i++)
+    {
+        u64 value = 0;
+        expect_to_be_true(mpsc_queue_pop(&queue, &value));
+        expect_should_be(i * 10, value);
+    }
+    expect_should_be(count, mpsc_queue_consumed(&queue));
+
+    mpsc_queue_destroy(&queue);
+
+    return true;
+}
+
+u8 mpsc_queue_push_full_pop_empty()
+{
+    mpsc_queue queue;
+    mpsc_queue_create(4, sizeof(u32), &queue);
+
+    u32 value = 0;
+    expect_to_be_false(mpsc_queue_pop(&queue, &value));
+
+    for(u32 i = 0; i < 4; i++)
+    {
+        expect_to_be_true(mpsc_queue_push(&queue, &i));
+    }
+    expect_to_be_false(mpsc_queue_push(&queue, &value));
+
+    for(u32 i = 0; i < 4; i++)
+    {
+        expect_to_be_true(mpsc_queue_pop(&queue, &value));
+    }
+    expect_to_be_false(mpsc_queue_pop(&queue, &value));
+
+    mpsc_queue_destroy(&queue);
+
+    return true;
+}
+
+u8 mpsc_queue_wraps_around()
+{
+    mpsc_queue queue;
+    mpsc_queue_create(4, sizeof(u64), &queue);
+
+    // Several laps of the ring, keeping it partially filled.
+    u64 next_push = 0;
+    u64 next_pop = 0;
+    for(u32 lap = 0; lap < 10; lap++)
+    {
+        for(u32 i = 0; i < 3; i++)
+        {
+            expect_to_be_true(mpsc_queue_push(&queue, &next_push));
+            next_push++;
+        }
+        for(u32 i = 0; i < 3; i++)
+        {
+            u64 value = 0;
+            expect_to_be_true(mpsc_queue_pop(&queue, &value));
+            expect_should_be(next_pop, value);
+            next_pop++;
+        }
+    }
+
+    mpsc_queue_destroy(&queue);
+
+    return true;
+}
+
+#define MPSC_TEST_PRODUCERS 4
+#define MPSC_TEST_PUSHES 20000
+
+typedef struct mpsc_producer_data
+{
+    mpsc_queue* queue;
+    u64 producer;
+} mpsc_producer_data;
+
+static u32 push_sequence(void* params)
+{
+    mpsc_producer_data* data = params;
+    for(u64 i = 0; i < MPSC_TEST_PUSHES; i++)
+    {
+        // Producer index in the high bits, sequence number in the low bits.
+        u64 value = (data->producer << 32) | i;
+        while(!mpsc_queue_push(data->queue, &value))
+        {
+            platform_thread_yield();
+        }
+    }
+    return 0;
+}
+
+u8 mpsc_queue_multiple_producers()
+{
+    mpsc_queue queue;
+    mpsc_queue_create(256, sizeof(u64), &queue);
+
+    mpsc_producer_data data[MPSC_TEST_PRODUCERS];
+    platform_thread threads[MPSC_TEST_PRODUCERS];
+    for(u64 i = 0; i < MPSC_TEST_PRODUCERS; i++)
+    {
+        data[i].queue = &queue;
+        data[i].producer = i;
+        expect_to_be_true(platform_thread_create(push_sequence, &data[i], false, &threads[i]));
+    }
+
+    // Each producer's values must arrive complete and in that producer's order.
+    u64 next[MPSC_TEST_PRODUCERS] = {0};
+    u64 received = 0;
+    while(received < MPSC_TEST_PRODUCERS * MPSC_TEST_PUSHES)
+    {
+        u64 value;
+        if(!mpsc_queue_pop(&queue, &value))
+        {
+            platform_thread_yield();
+            continue;
+        }
+        u64 producer = value >> 32;
+        u64 sequence = value & 0xFFFFFFFF;
+        expect_to_be_true(producer < MPSC_TEST_PRODUCERS);
+        expect_should_be(next[producer], sequence);
+        next[producer]++;
+        received++;
+    }
+
+    for(u64 i = 0; i < MPSC_TEST_PRODUCERS; i++)
+    {
+        expect_to_be_true(platform_thread_join(&threads[i], 0));
+    }
+    mpsc_queue_destroy(&queue);
+
+    return true;
+}
+
+void mpsc_queue_register_tests()
+{
+    test_manager_register_test(mpsc_queue_should_create_and_destroy, "MPSC queue should create and destroy");
+    test_manager_register_test(mpsc_queue_push_pop_in_order, "MPSC queue push and pop in order");
+    test_manager_register_test(mpsc_queue_push_full_pop_empty, "MPSC queue push when full and pop when empty fail");
+    test_manager_register_test(mpsc_queue_wraps_around, "MPSC queue wraps around");
+    test_manager_register_test(mpsc_queue_multiple_producers, "MPSC queue keeps each producer's order across threads");
+}
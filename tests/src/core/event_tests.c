@@ -0,0 +1,395 @@
+#include "event_tests.h"
+
+#include "../test_manager.h"
+#include "../expect.h"
+#include "../test_system.h"
+
+#include <core/event.h>
+
+// Records the order in which listeners were invoked. Each listener points at its id.
+static u32 call_order[8];
+static u32 call_count;
+
+static b8 record_call(u16 code, void* sender, void* listener_inst, event_context data)
+{
+    call_order[call_count++] = *(u32*)listener_inst;
+    return false;
+}
+
+static b8 record_call_handled(u16 code, void* sender, void* listener_inst, event_context data)
+{
+    call_order[call_count++] = *(u32*)listener_inst;
+    return true;
+}
+
+// Unregisters itself, as one-shot listeners do.
+static b8 record_call_once(u16 code, void* sender, void* listener_inst, event_context data)
+{
+    call_order[call_count++] = *(u32*)listener_inst;
+    event_unregister(code, listener_inst, record_call_once);
+    return false;
+}
+
+// Unregisters the listener with the id before its own.
+static b8 record_call_unregister_previous(u16 code, void* sender, void* listener_inst, event_context data)
+{
+    call_order[call_count++] = *(u32*)listener_inst;
+    event_unregister(code, (u32*)listener_inst - 1, record_call);
+    return false;
+}
+
+static b8 initialize_event_system(u64* memory_requirement, void* state, void* config)
+{
+    event_system_initialize(memory_requirement, state);
+    call_count = 0;
+    return true;
+}
+
+static void shutdown_event_system(void* state)
+{
+    event_system_shutdown();
+}
+
+u8 event_should_fire_by_priority()
+{
+    test_system events;
+    expect_to_be_true(test_system_start(initialize_event_system, shutdown_event_system, 0, &events));
+    u32 ids[4] = {0, 1, 2, 3};
+    event_context data = {0};
+
+    expect_to_be_true(event_register_priority(100, &ids[0], record_call, 0));
+    expect_to_be_true(event_register_priority(100, &ids[1], record_call, 10));
+    expect_to_be_true(event_register_priority(100, &ids[2], record_call, -5));
+    // Same priority as ids[0]: runs after it.
+    expect_to_be_true(event_register(100, &ids[3], record_call));
+
+    event_fire(100, 0, data);
+    expect_should_be(4, call_count);
+    expect_should_be(1, call_order[0]);
+    expect_should_be(0, call_order[1]);
+    expect_should_be(3, call_order[2]);
+    expect_should_be(2, call_order[3]);
+
+    test_system_stop(&events);
+    return true;
+}
+
+u8 event_should_reject_duplicate_listener()
+{
+    test_system events;
+    expect_to_be_true(test_system_start(initialize_event_system, shutdown_event_system, 0, &events));
+    u32 id = 0;
+
+    expect_to_be_true(event_register(5, &id, record_call));
+    expect_to_be_false(event_register(5, &id, record_call));
+    // Same listener with a different callback is a separate registration.
+    expect_to_be_true(event_register(5, &id, record_call_handled));
+
+    test_system_stop(&events);
+    return true;
+}
+
+u8 event_should_keep_codes_separate()
+{
+    test_system events;
+    expect_to_be_true(test_system_start(initialize_event_system, shutdown_event_system, 0, &events));
+    u32 ids[3] = {0, 1, 2};
+    event_context data = {0};
+
+    // Register out of code order so spans have to shift.
+    event_register(30, &ids[0], record_call);
+    event_register(10, &ids[1], record_call);
+    event_register(20, &ids[2], record_call);
+    event_register(10, &ids[2], record_call);
+
+    event_fire(20, 0, data);
+    expect_should_be(1, call_count);
+    expect_should_be(2, call_order[0]);
+
+    call_count = 0;
+    event_fire(10, 0, data);
+    expect_should_be(2, call_count);
+    expect_should_be(1, call_order[0]);
+    expect_should_be(2, call_order[1]);
+
+    // Removing the only listener of a code removes the code; others are unaffected.
+    expect_to_be_true(event_unregister(20, &ids[2], record_call));
+    expect_to_be_false(event_unregister(20, &ids[2], record_call));
+    expect_to_be_false(event_fire(20, 0, data));
+
+    call_count = 0;
+    event_fire(30, 0, data);
+    expect_should_be(1, call_count);
+    expect_should_be(0, call_order[0]);
+
+    test_system_stop(&events);
+    return true;
+}
+
+u8 event_should_stop_when_handled()
+{
+    test_system events;
+    expect_to_be_true(test_system_start(initialize_event_system, shutdown_event_system, 0, &events));
+    u32 ids[2] = {0, 1};
+    event_context data = {0};
+
+    event_register_priority(7, &ids[0], record_call_handled, 1);
+    event_register_priority(7, &ids[1], record_call, 0);
+
+    expect_to_be_true(event_fire(7, 0, data));
+    expect_should_be(1, call_count);
+    expect_should_be(0, call_order[0]);
+
+    test_system_stop(&events);
+    return true;
+}
+
+// Records the data of each dispatched event.
+static event_context received[8];
+
+static b8 record_data(u16 code, void* sender, void* listener_inst, event_context data)
+{
+    received[call_count++] = data;
+    return false;
+}
+
+// Records the event, and posts a follow-up of its own code for the event carrying 1.
+static b8 record_data_and_post(u16 code, void* sender, void* listener_inst, event_context data)
+{
+    received[call_count++] = data;
+    if(data.data.u32[0] == 1)
+    {
+        event_context follow_up = {0};
+        follow_up.data.u32[0] = 100;
+        event_post(code, 0, follow_up);
+    }
+    return false;
+}
+
+u8 event_should_defer_posted_events_until_dispatch()
+{
+    test_system events;
+    expect_to_be_true(test_system_start(initialize_event_system, shutdown_event_system, 0, &events));
+    expect_to_be_true(event_register(101, 0, record_data_and_post));
+
+    event_context data = {0};
+    for(u32 i = 1; i <= 3; i++)
+    {
+        data.data.u32[0] = i;
+        expect_to_be_true(event_post(101, 0, data));
+    }
+    // Nothing runs until the dispatch.
+    expect_should_be(0, call_count);
+
+    event_dispatch_posted();
+    // In post order; the event posted during dispatch waits for the next one.
+    expect_should_be(3, call_count);
+    expect_should_be(1, received[0].data.u32[0]);
+    expect_should_be(2, received[1].data.u32[0]);
+    expect_should_be(3, received[2].data.u32[0]);
+
+    event_dispatch_posted();
+    expect_should_be(4, call_count);
+    expect_should_be(100, received[3].data.u32[0]);
+
+    // Nothing left over.
+    event_dispatch_posted();
+    expect_should_be(4, call_count);
+
+    test_system_stop(&events);
+    return true;
+}
+
+u8 event_should_coalesce_posted_events()
+{
+    test_system events;
+    expect_to_be_true(test_system_start(initialize_event_system, shutdown_event_system, 0, &events));
+    event_context data = {0};
+
+    event_register(EVENT_CODE_MOUSE_MOVE, 0, record_data);
+    event_register(EVENT_CODE_MOUSE_WHEEL, 0, record_data);
+    event_register(EVENT_CODE_KEY_PRESSED, 0, record_data);
+
+    for(u16 i = 1; i <= 3; i++)
+    {
+        data.data.u16[0] = i;
+        event_post(EVENT_CODE_MOUSE_MOVE, 0, data);
+        data.data.i8[0] = 1;
+        event_post(EVENT_CODE_MOUSE_WHEEL, 0, data);
+        data.data.u16[0] = i;
+        event_post(EVENT_CODE_KEY_PRESSED, 0, data);
+    }
+    event_dispatch_posted();
+
+    // One move (latest), one wheel (accumulated), all three key presses, in order of first post.
+    expect_should_be(5, call_count);
+    expect_should_be(3, received[0].data.u16[0]);
+    expect_should_be(3, received[1].data.i8[0]);
+    expect_should_be(1, received[2].data.u16[0]);
+    expect_should_be(2, received[3].data.u16[0]);
+    expect_should_be(3, received[4].data.u16[0]);
+
+    // Coalescing only applies within one dispatch.
+    call_count = 0;
+    data.data.u16[0] = 7;
+    event_post(EVENT_CODE_MOUSE_MOVE, 0, data);
+    event_dispatch_posted();
+    expect_should_be(1, call_count);
+    expect_should_be(7, received[0].data.u16[0]);
+
+    // Back to keeping every event.
+    call_count = 0;
+    expect_to_be_true(event_set_coalesce_policy(EVENT_CODE_MOUSE_MOVE, EVENT_COALESCE_KEEP_ALL, 0));
+    event_post(EVENT_CODE_MOUSE_MOVE, 0, data);
+    event_post(EVENT_CODE_MOUSE_MOVE, 0, data);
+    event_dispatch_posted();
+    expect_should_be(2, call_count);
+
+    test_system_stop(&events);
+    return true;
+}
+
+u8 event_should_profile_when_enabled()
+{
+    test_system events;
+    expect_to_be_true(test_system_start(initialize_event_system, shutdown_event_system, 0, &events));
+    u32 ids[2] = {0, 1};
+    event_context data = {0};
+    event_code_profile profile;
+
+    event_register(300, &ids[0], record_call);
+    event_register(300, &ids[1], record_call);
+
+    // Nothing is recorded while disabled.
+    event_fire(300, 0, data);
+    event_profile_frame_end();
+    expect_to_be_false(event_profile_get(300, &profile));
+
+    event_profiling_enable(true);
+    event_fire(300, 0, data);
+    event_fire(300, 0, data);
+    event_fire(301, 0, data);
+    // Samples only become visible once the frame ends.
+    expect_to_be_false(event_profile_get(300, &profile));
+    event_profile_frame_end();
+
+    expect_to_be_true(event_profile_get(300, &profile));
+    expect_should_be(2, profile.fire_count);
+    expect_should_be(4, profile.listener_count);
+    expect_to_be_true(profile.max_time <= profile.total_time);
+
+    u32 count = 0;
+    const event_code_profile* all = event_profile_get_all(&count);
+    expect_should_be(2, count);
+    expect_should_be(300, all[0].code);
+    expect_should_be(301, all[1].code);
+    expect_should_be(0, all[1].listener_count);
+
+    event_profiling_enable(false);
+    test_system_stop(&events);
+    return true;
+}
+
+static u64 payload_sum;
+
+static b8 sum_payload(u16 code, void* sender, void* listener_inst, event_context data)
+{
+    u64 size = 0;
+    const u32* values = event_context_payload(data, &size);
+    for(u64 i = 0; i < size / sizeof(u32); i++)
+    {
+        payload_sum += values[i];
+    }
+    call_count++;
+    return false;
+}
+
+u8 event_should_post_payloads()
+{
+    test_system events;
+    expect_to_be_true(test_system_start(initialize_event_system, shutdown_event_system, 0, &events));
+    u32 values[64];
+    for(u32 i = 0; i < 64; i++)
+    {
+        values[i] = i;
+    }
+
+    // Payload events are never coalesced, even for codes that are.
+    event_register(EVENT_CODE_MOUSE_MOVE, 0, sum_payload);
+
+    // Across several frames, so both arenas are switched and reset.
+    for(u32 frame = 0; frame < 4; frame++)
+    {
+        call_count = 0;
+        payload_sum = 0;
+        expect_to_be_true(event_post_payload(EVENT_CODE_MOUSE_MOVE, 0, values, sizeof(values)));
+        expect_to_be_true(event_post_payload(EVENT_CODE_MOUSE_MOVE, 0, values, 4 * sizeof(u32)));
+        event_dispatch_posted();
+        expect_should_be(2, call_count);
+        // 0 + ... + 63, then 0 + 1 + 2 + 3
+        expect_should_be(2016 + 6, payload_sum);
+    }
+
+    // Larger than an arena. The failed post takes no space, so smaller ones still fit.
+    expect_to_be_false(event_post_payload(EVENT_CODE_MOUSE_MOVE, 0, values, 2 * 1024 * 1024));
+    call_count = 0;
+    payload_sum = 0;
+    expect_to_be_true(event_post_payload(EVENT_CODE_MOUSE_MOVE, 0, values, sizeof(values)));
+    event_dispatch_posted();
+    expect_should_be(1, call_count);
+    expect_should_be(2016, payload_sum);
+
+    test_system_stop(&events);
+    return true;
+}
+
+u8 event_should_fire_every_listener_when_handlers_unregister()
+{
+    test_system events;
+    expect_to_be_true(test_system_start(initialize_event_system, shutdown_event_system, 0, &events));
+    u32 ids[4] = {0, 1, 2, 3};
+    event_context data = {0};
+
+    // A code registered before ours, so its span shifts too.
+    event_register(50, &ids[0], record_call);
+    event_register(100, &ids[0], record_call);
+    event_register(100, &ids[1], record_call_once);
+    event_register(100, &ids[2], record_call);
+    event_register(100, &ids[3], record_call);
+
+    event_fire(100, 0, data);
+    expect_should_be(4, call_count);
+    expect_should_be(0, call_order[0]);
+    expect_should_be(1, call_order[1]);
+    expect_should_be(2, call_order[2]);
+    expect_should_be(3, call_order[3]);
+
+    // The one-shot listener is gone; ids[2] now removes the listener before it.
+    event_unregister(100, &ids[2], record_call);
+    event_register_priority(100, &ids[1], record_call, 5);
+    event_register_priority(100, &ids[2], record_call_unregister_previous, 5);
+    event_unregister(50, &ids[0], record_call);
+    call_count = 0;
+    event_fire(100, 0, data);
+    expect_should_be(4, call_count);
+    expect_should_be(1, call_order[0]);
+    expect_should_be(2, call_order[1]);
+    expect_should_be(0, call_order[2]);
+    expect_should_be(3, call_order[3]);
+
+    test_system_stop(&events);
+    return true;
+}
+
+void event_register_tests()
+{
+    test_manager_register_test(event_should_fire_by_priority, "Event listeners fire by priority");
+    test_manager_register_test(event_should_reject_duplicate_listener, "Event rejects duplicate listener registration");
+    test_manager_register_test(event_should_keep_codes_separate, "Event codes keep separate listener spans");
+    test_manager_register_test(event_should_stop_when_handled, "Event fire stops when handled");
+    test_manager_register_test(event_should_fire_every_listener_when_handlers_unregister, "Event fire reaches every listener when handlers unregister");
+    test_manager_register_test(event_should_defer_posted_events_until_dispatch, "Event posts are deferred until dispatch and run in order");
+    test_manager_register_test(event_should_coalesce_posted_events, "Event coalesces posted events per code");
+    test_manager_register_test(event_should_profile_when_enabled, "Event profiling records per-code samples");
+    test_manager_register_test(event_should_post_payloads, "Event posts variable-size payloads");
+}
\ No newline at end of file
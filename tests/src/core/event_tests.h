@@ -0,0 +1,3 @@
+#include <defines.h>
+
+void event_register_tests();
\ No newline at end of file
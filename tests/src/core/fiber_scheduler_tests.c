@@ -0,0 +1,272 @@
+#include "fiber_scheduler_tests.h"
+
+#include "../test_manager.h"
+#include "../expect.h"
+#include "../test_system.h"
+
+#include <core/fiber_scheduler.h>
+#include <core/job_system.h>
+#include <platform/thread.h>
+#include <platform/atomic.h>
+
+#define FIBER_TEST_THREADS 2
+
+// config points at the fiber count.
+static b8 initialize_fiber_scheduler(u64* memory_requirement, void* state, void* config)
+{
+    return fiber_scheduler_initialize(memory_requirement, state, FIBER_TEST_THREADS, *(u32*)config);
+}
+
+static void increment(void* params)
+{
+    datomic_fetch_add_u32((u32*)params, 1, DATOMIC_RELAXED);
+}
+
+u8 fiber_scheduler_runs_every_task()
+{
+    test_system scheduler;
+    u32 fiber_count = 0;
+    expect_to_be_true(test_system_start(initialize_fiber_scheduler, fiber_scheduler_shutdown, &fiber_count, &scheduler));
+    expect_to_be_true(fiber_scheduler_running());
+
+    u32 total = 0;
+    fiber_task tasks[100];
+    for(u32 i = 0; i < 100; i++)
+    {
+        tasks[i].entry = increment;
+        tasks[i].params = &total;
+    }
+    fiber_counter counter = {0};
+    for(u32 i = 0; i < 10; i++)
+    {
+        expect_to_be_true(fiber_task_submit(tasks, 100, &counter));
+    }
+    // Blocks: the test thread is not a scheduler thread.
+    fiber_wait(&counter);
+
+    expect_should_be(0, counter.value);
+    expect_should_be(1000, total);
+
+    test_system_stop(&scheduler);
+    expect_to_be_false(fiber_scheduler_running());
+    return true;
+}
+
+typedef struct parent_test_data
+{
+    u32 children_done;
+    u32 parents_done;
+    // Set by each parent after its wait; must equal the children done by then.
+    u32 early_wakeups;
+} parent_test_data;
+
+static void child_task(void* params)
+{
+    parent_test_data* data = params;
+    datomic_fetch_add_u32(&data->children_done, 1, DATOMIC_RELAXED);
+}
+
+static void parent_task(void* params)
+{
+    parent_test_data* data = params;
+    fiber_task children[4];
+    for(u32 i = 0; i < 4; i++)
+    {
+        children[i].entry = child_task;
+        children[i].params = data;
+    }
+    fiber_counter counter = {0};
+    fiber_task_submit(children, 4, &counter);
+    fiber_wait(&counter);
+    if(counter.value != 0)
+    {
+        datomic_fetch_add_u32(&data->early_wakeups, 1, DATOMIC_RELAXED);
+    }
+    datomic_fetch_add_u32(&data->parents_done, 1, DATOMIC_RELAXED);
+}
+
+static u8 run_parents(u32 fiber_count, u32 parent_count)
+{
+    test_system scheduler;
+    expect_to_be_true(test_system_start(initialize_fiber_scheduler, fiber_scheduler_shutdown, &fiber_count, &scheduler));
+
+    parent_test_data data = {0};
+    fiber_task parent;
+    parent.entry = parent_task;
+    parent.params = &data;
+    fiber_counter counter = {0};
+    for(u32 i = 0; i < parent_count; i++)
+    {
+        expect_to_be_true(fiber_task_submit(&parent, 1, &counter));
+    }
+    fiber_wait(&counter);
+
+    expect_should_be(parent_count, data.parents_done);
+    expect_should_be(parent_count * 4, data.children_done);
+    expect_should_be(0, data.early_wakeups);
+
+    test_system_stop(&scheduler);
+    return true;
+}
+
+u8 fiber_scheduler_waiting_tasks_do_not_block_threads()
+{
+    // Far more waiting parents than threads: with blocking waits the children would never run.
+    return run_parents(0, 64);
+}
+
+u8 fiber_scheduler_survives_pool_exhaustion()
+{
+    // Raised to the smallest pool allowed; most parents find no fiber to switch to.
+    return run_parents(4, 32);
+}
+
+typedef struct nested_test_data
+{
+    u32 leaves_done;
+} nested_test_data;
+
+typedef struct nested_task_params
+{
+    nested_test_data* data;
+    u32 depth;
+} nested_task_params;
+
+// Submits two children one level down and waits for them; the deepest level counts itself.
+static void nested_task(void* params)
+{
+    nested_task_params* self = params;
+    if(self->depth == 0)
+    {
+        datomic_fetch_add_u32(&self->data->leaves_done, 1, DATOMIC_RELAXED);
+        return;
+    }
+
+    nested_task_params child_params[2];
+    fiber_task children[2];
+    for(u32 i = 0; i < 2; i++)
+    {
+        child_params[i].data = self->data;
+        child_params[i].depth = self->depth - 1;
+        children[i].entry = nested_task;
+        children[i].params = &child_params[i];
+    }
+    fiber_counter counter = {0};
+    fiber_task_submit(children, 2, &counter);
+    fiber_wait(&counter);
+}
+
+u8 fiber_scheduler_nested_waits_survive_pool_exhaustion()
+{
+    // Three levels of waits on the smallest pool: waits nested inside waiting tasks still have
+    // to resume the fibers their children woke.
+    u32 fiber_count = 4;
+    test_system scheduler;
+    expect_to_be_true(test_system_start(initialize_fiber_scheduler, fiber_scheduler_shutdown, &fiber_count, &scheduler));
+
+    nested_test_data data = {0};
+    nested_task_params root_params[16];
+    fiber_task roots[16];
+    for(u32 i = 0; i < 16; i++)
+    {
+        root_params[i].data = &data;
+        root_params[i].depth = 3;
+        roots[i].entry = nested_task;
+        roots[i].params = &root_params[i];
+    }
+    fiber_counter counter = {0};
+    expect_to_be_true(fiber_task_submit(roots, 16, &counter));
+    fiber_wait(&counter);
+    expect_should_be(16 * 8, data.leaves_done);
+
+    test_system_stop(&scheduler);
+    return true;
+}
+
+static b8 initialize_job_system(u64* memory_requirement, void* state, void* config)
+{
+    return job_system_initialize(memory_requirement, state, 2);
+}
+
+typedef struct main_thread_test_data
+{
+    u64 main_thread_id;
+    u32 tasks_off_main_thread;
+    u32 children_done;
+    b8 job_submitted;
+    u32 jobs_done;
+} main_thread_test_data;
+
+static void count_job(void* params)
+{
+    datomic_fetch_add_u32((u32*)params, 1, DATOMIC_RELAXED);
+}
+
+static void main_thread_task(void* params)
+{
+    main_thread_test_data* data = params;
+    if(platform_thread_current_id() != data->main_thread_id)
+    {
+        data->tasks_off_main_thread++;
+    }
+
+    fiber_task children[4];
+    for(u32 i = 0; i < 4; i++)
+    {
+        children[i].entry = count_job;
+        children[i].params = &data->children_done;
+    }
+    fiber_counter counter = {0};
+    fiber_task_submit(children, 4, &counter);
+    fiber_wait(&counter);
+
+    // Resumed on the main thread, so jobs can be submitted.
+    if(platform_thread_current_id() != data->main_thread_id)
+    {
+        data->tasks_off_main_thread++;
+    }
+    job_counter jobs = {0};
+    job_info job = {0};
+    job.entry = count_job;
+    job.params = &data->jobs_done;
+    job.counter = &jobs;
+    data->job_submitted = job_submit(&job);
+    job_wait(&jobs);
+}
+
+u8 fiber_scheduler_main_thread_task_can_submit_jobs()
+{
+    test_system jobs;
+    expect_to_be_true(test_system_start(initialize_job_system, job_system_shutdown, 0, &jobs));
+    test_system scheduler;
+    u32 fiber_count = 0;
+    expect_to_be_true(test_system_start(initialize_fiber_scheduler, fiber_scheduler_shutdown, &fiber_count, &scheduler));
+
+    main_thread_test_data data = {0};
+    data.main_thread_id = platform_thread_current_id();
+    fiber_task task;
+    task.entry = main_thread_task;
+    task.params = &data;
+    for(u32 i = 0; i < 10; i++)
+    {
+        fiber_task_run(&task);
+    }
+
+    expect_should_be(0, data.tasks_off_main_thread);
+    expect_should_be(40, data.children_done);
+    expect_to_be_true(data.job_submitted);
+    expect_should_be(10, data.jobs_done);
+
+    test_system_stop(&scheduler);
+    test_system_stop(&jobs);
+    return true;
+}
+
+void fiber_scheduler_register_tests()
+{
+    test_manager_register_test(fiber_scheduler_runs_every_task, "Fiber scheduler runs every submitted task");
+    test_manager_register_test(fiber_scheduler_waiting_tasks_do_not_block_threads, "Fiber scheduler parks waiting tasks instead of blocking threads");
+    test_manager_register_test(fiber_scheduler_survives_pool_exhaustion, "Fiber scheduler keeps going when the fiber pool is exhausted");
+    test_manager_register_test(fiber_scheduler_nested_waits_survive_pool_exhaustion, "Fiber scheduler resumes woken fibers from waits nested in waiting tasks");
+    test_manager_register_test(fiber_scheduler_main_thread_task_can_submit_jobs, "Fiber scheduler main thread task stays on the main thread and can submit jobs");
+}
\ No newline at end of file
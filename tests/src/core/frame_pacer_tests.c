@@ -0,0 +1,69 @@
+#include "frame_pacer_tests.h"
+
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <core/frame_pacer.h>
+#include <platform/platform.h>
+
+// 10ms frames.
+#define PACER_TEST_RATE 100.0f
+#define PACER_TEST_PERIOD 0.01
+
+u8 frame_pacer_holds_target_period()
+{
+    frame_pacer pacer;
+    frame_pacer_create(&pacer, PACER_TEST_RATE);
+
+    // The first wait starts the schedule.
+    expect_to_be_true(frame_pacer_wait(&pacer) == 0.0);
+    f64 start = platform_get_absolute_time();
+    for(u32 i = 0; i < 10; ++i)
+    {
+        frame_pacer_wait(&pacer);
+    }
+    f64 elapsed = platform_get_absolute_time() - start;
+
+    // Waits spin out to each deadline, so ten frames never end early; sleeping stops short
+    // of the deadline, so they shouldn't end much later either.
+    expect_to_be_true(elapsed >= 10 * PACER_TEST_PERIOD - 0.001);
+    expect_to_be_true(elapsed < 10 * PACER_TEST_PERIOD + 0.02);
+    expect_to_be_true(pacer.spin_margin >= 0.0005 && pacer.spin_margin <= 0.004);
+    return true;
+}
+
+u8 frame_pacer_restarts_after_long_overrun()
+{
+    frame_pacer pacer;
+    frame_pacer_create(&pacer, PACER_TEST_RATE);
+    frame_pacer_wait(&pacer);
+    frame_pacer_wait(&pacer);
+
+    // Overrun by more than three frames: no wait, and no frames run back to back to catch up.
+    platform_sleep(35);
+    expect_to_be_true(frame_pacer_wait(&pacer) == 0.0);
+    f64 start = platform_get_absolute_time();
+    f64 waited = frame_pacer_wait(&pacer);
+    f64 elapsed = platform_get_absolute_time() - start;
+    expect_to_be_true(waited > 0.0);
+    expect_to_be_true(elapsed >= PACER_TEST_PERIOD - 0.001);
+    return true;
+}
+
+u8 frame_pacer_unpaced_does_not_wait()
+{
+    frame_pacer pacer;
+    frame_pacer_create(&pacer, 0.0f);
+    for(u32 i = 0; i < 10; ++i)
+    {
+        expect_to_be_true(frame_pacer_wait(&pacer) == 0.0);
+    }
+    return true;
+}
+
+void frame_pacer_register_tests()
+{
+    test_manager_register_test(frame_pacer_holds_target_period, "Frame pacer holds the target period");
+    test_manager_register_test(frame_pacer_restarts_after_long_overrun, "Frame pacer restarts its schedule after a long overrun");
+    test_manager_register_test(frame_pacer_unpaced_does_not_wait, "Frame pacer does not wait without a target");
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+#include "game_module_tests.h"
+
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <core/game_module.h>
+#include <app_types.h>
+#include <platform/platform.h>
+#include <platform/filesystem.h>
+
+#include <string.h>
+
+// Not a library, so a reload gets as far as loading it and fails there.
+#define MODULE_TEST_PATH "./game_module_test.tmp"
+#define MODULE_TEST_COPY_PATH "./game_module_test.tmp.live0"
+
+static b8 write_module_file(const char* text)
+{
+    file_handle handle;
+    if(!filesystem_open(MODULE_TEST_PATH, FILE_MODE_WRITE, true, &handle))
+    {
+        return false;
+    }
+    u64 written = 0;
+    b8 result = filesystem_write(&handle, strlen(text), text, &written);
+    filesystem_close(&handle);
+    return result;
+}
+
+// Rewrites the file until its write time moves past previous, which takes as long as one
+// tick of the filesystem's clock.
+static b8 rewrite_module_file(const char* text, u64 previous, u64* out_time)
+{
+    for(u32 i = 0; i < 300; ++i)
+    {
+        platform_sleep(10);
+        if(!write_module_file(text) || !filesystem_last_write_time(MODULE_TEST_PATH, out_time))
+        {
+            return false;
+        }
+        if(*out_time != previous)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static b8 poll_now(game_module* module, app* app_instance)
+{
+    module->last_poll_time = platform_get_absolute_time() - GAME_MODULE_POLL_INTERVAL;
+    return game_module_reload_if_changed(module, app_instance);
+}
+
+u8 game_module_waits_for_write_time_to_settle()
+{
+    expect_to_be_true(write_module_file("build 1"));
+
+    // As game_module_load leaves it, without a library to load.
+    game_module module;
+    memset(&module, 0, sizeof(game_module));
+    strcpy(module.source_path, MODULE_TEST_PATH);
+    expect_to_be_true(filesystem_last_write_time(MODULE_TEST_PATH, &module.loaded_write_time));
+    u64 first_time = module.loaded_write_time;
+    app app_instance;
+    memset(&app_instance, 0, sizeof(app));
+
+    // Unchanged.
+    expect_to_be_false(poll_now(&module, &app_instance));
+    expect_should_be(0, module.pending_write_time);
+
+    // A new write is only noted at first.
+    u64 second_time = 0;
+    expect_to_be_true(rewrite_module_file("build 2", first_time, &second_time));
+    expect_to_be_false(poll_now(&module, &app_instance));
+    expect_should_be(second_time, module.pending_write_time);
+    expect_should_be(first_time, module.loaded_write_time);
+
+    // Written again before the next poll, so it is still being written.
+    u64 third_time = 0;
+    expect_to_be_true(rewrite_module_file("build 3", second_time, &third_time));
+    expect_to_be_false(poll_now(&module, &app_instance));
+    expect_should_be(third_time, module.pending_write_time);
+    expect_should_be(first_time, module.loaded_write_time);
+
+    // Between polls nothing is checked.
+    module.last_poll_time = platform_get_absolute_time();
+    expect_to_be_false(game_module_reload_if_changed(&module, &app_instance));
+    expect_should_be(third_time, module.pending_write_time);
+
+    // The same for a whole poll: it is reloaded, which fails for a plain file. The build isn't
+    // retried and its copy is cleaned up.
+    expect_to_be_false(poll_now(&module, &app_instance));
+    expect_should_be(0, module.pending_write_time);
+    expect_should_be(third_time, module.loaded_write_time);
+    expect_should_be(0, module.load_count);
+    expect_to_be_false(filesystem_exists(MODULE_TEST_COPY_PATH));
+    expect_to_be_false(poll_now(&module, &app_instance));
+    expect_should_be(0, module.pending_write_time);
+
+    // Missing while the build replaces it.
+    filesystem_delete(MODULE_TEST_PATH);
+    expect_to_be_false(poll_now(&module, &app_instance));
+    expect_should_be(0, module.pending_write_time);
+    return true;
+}
+
+void game_module_register_tests()
+{
+    test_manager_register_test(game_module_waits_for_write_time_to_settle, "Game module waits for the library's write time to settle");
+}
\ No newline at end of file
@@ -0,0 +1,174 @@
+#include "input_tests.h"
+
+#include "../test_manager.h"
+#include "../expect.h"
+#include "../test_system.h"
+
+#include <core/input.h>
+#include <platform/filesystem.h>
+
+static b8 initialize_input_system(u64* memory_requirement, void* state, void* config)
+{
+    input_system_initialize(memory_requirement, state);
+    return true;
+}
+
+u8 input_should_buffer_events_per_frame()
+{
+    test_system input;
+    expect_to_be_true(test_system_start(initialize_input_system, input_system_shutdown, 0, &input));
+
+    // A press and release within one frame are both kept, in order.
+    input_process_key(KEY_A, true);
+    input_process_mouse_move(10, 20);
+    input_process_key(KEY_A, false);
+    input_process_mouse_wheel(-1);
+
+    expect_should_be(4, input_event_count());
+    const input_event* e = input_event_get(0);
+    expect_should_be(INPUT_EVENT_KEY, e->type);
+    expect_should_be(KEY_A, e->code);
+    expect_to_be_true(e->pressed);
+
+    e = input_event_get(1);
+    expect_should_be(INPUT_EVENT_MOUSE_MOVE, e->type);
+    expect_should_be(10, e->x);
+    expect_should_be(20, e->y);
+
+    e = input_event_get(2);
+    expect_should_be(INPUT_EVENT_KEY, e->type);
+    expect_to_be_false(e->pressed);
+    expect_to_be_true(e->timestamp >= input_event_get(0)->timestamp);
+
+    e = input_event_get(3);
+    expect_should_be(INPUT_EVENT_MOUSE_WHEEL, e->type);
+    expect_should_be(-1, e->z_delta);
+
+    expect_should_be(0, input_event_get(4));
+
+    // A new frame starts empty.
+    input_update(0.0);
+    expect_should_be(0, input_event_count());
+    input_process_button(MOUSEBUTTON_LEFT, true);
+    expect_should_be(1, input_event_count());
+    expect_should_be(MOUSEBUTTON_LEFT, input_event_get(0)->code);
+
+    test_system_stop(&input);
+    return true;
+}
+
+u8 input_should_drop_oldest_when_full()
+{
+    test_system input;
+    expect_to_be_true(test_system_start(initialize_input_system, input_system_shutdown, 0, &input));
+
+    for(u32 i = 0; i < INPUT_EVENT_BUFFER_SIZE + 10; i++)
+    {
+        input_process_mouse_move((i16)i, 0);
+    }
+    expect_should_be(INPUT_EVENT_BUFFER_SIZE, input_event_count());
+    expect_should_be(10, input_event_get(0)->x);
+    expect_should_be(INPUT_EVENT_BUFFER_SIZE + 9, input_event_get(INPUT_EVENT_BUFFER_SIZE - 1)->x);
+
+    test_system_stop(&input);
+    return true;
+}
+
+u8 input_should_replay_recording()
+{
+    const char* path = "input_recording_test.bin";
+    test_system input;
+    expect_to_be_true(test_system_start(initialize_input_system, input_system_shutdown, 0, &input));
+
+    expect_to_be_true(input_record_start(path));
+    // Frame 0
+    input_process_key(KEY_W, true);
+    input_process_mouse_move(5, 6);
+    input_update(0.0);
+    // Frame 1 has no input.
+    input_update(0.0);
+    // Frame 2
+    input_process_key(KEY_W, false);
+    input_process_button(MOUSEBUTTON_RIGHT, true);
+    input_update(0.0);
+    input_record_stop();
+    test_system_stop(&input);
+
+    expect_to_be_true(test_system_start(initialize_input_system, input_system_shutdown, 0, &input));
+    expect_to_be_true(input_replay_start(path));
+    expect_to_be_true(input_replay_active());
+
+    // Live input is ignored while replaying.
+    input_process_key(KEY_Q, true);
+    expect_to_be_false(input_is_key_down(KEY_Q));
+
+    expect_to_be_true(input_replay_update());
+    expect_to_be_true(input_is_key_down(KEY_W));
+    i32 x, y;
+    input_get_mouse_pos(&x, &y);
+    expect_should_be(5, x);
+    expect_should_be(6, y);
+    input_update(0.0);
+
+    expect_to_be_true(input_replay_update());
+    expect_should_be(0, input_event_count());
+    input_update(0.0);
+
+    // The last records are applied and the replay ends.
+    expect_to_be_false(input_replay_update());
+    expect_to_be_false(input_is_key_down(KEY_W));
+    expect_to_be_true(input_is_button_down(MOUSEBUTTON_RIGHT));
+    expect_to_be_false(input_replay_active());
+
+    test_system_stop(&input);
+    filesystem_delete(path);
+    return true;
+}
+
+// Matches the layout of a recording written by input_record_start.
+typedef struct test_recording_record
+{
+    u32 frame;
+    u8 type;
+    u8 value;
+    u16 code;
+    i16 x;
+    i16 y;
+} test_recording_record;
+
+u8 input_should_skip_out_of_range_replay_codes()
+{
+    const char* path = "input_recording_bad_codes.bin";
+    u32 header[2] = {0x504E4944, 1};
+    test_recording_record records[3] = {
+        {0, INPUT_EVENT_KEY, 1, 300, 0, 0},
+        {0, INPUT_EVENT_BUTTON, 1, MOUSEBUTTONS_COUNT, 0, 0},
+        {0, INPUT_EVENT_KEY, 1, KEY_A, 0, 0}};
+    file_handle file;
+    u64 written = 0;
+    expect_to_be_true(filesystem_open(path, FILE_MODE_WRITE, true, &file));
+    expect_to_be_true(filesystem_write(&file, sizeof(header), header, &written));
+    expect_to_be_true(filesystem_write(&file, sizeof(records), records, &written));
+    filesystem_close(&file);
+
+    test_system input;
+    expect_to_be_true(test_system_start(initialize_input_system, input_system_shutdown, 0, &input));
+    expect_to_be_true(input_replay_start(path));
+
+    // Only the valid record is applied.
+    expect_to_be_false(input_replay_update());
+    expect_should_be(1, input_event_count());
+    expect_to_be_true(input_is_key_down(KEY_A));
+
+    test_system_stop(&input);
+    filesystem_delete(path);
+    return true;
+}
+
+void input_register_tests()
+{
+    test_manager_register_test(input_should_buffer_events_per_frame, "Input buffers raw events per frame");
+    test_manager_register_test(input_should_drop_oldest_when_full, "Input event buffer drops oldest when full");
+    test_manager_register_test(input_should_replay_recording, "Input replays a recording frame by frame");
+    test_manager_register_test(input_should_skip_out_of_range_replay_codes, "Input replay skips records with out-of-range codes");
+}
\ No newline at end of file
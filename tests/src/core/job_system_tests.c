@@ -0,0 +1,197 @@
+#include "job_system_tests.h"
+
+#include "../test_manager.h"
+#include "../expect.h"
+#include "../test_system.h"
+
+#include <core/job_system.h>
+#include <platform/thread.h>
+#include <platform/atomic.h>
+
+#define JOB_TEST_THREADS 3
+
+static b8 initialize_job_system(u64* memory_requirement, void* state, void* config)
+{
+    return job_system_initialize(memory_requirement, state, JOB_TEST_THREADS);
+}
+
+static void increment(void* params)
+{
+    datomic_fetch_add_u32((u32*)params, 1, DATOMIC_RELAXED);
+}
+
+u8 job_system_runs_every_job()
+{
+    test_system jobs;
+    expect_to_be_true(test_system_start(initialize_job_system, job_system_shutdown, 0, &jobs));
+    expect_should_be(JOB_TEST_THREADS, job_system_thread_count());
+
+    // More jobs than one deque holds, so some may overflow onto the submitting thread.
+    u32 total = 0;
+    job_counter counter = {0};
+    job_info info = {0};
+    info.entry = increment;
+    info.params = &total;
+    info.priority = JOB_PRIORITY_NORMAL;
+    info.counter = &counter;
+    for(u32 i = 0; i < 3000; i++)
+    {
+        expect_to_be_true(job_submit(&info));
+    }
+    job_wait(&counter);
+
+    expect_should_be(0, counter.value);
+    expect_should_be(3000, total);
+
+    test_system_stop(&jobs);
+    return true;
+}
+
+typedef struct completion_test_data
+{
+    u64 main_thread_id;
+    u32 completed;
+    u32 completed_off_main_thread;
+} completion_test_data;
+
+static void do_nothing(void* params)
+{
+}
+
+static void record_completion(void* params)
+{
+    completion_test_data* data = params;
+    data->completed++;
+    if(platform_thread_current_id() != data->main_thread_id)
+    {
+        data->completed_off_main_thread++;
+    }
+}
+
+u8 job_system_completions_run_on_main_thread()
+{
+    test_system jobs;
+    expect_to_be_true(test_system_start(initialize_job_system, job_system_shutdown, 0, &jobs));
+
+    completion_test_data data = {0};
+    data.main_thread_id = platform_thread_current_id();
+    job_counter counter = {0};
+    job_info info = {0};
+    info.entry = do_nothing;
+    info.on_complete = record_completion;
+    info.params = &data;
+    info.counter = &counter;
+    for(u32 i = 0; i < 100; i++)
+    {
+        job_submit(&info);
+    }
+    job_wait(&counter);
+
+    // Nothing runs until the main thread asks for it.
+    expect_should_be(0, data.completed);
+    job_system_update();
+    expect_should_be(100, data.completed);
+    expect_should_be(0, data.completed_off_main_thread);
+
+    test_system_stop(&jobs);
+    return true;
+}
+
+u8 job_system_refuses_completions_past_queue_size()
+{
+    test_system jobs;
+    expect_to_be_true(test_system_start(initialize_job_system, job_system_shutdown, 0, &jobs));
+
+    completion_test_data data = {0};
+    data.main_thread_id = platform_thread_current_id();
+    job_counter counter = {0};
+    job_info info = {0};
+    info.entry = do_nothing;
+    info.on_complete = record_completion;
+    info.params = &data;
+    info.counter = &counter;
+    // Without an update, submits are refused once the completion queue would be full.
+    u32 accepted = 0;
+    while(accepted < 100000 && job_submit(&info))
+    {
+        accepted++;
+    }
+    expect_to_be_true(accepted > 0);
+    expect_to_be_true(accepted < 100000);
+    job_wait(&counter);
+
+    job_system_update();
+    expect_should_be(accepted, data.completed);
+
+    // Room again once the completions have run.
+    expect_to_be_true(job_submit(&info));
+    job_wait(&counter);
+    job_system_update();
+    expect_should_be(accepted + 1, data.completed);
+
+    test_system_stop(&jobs);
+    return true;
+}
+
+typedef struct nested_test_data
+{
+    u32 children_done;
+    u32 parents_done;
+} nested_test_data;
+
+static void child_job(void* params)
+{
+    nested_test_data* data = params;
+    datomic_fetch_add_u32(&data->children_done, 1, DATOMIC_RELAXED);
+}
+
+static void parent_job(void* params)
+{
+    nested_test_data* data = params;
+    job_counter children = {0};
+    job_info info = {0};
+    info.entry = child_job;
+    info.params = data;
+    info.priority = JOB_PRIORITY_HIGH;
+    info.counter = &children;
+    for(u32 i = 0; i < 10; i++)
+    {
+        job_submit(&info);
+    }
+    // Runs other jobs, possibly other parents, instead of blocking the job thread.
+    job_wait(&children);
+    datomic_fetch_add_u32(&data->parents_done, 1, DATOMIC_RELAXED);
+}
+
+u8 job_system_jobs_can_wait_on_jobs()
+{
+    test_system jobs;
+    expect_to_be_true(test_system_start(initialize_job_system, job_system_shutdown, 0, &jobs));
+
+    nested_test_data data = {0};
+    job_counter counter = {0};
+    job_info info = {0};
+    info.entry = parent_job;
+    info.params = &data;
+    info.priority = JOB_PRIORITY_LOW;
+    info.counter = &counter;
+    for(u32 i = 0; i < 50; i++)
+    {
+        job_submit(&info);
+    }
+    job_wait(&counter);
+
+    expect_should_be(50, data.parents_done);
+    expect_should_be(500, data.children_done);
+
+    test_system_stop(&jobs);
+    return true;
+}
+
+void job_system_register_tests()
+{
+    test_manager_register_test(job_system_runs_every_job, "Job system runs every submitted job");
+    test_manager_register_test(job_system_completions_run_on_main_thread, "Job system runs completions on the main thread");
+    test_manager_register_test(job_system_refuses_completions_past_queue_size, "Job system refuses completions past its queue size");
+    test_manager_register_test(job_system_jobs_can_wait_on_jobs, "Job system jobs can submit and wait on jobs");
+}
\ No newline at end of file
@@ -0,0 +1,353 @@
+#include "logger_tests.h"
+
+#include "../test_manager.h"
+#include "../expect.h"
+#include "../test_system.h"
+
+#include <core/logger.h>
+#include <core/logger_binary.h>
+#include <core/dstring.h>
+#include <core/dmemory.h>
+#include <platform/filesystem.h>
+#include <platform/thread.h>
+#include <platform/platform.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#define LOG_FILE_PATH "console.log"
+
+static u64 encode(u8* dest, u64 capacity, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    u64 size = log_binary_encode(dest, capacity, LOG_LEVEL_INFO, 1.5, format, args);
+    va_end(args);
+    return size;
+}
+
+/**
+ * Encodes and decodes a message, and compares the result with vsnprintf of the same arguments.
+ */
+static b8 round_trips(const char* format, ...)
+{
+    char expected[512];
+    char actual[512];
+    u8 record[1024];
+
+    va_list args;
+    va_start(args, format);
+    va_list args_copy;
+    va_copy(args_copy, args);
+    vsnprintf(expected, sizeof(expected), format, args_copy);
+    va_end(args_copy);
+    u64 size = log_binary_encode(record, sizeof(record), LOG_LEVEL_WARN, 2.25, format, args);
+    va_end(args);
+
+    if(size == 0 || size % 8 != 0)
+    {
+        DERROR("Failed to encode '%s'.", format);
+        return false;
+    }
+    const log_binary_header* header = (const log_binary_header*)record;
+    u64 decoded_size = log_binary_decode(record, actual, sizeof(actual));
+    if(decoded_size != size || header->level != LOG_LEVEL_WARN || header->timestamp != 2.25 || header->format != format)
+    {
+        DERROR("Bad record header for '%s'.", format);
+        return false;
+    }
+    if(!strings_equal(expected, actual))
+    {
+        DERROR("'%s' decoded as '%s', expected '%s'.", format, actual, expected);
+        return false;
+    }
+    return true;
+}
+
+u8 logger_binary_round_trips_every_conversion()
+{
+    i32 local = 0;
+    expect_to_be_true(round_trips("no arguments, 100%% literal"));
+    expect_to_be_true(round_trips("%d %i %u", -42, 17, 4000000000u));
+    expect_to_be_true(round_trips("%o %x %X %#x", 8, 255, 255, 255));
+    expect_to_be_true(round_trips("%c%c", 'o', 'k'));
+    expect_to_be_true(round_trips("%lld %llu %llx", -1234567890123ll, 18446744073709551615ull, 0xDEADBEEFCAFEull));
+    expect_to_be_true(round_trips("%zu %ld %hd %hhu", (size_t)123456789, -5l, (short)-7, (unsigned char)200));
+    expect_to_be_true(round_trips("%f %F %.3f", 3.14159, -2.5, 1.0 / 3.0));
+    expect_to_be_true(round_trips("%e %E %g %G", 12345.678, 0.000123, 0.0001, 1e20));
+    expect_to_be_true(round_trips("%a %A", 1.0, -0.5));
+    expect_to_be_true(round_trips("%s and %s", "first", ""));
+    expect_to_be_true(round_trips("%-8s|%8s|%.2s", "left", "right", "cut"));
+    expect_to_be_true(round_trips("%p", (void*)&local));
+    expect_to_be_true(round_trips("%*d|%-*d|%.*f|%*.*f", 6, 42, 4, 7, 2, 3.14159, 9, 3, 2.71828));
+    expect_to_be_true(round_trips("%+d % d %05d %-5d|", 3, 3, 3, 3));
+    expect_to_be_true(round_trips("mixed %s=%d (%.1f%%) at %p", "count", 12, 99.5, (void*)0));
+    return true;
+}
+
+u8 logger_binary_handles_null_and_long_strings()
+{
+    u8 record[8192];
+    char message[8192];
+    expect_to_be_true(encode(record, sizeof(record), "[%s]", (const char*)0) != 0);
+    log_binary_decode(record, message, sizeof(message));
+    expect_to_be_true(strings_equal(message, "[(null)]"));
+
+    // Strings are truncated to 4095 characters.
+    char text[5000];
+    for(u32 i = 0; i < sizeof(text) - 1; ++i)
+    {
+        text[i] = (char)('a' + i % 26);
+    }
+    text[sizeof(text) - 1] = 0;
+    expect_to_be_true(encode(record, sizeof(record), "%s", text) != 0);
+    log_binary_decode(record, message, sizeof(message));
+    u64 length = string_length(message);
+    expect_should_be(4095, length);
+
+    // Output is cut to fit and still terminated.
+    expect_to_be_true(encode(record, sizeof(record), "%s %d", "abcdefghij", 12345) != 0);
+    log_binary_decode(record, message, 8);
+    expect_to_be_true(strings_equal(message, "abcdefg"));
+    return true;
+}
+
+u8 logger_binary_rejects_what_cannot_be_deferred()
+{
+    u8 record[256];
+    i32 count = 0;
+    long double value = 1.0L;
+    expect_should_be(0, encode(record, sizeof(record), "%n", &count));
+    expect_should_be(0, encode(record, sizeof(record), "%Lf", value));
+    expect_should_be(0, encode(record, sizeof(record), "%ls", L"wide"));
+    expect_should_be(0, encode(record, sizeof(record), "%q", 1));
+    // Too small for the header, then for the arguments.
+    expect_should_be(0, encode(record, 8, "plain"));
+    expect_should_be(0, encode(record, sizeof(log_binary_header) + 4, "%lld", 1ll));
+    return true;
+}
+
+static b8 initialize_logging_system(u64* memory_requirement, void* state, void* config)
+{
+    return initialize_logging(memory_requirement, state);
+}
+
+// Counts the occurrences of text in a file.
+static u32 count_in_file(const char* path, const char* text)
+{
+    file_mapping mapping;
+    if(!filesystem_map(path, FILE_ACCESS_SEQUENTIAL, &mapping) || !mapping.data)
+    {
+        return 0;
+    }
+    // The view isn't null-terminated; copy it.
+    u64 size = mapping.size;
+    char* contents = dallocate(size + 1, MEMORY_TAG_STRING);
+    dcopy_memory(contents, mapping.data, size);
+    contents[size] = 0;
+    filesystem_unmap(&mapping);
+
+    u32 count = 0;
+    for(const char* at = strstr(contents, text); at; at = strstr(at + 1, text))
+    {
+        count++;
+    }
+    dfree(contents, size + 1, MEMORY_TAG_STRING);
+    return count;
+}
+
+// Counts the occurrences of text in console.log.
+static u32 count_in_log(const char* text)
+{
+    return count_in_file(LOG_FILE_PATH, text);
+}
+
+static u32 log_from_thread(void* params)
+{
+    for(u32 i = 0; i < 100; ++i)
+    {
+        log_output(LOG_LEVEL_INFO, "record %u from thread %u", i, *(u32*)params);
+    }
+    return 0;
+}
+
+u8 logger_binary_records_from_other_threads_are_written()
+{
+    test_system logging;
+    expect_to_be_true(test_system_start(initialize_logging_system, shutdown_logging, 0, &logging));
+    log_set_mode(LOG_MODE_BINARY);
+
+    // One thread exits before the flush, the other after it.
+    u32 ids[2] = {1, 2};
+    platform_thread threads[2];
+    expect_to_be_true(platform_thread_create(log_from_thread, &ids[0], false, &threads[0]));
+    expect_to_be_true(platform_thread_join(&threads[0], 0));
+    expect_to_be_true(platform_thread_create(log_from_thread, &ids[1], false, &threads[1]));
+    log_flush();
+    expect_to_be_true(platform_thread_join(&threads[1], 0));
+    log_output(LOG_LEVEL_INFO, "record from the main thread");
+    test_system_stop(&logging);
+
+    u32 first = count_in_log("from thread 1\n");
+    u32 second = count_in_log("from thread 2\n");
+    u32 main = count_in_log("record from the main thread\n");
+    expect_should_be(100, first);
+    expect_should_be(100, second);
+    expect_should_be(1, main);
+    return true;
+}
+
+static u32 log_text_from_thread(void* params)
+{
+    for(u32 i = 0; i < 50; ++i)
+    {
+        log_output(LOG_LEVEL_INFO, "text line %02u from thread %u", i, *(u32*)params);
+    }
+    return 0;
+}
+
+u8 logger_lines_from_many_threads_stay_whole()
+{
+    test_system logging;
+    expect_to_be_true(test_system_start(initialize_logging_system, shutdown_logging, 0, &logging));
+    log_set_file_rotation(0, 0);
+
+    u32 ids[4] = {1, 2, 3, 4};
+    platform_thread threads[4];
+    for(u32 i = 0; i < 4; ++i)
+    {
+        expect_to_be_true(platform_thread_create(log_text_from_thread, &ids[i], false, &threads[i]));
+    }
+    for(u32 i = 0; i < 4; ++i)
+    {
+        expect_to_be_true(platform_thread_join(&threads[i], 0));
+    }
+    test_system_stop(&logging);
+
+    char line[64];
+    for(u32 t = 1; t <= 4; ++t)
+    {
+        for(u32 i = 0; i < 50; i += 7)
+        {
+            string_format(line, "[INFO]:  text line %02u from thread %u\n", i, t);
+            u32 count = count_in_log(line);
+            expect_should_be(1, count);
+        }
+    }
+    return true;
+}
+
+u8 logger_limited_keeps_to_budget()
+{
+    test_system logging;
+    expect_to_be_true(test_system_start(initialize_logging_system, shutdown_logging, 0, &logging));
+
+    for(u32 i = 0; i < 100; ++i)
+    {
+        log_output_limited(LOG_LEVEL_INFO, 42, 3, "limited message %u", i);
+    }
+    // Shutting down summarizes what is still inside its window.
+    test_system_stop(&logging);
+
+    u32 emitted = count_in_log("[INFO]:  limited message ");
+    u32 summaries = count_in_log("repeated 97 more times");
+    expect_should_be(3, emitted);
+    expect_should_be(1, summaries);
+    return true;
+}
+
+u8 logger_limited_finds_keys_past_removed_entries()
+{
+    test_system logging;
+    expect_to_be_true(test_system_start(initialize_logging_system, shutdown_logging, 0, &logging));
+
+    // Both keys start probing at the same slot, so the second is stored after the first.
+    u64 first = 5;
+    u64 second = 5 + 256;
+    log_output_limited(LOG_LEVEL_INFO, first, 1, "key one");
+    log_output_limited(LOG_LEVEL_INFO, first, 1, "key one");
+    platform_sleep(600);
+    log_output_limited(LOG_LEVEL_INFO, second, 1, "key two");
+    platform_sleep(500);
+    // The first key's window has ended: its summary is logged and its entry removed.
+    log_flush();
+    // Still inside the second key's window, so over budget.
+    log_output_limited(LOG_LEVEL_INFO, second, 1, "key two");
+    test_system_stop(&logging);
+
+    u32 first_count = count_in_log("[INFO]:  key one\n");
+    u32 second_count = count_in_log("[INFO]:  key two\n");
+    u32 summaries = count_in_log("repeated 1 more times");
+    expect_should_be(1, first_count);
+    expect_should_be(1, second_count);
+    expect_should_be(2, summaries);
+    return true;
+}
+
+u8 logger_rotation_shifts_and_drops_old_files()
+{
+    const char* paths[4] = {LOG_FILE_PATH, "console.1.log", "console.2.log", "console.3.log"};
+    for(u32 i = 1; i < 4; ++i)
+    {
+        filesystem_delete(paths[i]);
+    }
+
+    test_system logging;
+    expect_to_be_true(test_system_start(initialize_logging_system, shutdown_logging, 0, &logging));
+    // About four lines per file, so 20 lines rotate several times.
+    log_set_file_rotation(400, 2);
+    for(u32 i = 0; i < 20; ++i)
+    {
+        log_output(LOG_LEVEL_INFO, "rotation line %02u, padded out to fill the file a little faster than usual.", i);
+    }
+    test_system_stop(&logging);
+
+    // Only the retained files are kept.
+    expect_to_be_true(filesystem_exists(paths[1]));
+    expect_to_be_true(filesystem_exists(paths[2]));
+    expect_to_be_false(filesystem_exists(paths[3]));
+
+    // Each line is in at most one file, and each file holds later lines than the one after it.
+    i32 lowest[3] = {100, 100, 100};
+    i32 highest[3] = {-1, -1, -1};
+    char text[32];
+    for(u32 i = 0; i < 20; ++i)
+    {
+        string_format(text, "rotation line %02u,", i);
+        u32 found = 0;
+        for(u32 f = 0; f < 3; ++f)
+        {
+            if(count_in_file(paths[f], text) == 1)
+            {
+                found++;
+                lowest[f] = lowest[f] < (i32)i ? lowest[f] : (i32)i;
+                highest[f] = (i32)i;
+            }
+        }
+        expect_to_be_true(found <= 1);
+    }
+    expect_should_be(19, highest[0]);
+    expect_should_be(lowest[0] - 1, highest[1]);
+    expect_should_be(lowest[1] - 1, highest[2]);
+    // The oldest lines were in the file dropped beyond the limit.
+    expect_to_be_true(lowest[2] > 0);
+
+    for(u32 i = 1; i < 4; ++i)
+    {
+        filesystem_delete(paths[i]);
+    }
+    return true;
+}
+
+void logger_register_tests()
+{
+    test_manager_register_test(logger_binary_round_trips_every_conversion, "Logger: binary records round trip every conversion");
+    test_manager_register_test(logger_binary_handles_null_and_long_strings, "Logger: binary records handle null and long strings");
+    test_manager_register_test(logger_binary_rejects_what_cannot_be_deferred, "Logger: binary records reject conversions that can't be deferred");
+    test_manager_register_test(logger_binary_records_from_other_threads_are_written, "Logger: binary records from other threads are written");
+    test_manager_register_test(logger_lines_from_many_threads_stay_whole, "Logger: lines from many threads stay whole");
+    test_manager_register_test(logger_limited_keeps_to_budget, "Logger: limited messages keep to their budget");
+    test_manager_register_test(logger_limited_finds_keys_past_removed_entries, "Logger: limiter finds keys past removed entries");
+    test_manager_register_test(logger_rotation_shifts_and_drops_old_files, "Logger: rotation shifts old files and drops those past the limit");
+}
\ No newline at end of file
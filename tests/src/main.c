@@ -2,6 +2,18 @@
 #include <core/logger.h>
 
 #include "memory/linear_allocator_tests.h"
+#include "core/logger_tests.h"
+#include "containers/mpsc_queue_tests.h"
+#include "core/event_tests.h"
+#include "core/input_tests.h"
+#include "core/job_system_tests.h"
+#include "core/fiber_scheduler_tests.h"
+#include "core/frame_pacer_tests.h"
+#include "core/game_module_tests.h"
+#include "platform/thread_tests.h"
+#include "platform/ticks_tests.h"
+#include "platform/filesystem_tests.h"
+#include "platform/async_io_tests.h"
 
 int main()
 {
@@ -9,6 +21,18 @@ int main()
 
     // TODO: add test registration here.
     linear_allocator_register_tests();
+    logger_register_tests();
+    mpsc_queue_register_tests();
+    event_register_tests();
+    input_register_tests();
+    job_system_register_tests();
+    fiber_scheduler_register_tests();
+    frame_pacer_register_tests();
+    game_module_register_tests();
+    thread_register_tests();
+    ticks_register_tests();
+    filesystem_register_tests();
+    async_io_register_tests();
 
     DDEBUG("Starting tests...");
 
@@ -0,0 +1,194 @@
+#include "async_io_tests.h"
+
+#include "../test_manager.h"
+#include "../expect.h"
+#include "../test_system.h"
+
+#include <platform/async_io.h>
+#include <platform/filesystem.h>
+#include <core/dmemory.h>
+
+#define TEST_FILE_PATH "async_io_test.tmp"
+#define TEST_FILE_SIZE (256 * 1024)
+#define TEST_READ_SIZE 1024
+// 2048 pieces, twice the requests async I/O keeps in flight.
+#define TEST_PIECE_SIZE 128
+
+static b8 write_test_file()
+{
+    file_handle handle;
+    if(!filesystem_open(TEST_FILE_PATH, FILE_MODE_WRITE, true, &handle))
+    {
+        return false;
+    }
+    u8* data = dallocate(TEST_FILE_SIZE, MEMORY_TAG_APPLICATION);
+    for(u32 i = 0; i < TEST_FILE_SIZE; ++i)
+    {
+        data[i] = (u8)(i * 13 + (i >> 8));
+    }
+    u64 written = 0;
+    b8 result = filesystem_write(&handle, TEST_FILE_SIZE, data, &written);
+    filesystem_close(&handle);
+    dfree(data, TEST_FILE_SIZE, MEMORY_TAG_APPLICATION);
+    return result && written == TEST_FILE_SIZE;
+}
+
+// config points at allow_io_uring.
+static b8 initialize_async_io(u64* memory_requirement, void* state, void* config)
+{
+    return async_io_initialize(memory_requirement, state, *(b8*)config);
+}
+
+typedef struct read_result
+{
+    u32 calls;
+    b8 succeeded;
+    u64 bytes_read;
+} read_result;
+
+static void on_read_complete(void* params, b8 succeeded, u64 bytes_read)
+{
+    read_result* result = params;
+    result->calls++;
+    result->succeeded = succeeded;
+    result->bytes_read = bytes_read;
+}
+
+// Reads the whole file in pieces, more of them than the requests that fit in flight at once.
+// Half the reads have callbacks, whose requests are only freed by async_io_update, so the
+// submits have to make room by running it.
+static b8 reads_whole_file(b8 allow_io_uring)
+{
+    if(!write_test_file())
+    {
+        return false;
+    }
+    test_system io;
+    if(!test_system_start(initialize_async_io, async_io_shutdown, &allow_io_uring, &io))
+    {
+        return false;
+    }
+
+    async_file file;
+    u64 size = 0;
+    b8 result = async_io_open(TEST_FILE_PATH, &file, &size) && size == TEST_FILE_SIZE;
+    u8* buffer = dallocate(TEST_FILE_SIZE, MEMORY_TAG_APPLICATION);
+    // Read twice, the second time in reverse, so requests get reused.
+    for(u32 pass = 0; result && pass < 2; ++pass)
+    {
+        dzero_memory(buffer, TEST_FILE_SIZE);
+        job_counter counter = {0};
+        read_result callbacks = {0};
+        async_read reads[16];
+        u32 read_count = TEST_FILE_SIZE / TEST_PIECE_SIZE;
+        for(u32 i = 0; result && i < read_count; i += 16)
+        {
+            for(u32 r = 0; r < 16; ++r)
+            {
+                u32 piece = pass == 0 ? i + r : read_count - 1 - (i + r);
+                dzero_memory(&reads[r], sizeof(async_read));
+                reads[r].file = file;
+                reads[r].offset = (u64)piece * TEST_PIECE_SIZE;
+                reads[r].size = TEST_PIECE_SIZE;
+                reads[r].buffer = buffer + reads[r].offset;
+                reads[r].counter = &counter;
+                if(piece % 2 == 0)
+                {
+                    reads[r].on_complete = on_read_complete;
+                    reads[r].params = &callbacks;
+                }
+            }
+            result = async_io_submit(reads, 16);
+        }
+        job_wait(&counter);
+        async_io_update();
+        result = result && callbacks.calls == read_count / 2;
+
+        for(u32 i = 0; result && i < TEST_FILE_SIZE; ++i)
+        {
+            result = buffer[i] == (u8)(i * 13 + (i >> 8));
+        }
+    }
+    dfree(buffer, TEST_FILE_SIZE, MEMORY_TAG_APPLICATION);
+    async_io_close(&file);
+
+    test_system_stop(&io);
+    filesystem_delete(TEST_FILE_PATH);
+    return result;
+}
+
+u8 async_io_reads_whole_file()
+{
+    expect_to_be_true(reads_whole_file(true));
+    return true;
+}
+
+u8 async_io_thread_pool_reads_whole_file()
+{
+    expect_to_be_true(reads_whole_file(false));
+    return true;
+}
+
+u8 async_io_callbacks_run_on_update()
+{
+    expect_to_be_true(write_test_file());
+    test_system io;
+    b8 allow_io_uring = true;
+    expect_to_be_true(test_system_start(initialize_async_io, async_io_shutdown, &allow_io_uring, &io));
+
+    async_file file;
+    expect_to_be_true(async_io_open(TEST_FILE_PATH, &file, 0));
+
+    u8 head[100];
+    u8 tail[TEST_READ_SIZE];
+    read_result results[2];
+    dzero_memory(results, sizeof(results));
+    job_counter counter = {0};
+    async_read reads[2];
+    dzero_memory(reads, sizeof(reads));
+    reads[0].file = file;
+    reads[0].size = sizeof(head);
+    reads[0].buffer = head;
+    reads[0].on_complete = on_read_complete;
+    reads[0].params = &results[0];
+    reads[0].counter = &counter;
+    // Runs past the end of the file, so only half of it is read.
+    reads[1] = reads[0];
+    reads[1].offset = TEST_FILE_SIZE - TEST_READ_SIZE / 2;
+    reads[1].size = sizeof(tail);
+    reads[1].buffer = tail;
+    reads[1].params = &results[1];
+    expect_to_be_true(async_io_submit(reads, 2));
+
+    job_wait(&counter);
+    // Finished, but the callbacks wait for the update.
+    expect_should_be(0, results[0].calls);
+    expect_should_be(0, results[1].calls);
+
+    async_io_update();
+    expect_should_be(1, results[0].calls);
+    expect_to_be_true(results[0].succeeded);
+    expect_should_be(sizeof(head), results[0].bytes_read);
+    expect_should_be(1, results[1].calls);
+    expect_to_be_false(results[1].succeeded);
+    expect_should_be(TEST_READ_SIZE / 2, results[1].bytes_read);
+    expect_should_be(head[99], (u8)(99 * 13));
+    u32 last = TEST_FILE_SIZE - 1;
+    u8 expected_last = (u8)(last * 13 + (last >> 8));
+    expect_should_be(expected_last, tail[TEST_READ_SIZE / 2 - 1]);
+
+    async_io_update();
+    expect_should_be(1, results[0].calls);
+
+    async_io_close(&file);
+    test_system_stop(&io);
+    filesystem_delete(TEST_FILE_PATH);
+    return true;
+}
+
+void async_io_register_tests()
+{
+    test_manager_register_test(async_io_reads_whole_file, "Async I/O reads a whole file");
+    test_manager_register_test(async_io_thread_pool_reads_whole_file, "Async I/O thread pool reads a whole file");
+    test_manager_register_test(async_io_callbacks_run_on_update, "Async I/O runs callbacks on update, with short reads at the end of a file");
+}
\ No newline at end of file
@@ -0,0 +1,3 @@
+#include <defines.h>
+
+void async_io_register_tests();
\ No newline at end of file
@@ -0,0 +1,246 @@
+#include "filesystem_tests.h"
+
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <platform/filesystem.h>
+#include <core/dmemory.h>
+#include <core/dstring.h>
+#include <platform/platform.h>
+
+#define TEST_FILE_PATH "filesystem_test.tmp"
+#define TEST_COPY_PATH "filesystem_test_copy.tmp"
+
+static b8 write_test_file(const void* data, u64 size)
+{
+    file_handle handle;
+    if(!filesystem_open(TEST_FILE_PATH, FILE_MODE_WRITE, true, &handle))
+    {
+        return false;
+    }
+    u64 written = 0;
+    b8 result = size == 0 || filesystem_write(&handle, size, data, &written);
+    filesystem_close(&handle);
+    return result && written == size;
+}
+
+u8 filesystem_map_views_file_contents()
+{
+    u8 data[10000];
+    for(u32 i = 0; i < sizeof(data); ++i)
+    {
+        data[i] = (u8)(i * 7);
+    }
+    expect_to_be_true(write_test_file(data, sizeof(data)));
+
+    file_access_pattern patterns[] = {FILE_ACCESS_NORMAL, FILE_ACCESS_SEQUENTIAL, FILE_ACCESS_RANDOM};
+    for(u32 p = 0; p < 3; ++p)
+    {
+        file_mapping mapping;
+        expect_to_be_true(filesystem_map(TEST_FILE_PATH, patterns[p], &mapping));
+        expect_should_be(sizeof(data), mapping.size);
+        const u8* bytes = mapping.data;
+        b8 same = true;
+        for(u32 i = 0; i < sizeof(data); ++i)
+        {
+            same = same && bytes[i] == data[i];
+        }
+        expect_to_be_true(same);
+
+        filesystem_unmap(&mapping);
+        expect_should_be(0, mapping.size);
+        expect_should_be(0, mapping.data);
+    }
+
+    filesystem_delete(TEST_FILE_PATH);
+    return true;
+}
+
+u8 filesystem_map_handles_empty_and_missing_files()
+{
+    expect_to_be_true(write_test_file(0, 0));
+    file_mapping mapping;
+    expect_to_be_true(filesystem_map(TEST_FILE_PATH, FILE_ACCESS_NORMAL, &mapping));
+    expect_should_be(0, mapping.size);
+    expect_should_be(0, mapping.data);
+    filesystem_unmap(&mapping);
+    filesystem_delete(TEST_FILE_PATH);
+
+    expect_to_be_false(filesystem_map(TEST_FILE_PATH, FILE_ACCESS_NORMAL, &mapping));
+    expect_should_be(0, mapping.data);
+    return true;
+}
+
+u8 filesystem_read_line_terminates_line()
+{
+    const char text[] = "first line\nsecond\n";
+    expect_to_be_true(write_test_file(text, sizeof(text) - 1));
+
+    file_handle handle;
+    expect_to_be_true(filesystem_open(TEST_FILE_PATH, FILE_MODE_READ, false, &handle));
+    char* line = 0;
+    expect_to_be_true(filesystem_read_line(&handle, &line));
+    expect_to_be_true(strings_equal(line, "first line\n"));
+    u64 length = string_length(line);
+    dfree(line, length + 1, MEMORY_TAG_STRING);
+    filesystem_close(&handle);
+
+    filesystem_delete(TEST_FILE_PATH);
+    return true;
+}
+
+u8 filesystem_line_reader_splits_lines()
+{
+    // Chunks of 8 bytes, so lines span chunks and one outgrows the buffer.
+    const char text[] = "one\r\ntwo\n\na line longer than a chunk\nlast";
+    const char* expected[] = {"one", "two", "", "a line longer than a chunk", "last"};
+    expect_to_be_true(write_test_file(text, sizeof(text) - 1));
+
+    file_handle handle;
+    expect_to_be_true(filesystem_open(TEST_FILE_PATH, FILE_MODE_READ, true, &handle));
+    file_line_reader reader;
+    expect_to_be_true(filesystem_line_reader_create(&handle, 8, &reader));
+    file_line line;
+    for(u32 i = 0; i < 5; ++i)
+    {
+        expect_to_be_true(filesystem_line_reader_next(&reader, &line));
+        u64 expected_length = string_length(expected[i]);
+        expect_should_be(expected_length, line.length);
+        expect_to_be_true(strings_equal(line.data, expected[i]));
+    }
+    expect_to_be_false(filesystem_line_reader_next(&reader, &line));
+    expect_to_be_false(filesystem_line_reader_next(&reader, &line));
+    filesystem_line_reader_destroy(&reader);
+    filesystem_close(&handle);
+
+    filesystem_delete(TEST_FILE_PATH);
+    return true;
+}
+
+u8 filesystem_line_reader_reads_many_lines()
+{
+    // Lines of every length up to 300 bytes, through the default chunk size and a small one.
+    const u32 line_count = 300;
+    u64 size = (u64)line_count * (line_count + 1) / 2;
+    char* text = dallocate(size, MEMORY_TAG_STRING);
+    u64 offset = 0;
+    for(u32 i = 0; i < line_count; ++i)
+    {
+        for(u32 c = 0; c < i; ++c)
+        {
+            text[offset++] = (char)('a' + (i + c) % 26);
+        }
+        text[offset++] = '\n';
+    }
+    expect_to_be_true(write_test_file(text, size));
+    dfree(text, size, MEMORY_TAG_STRING);
+
+    u64 chunk_sizes[] = {0, 100};
+    for(u32 s = 0; s < 2; ++s)
+    {
+        file_handle handle;
+        expect_to_be_true(filesystem_open(TEST_FILE_PATH, FILE_MODE_READ, true, &handle));
+        file_line_reader reader;
+        expect_to_be_true(filesystem_line_reader_create(&handle, chunk_sizes[s], &reader));
+        file_line line;
+        b8 same = true;
+        u32 lines = 0;
+        while(filesystem_line_reader_next(&reader, &line))
+        {
+            same = same && line.length == lines && line.data[line.length] == 0;
+            for(u32 c = 0; same && c < line.length; ++c)
+            {
+                same = line.data[c] == (char)('a' + (lines + c) % 26);
+            }
+            lines++;
+        }
+        expect_to_be_true(same);
+        expect_should_be(line_count, lines);
+        filesystem_line_reader_destroy(&reader);
+        filesystem_close(&handle);
+    }
+
+    filesystem_delete(TEST_FILE_PATH);
+    return true;
+}
+
+static b8 files_match(const char* path, const u8* data, u64 size)
+{
+    file_mapping mapping;
+    if(!filesystem_map(path, FILE_ACCESS_SEQUENTIAL, &mapping))
+    {
+        return false;
+    }
+    b8 same = mapping.size == size;
+    const u8* bytes = mapping.data;
+    for(u64 i = 0; same && i < size; ++i)
+    {
+        same = bytes[i] == data[i];
+    }
+    filesystem_unmap(&mapping);
+    return same;
+}
+
+u8 filesystem_copy_replaces_destination()
+{
+    // Larger than the copy's chunk, and not a multiple of it.
+    u64 size = 150000;
+    u8* data = dallocate(size, MEMORY_TAG_ARRAY);
+    for(u64 i = 0; i < size; ++i)
+    {
+        data[i] = (u8)(i * 13);
+    }
+    expect_to_be_true(write_test_file(data, size));
+
+    expect_to_be_true(filesystem_copy(TEST_FILE_PATH, TEST_COPY_PATH));
+    expect_to_be_true(files_match(TEST_COPY_PATH, data, size));
+
+    // A shorter source leaves nothing of the longer file behind.
+    expect_to_be_true(write_test_file(data, 100));
+    expect_to_be_true(filesystem_copy(TEST_FILE_PATH, TEST_COPY_PATH));
+    expect_to_be_true(files_match(TEST_COPY_PATH, data, 100));
+    dfree(data, size, MEMORY_TAG_ARRAY);
+
+    filesystem_delete(TEST_FILE_PATH);
+    filesystem_delete(TEST_COPY_PATH);
+    expect_to_be_false(filesystem_copy(TEST_FILE_PATH, TEST_COPY_PATH));
+    expect_to_be_false(filesystem_exists(TEST_COPY_PATH));
+    return true;
+}
+
+u8 filesystem_last_write_time_changes_on_write()
+{
+    u64 first = 0;
+    expect_to_be_false(filesystem_last_write_time(TEST_FILE_PATH, &first));
+
+    const char text[] = "first";
+    expect_to_be_true(write_test_file(text, sizeof(text) - 1));
+    expect_to_be_true(filesystem_last_write_time(TEST_FILE_PATH, &first));
+    u64 same = 0;
+    expect_to_be_true(filesystem_last_write_time(TEST_FILE_PATH, &same));
+    expect_should_be(first, same);
+
+    // Write times are only as fine as the filesystem's clock, so rewrite until it ticks over.
+    u64 second = first;
+    for(u32 i = 0; i < 300 && second == first; ++i)
+    {
+        platform_sleep(10);
+        expect_to_be_true(write_test_file(text, sizeof(text) - 1));
+        expect_to_be_true(filesystem_last_write_time(TEST_FILE_PATH, &second));
+    }
+    expect_to_be_true(second > first);
+
+    filesystem_delete(TEST_FILE_PATH);
+    return true;
+}
+
+void filesystem_register_tests()
+{
+    test_manager_register_test(filesystem_map_views_file_contents, "Filesystem: map views file contents");
+    test_manager_register_test(filesystem_map_handles_empty_and_missing_files, "Filesystem: map handles empty and missing files");
+    test_manager_register_test(filesystem_read_line_terminates_line, "Filesystem: read line terminates the line");
+    test_manager_register_test(filesystem_line_reader_splits_lines, "Filesystem: line reader splits lines across chunks");
+    test_manager_register_test(filesystem_line_reader_reads_many_lines, "Filesystem: line reader reads many lines");
+    test_manager_register_test(filesystem_copy_replaces_destination, "Filesystem: copy replaces the destination");
+    test_manager_register_test(filesystem_last_write_time_changes_on_write, "Filesystem: last write time changes on write");
+}
\ No newline at end of file
@@ -0,0 +1,239 @@
+#include "thread_tests.h"
+
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <platform/thread.h>
+#include <platform/atomic.h>
+
+#define THREAD_TEST_WORKERS 4
+#define THREAD_TEST_INCREMENTS 10000
+
+typedef struct counter_test_data
+{
+    platform_mutex mutex;
+    u64 locked_count;
+    u64 atomic_count;
+} counter_test_data;
+
+static u32 increment_counters(void* params)
+{
+    counter_test_data* data = params;
+    for(u32 i = 0; i < THREAD_TEST_INCREMENTS; i++)
+    {
+        platform_mutex_lock(&data->mutex);
+        data->locked_count++;
+        platform_mutex_unlock(&data->mutex);
+
+        datomic_fetch_add_u64(&data->atomic_count, 1, DATOMIC_RELAXED);
+    }
+    return 7;
+}
+
+u8 thread_mutex_and_atomics_count_every_increment()
+{
+    counter_test_data data = {};
+    expect_to_be_true(platform_mutex_create(&data.mutex));
+
+    platform_thread threads[THREAD_TEST_WORKERS];
+    for(u32 i = 0; i < THREAD_TEST_WORKERS; i++)
+    {
+        expect_to_be_true(platform_thread_create(increment_counters, &data, false, &threads[i]));
+        expect_should_not_be(0, threads[i].thread_id);
+        expect_should_not_be(platform_thread_current_id(), threads[i].thread_id);
+    }
+    for(u32 i = 0; i < THREAD_TEST_WORKERS; i++)
+    {
+        u32 exit_code = 0;
+        expect_to_be_true(platform_thread_join(&threads[i], &exit_code));
+        expect_should_be(7, exit_code);
+    }
+
+    expect_should_be(THREAD_TEST_WORKERS * THREAD_TEST_INCREMENTS, data.locked_count);
+    expect_should_be(THREAD_TEST_WORKERS * THREAD_TEST_INCREMENTS, data.atomic_count);
+
+    // try_lock succeeds when free and fails while held.
+    expect_to_be_true(platform_mutex_try_lock(&data.mutex));
+    expect_to_be_false(platform_mutex_try_lock(&data.mutex));
+    platform_mutex_unlock(&data.mutex);
+
+    platform_mutex_destroy(&data.mutex);
+    return true;
+}
+
+typedef struct semaphore_test_data
+{
+    platform_semaphore semaphore;
+    u32 signal_count;
+} semaphore_test_data;
+
+static u32 signal_semaphore(void* params)
+{
+    semaphore_test_data* data = params;
+    platform_thread_set_name("dubhe-test");
+    for(u32 i = 0; i < data->signal_count; i++)
+    {
+        platform_semaphore_signal(&data->semaphore, 1);
+    }
+    return 0;
+}
+
+u8 thread_semaphore_counts_signals()
+{
+    semaphore_test_data data;
+    data.signal_count = 100;
+    expect_to_be_true(platform_semaphore_create(0, 1000, &data.semaphore));
+
+    // Nothing signalled yet.
+    expect_to_be_false(platform_semaphore_wait_timeout(&data.semaphore, 0));
+
+    platform_thread thread;
+    expect_to_be_true(platform_thread_create(signal_semaphore, &data, false, &thread));
+    for(u32 i = 0; i < data.signal_count; i++)
+    {
+        platform_semaphore_wait(&data.semaphore);
+    }
+    expect_to_be_true(platform_thread_join(&thread, 0));
+
+    // Every signal was consumed exactly once.
+    expect_to_be_false(platform_semaphore_wait_timeout(&data.semaphore, 1));
+
+    platform_semaphore_signal(&data.semaphore, 2);
+    expect_to_be_true(platform_semaphore_wait_timeout(&data.semaphore, 0));
+    expect_to_be_true(platform_semaphore_wait_timeout(&data.semaphore, 0));
+
+    platform_semaphore_destroy(&data.semaphore);
+    return true;
+}
+
+u8 thread_semaphore_stops_at_max_count()
+{
+    platform_semaphore semaphore;
+    expect_to_be_true(platform_semaphore_create(0, 2, &semaphore));
+
+    // Only two of the five fit.
+    platform_semaphore_signal(&semaphore, 5);
+    expect_to_be_true(platform_semaphore_wait_timeout(&semaphore, 0));
+    expect_to_be_true(platform_semaphore_wait_timeout(&semaphore, 0));
+    expect_to_be_false(platform_semaphore_wait_timeout(&semaphore, 0));
+
+    // Signals one at a time are dropped past the maximum too.
+    for(u32 i = 0; i < 4; i++)
+    {
+        platform_semaphore_signal(&semaphore, 1);
+    }
+    expect_to_be_true(platform_semaphore_wait_timeout(&semaphore, 0));
+    expect_to_be_true(platform_semaphore_wait_timeout(&semaphore, 0));
+    expect_to_be_false(platform_semaphore_wait_timeout(&semaphore, 0));
+
+    platform_semaphore_destroy(&semaphore);
+    return true;
+}
+
+typedef struct condition_test_data
+{
+    platform_mutex mutex;
+    platform_condition condition;
+    b8 ready;
+} condition_test_data;
+
+static u32 set_ready(void* params)
+{
+    condition_test_data* data = params;
+    platform_mutex_lock(&data->mutex);
+    data->ready = true;
+    platform_condition_signal(&data->condition);
+    platform_mutex_unlock(&data->mutex);
+    return 0;
+}
+
+u8 thread_condition_wakes_waiter()
+{
+    condition_test_data data = {};
+    expect_to_be_true(platform_mutex_create(&data.mutex));
+    expect_to_be_true(platform_condition_create(&data.condition));
+
+    platform_mutex_lock(&data.mutex);
+    // Nobody signals this one.
+    expect_to_be_false(platform_condition_wait_timeout(&data.condition, &data.mutex, 1));
+
+    platform_thread thread;
+    expect_to_be_true(platform_thread_create(set_ready, &data, false, &thread));
+    while(!data.ready)
+    {
+        platform_condition_wait(&data.condition, &data.mutex);
+    }
+    platform_mutex_unlock(&data.mutex);
+    expect_to_be_true(platform_thread_join(&thread, 0));
+
+    platform_condition_destroy(&data.condition);
+    platform_mutex_destroy(&data.mutex);
+    return true;
+}
+
+u8 thread_cpu_topology_is_consistent()
+{
+    platform_cpu_topology topology;
+    platform_get_cpu_topology(&topology);
+
+    expect_to_be_true(topology.logical_processor_count > 0);
+    expect_to_be_true(topology.physical_core_count > 0);
+    expect_to_be_true(topology.physical_core_count <= topology.logical_processor_count);
+    expect_to_be_true(topology.numa_node_count > 0);
+    expect_to_be_true(topology.cache_line_size > 0);
+
+    // Every core has exactly one first hardware thread.
+    u32 first_threads = 0;
+    for(u32 i = 0; i < topology.logical_processor_count; ++i)
+    {
+        platform_logical_processor* processor = &topology.processors[i];
+        expect_to_be_true(processor->core < topology.physical_core_count);
+        expect_to_be_true(processor->numa_node < topology.numa_node_count);
+        if(processor->smt_index == 0)
+        {
+            first_threads++;
+        }
+    }
+    expect_should_be(topology.physical_core_count, first_threads);
+    return true;
+}
+
+static u32 pin_to_current_processor(void* params)
+{
+    u32 processor = platform_thread_current_processor();
+    if(!platform_thread_set_affinity(&processor, 1))
+    {
+        return 0;
+    }
+    // Pinned, so the thread can't have moved since.
+    for(u32 i = 0; i < 100; ++i)
+    {
+        platform_thread_yield();
+        if(platform_thread_current_processor() != processor)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+u8 thread_affinity_pins_thread()
+{
+    // On a thread of its own, so the test runner's affinity is left alone.
+    platform_thread thread;
+    u32 exit_code = 0;
+    expect_to_be_true(platform_thread_create(pin_to_current_processor, 0, false, &thread));
+    expect_to_be_true(platform_thread_join(&thread, &exit_code));
+    expect_should_be(1, exit_code);
+    return true;
+}
+
+void thread_register_tests()
+{
+    test_manager_register_test(thread_mutex_and_atomics_count_every_increment, "Threads: mutex and atomics count every increment");
+    test_manager_register_test(thread_semaphore_counts_signals, "Threads: semaphore counts signals");
+    test_manager_register_test(thread_semaphore_stops_at_max_count, "Threads: semaphore stops at its max count");
+    test_manager_register_test(thread_condition_wakes_waiter, "Threads: condition variable wakes waiter");
+    test_manager_register_test(thread_cpu_topology_is_consistent, "Threads: CPU topology is consistent");
+    test_manager_register_test(thread_affinity_pins_thread, "Threads: affinity pins a thread to a processor");
+}
\ No newline at end of file
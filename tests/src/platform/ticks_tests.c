@@ -0,0 +1,47 @@
+#include "ticks_tests.h"
+
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <platform/platform.h>
+#include <platform/thread.h>
+
+u8 ticks_are_monotonic()
+{
+    expect_to_be_true(platform_get_tick_frequency() > 0);
+
+    u64 previous = platform_get_ticks();
+    for(u32 i = 0; i < 10000; ++i)
+    {
+        u64 now = platform_get_ticks();
+        expect_to_be_true(now >= previous);
+        previous = now;
+    }
+    return true;
+}
+
+u8 ticks_convert_to_nanoseconds()
+{
+    u64 frequency = platform_get_tick_frequency();
+    u64 one_second = platform_ticks_to_ns(frequency);
+    expect_should_be(1000000000, one_second);
+
+    // A semaphore nobody signals makes a sleep of at least the timeout.
+    platform_semaphore semaphore;
+    expect_to_be_true(platform_semaphore_create(0, 1, &semaphore));
+    u64 start = platform_get_ticks();
+    platform_semaphore_wait_timeout(&semaphore, 20);
+    u64 elapsed_ns = platform_ticks_to_ns(platform_get_ticks() - start);
+    platform_semaphore_destroy(&semaphore);
+
+    // Allow for timer slack below and a loaded machine above.
+    expect_to_be_true(elapsed_ns >= 19 * 1000 * 1000);
+    expect_to_be_true(elapsed_ns < 1000 * 1000 * 1000);
+    return true;
+}
+
+void ticks_register_tests()
+{
+    test_manager_register_test(ticks_are_monotonic, "Ticks: never go backwards");
+    test_manager_register_test(ticks_convert_to_nanoseconds, "Ticks: convert to nanoseconds");
+}
\ No newline at end of file
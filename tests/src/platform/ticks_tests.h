@@ -0,0 +1,3 @@
+#include <defines.h>
+
+void ticks_register_tests();
\ No newline at end of file
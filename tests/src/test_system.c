@@ -0,0 +1,26 @@
+#include "test_system.h"
+
+#include <core/dmemory.h>
+
+b8 test_system_start(PFN_test_system_initialize initialize, PFN_test_system_shutdown shutdown, void* config, test_system* out_system)
+{
+    out_system->memory_requirement = 0;
+    out_system->state = 0;
+    out_system->shutdown = shutdown;
+    initialize(&out_system->memory_requirement, 0, config);
+    out_system->state = dallocate(out_system->memory_requirement, MEMORY_TAG_APPLICATION);
+    if(!initialize(&out_system->memory_requirement, out_system->state, config))
+    {
+        dfree(out_system->state, out_system->memory_requirement, MEMORY_TAG_APPLICATION);
+        out_system->state = 0;
+        return false;
+    }
+    return true;
+}
+
+void test_system_stop(test_system* system)
+{
+    system->shutdown(system->state);
+    dfree(system->state, system->memory_requirement, MEMORY_TAG_APPLICATION);
+    system->state = 0;
+}
\ No newline at end of file
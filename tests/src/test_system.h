@@ -0,0 +1,33 @@
+#pragma once
+
+#include <defines.h>
+
+/**
+ * @brief Initializes a system with the engine's two-call pattern. Extra arguments go through
+ * config.
+ */
+typedef b8 (*PFN_test_system_initialize)(u64* memory_requirement, void* state, void* config);
+
+typedef void (*PFN_test_system_shutdown)(void* state);
+
+/**
+ * @brief A system started for a test, with the size its state was allocated at.
+ */
+typedef struct test_system
+{
+    u64 memory_requirement;
+    void* state;
+    PFN_test_system_shutdown shutdown;
+} test_system;
+
+/**
+ * @brief Allocates a system's state and initializes it.
+ *
+ * @returns True on success; otherwise false, with nothing left allocated.
+ */
+b8 test_system_start(PFN_test_system_initialize initialize, PFN_test_system_shutdown shutdown, void* config, test_system* out_system);
+
+/**
+ * @brief Shuts a started system down and frees its state.
+ */
+void test_system_stop(test_system* system);
\ No newline at end of file